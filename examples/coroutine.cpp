@@ -0,0 +1,168 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+
+#include <nop/utility/coroutine.h>
+
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <coroutine>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/utility/die.h>
+
+using nop::AsyncDeserializer;
+using nop::AsyncSerializer;
+using nop::IoWaiter;
+
+//
+// Example of coroutines exchanging messages over a non-blocking socket pair on
+// a single thread. The messages are larger than the socket buffers, so both
+// the writer and the reader are suspended several times per message.
+//
+
+namespace {
+
+auto Die(const char* error_message = "Error") {
+  return nop::Die(std::cerr, error_message);
+}
+
+// Minimal poll() based scheduler that notifies waiters when their file
+// descriptors become ready.
+class PollScheduler {
+ public:
+  void WaitReadable(int fd, IoWaiter* waiter) {
+    waiters_.push_back({fd, POLLIN, waiter});
+  }
+  void WaitWritable(int fd, IoWaiter* waiter) {
+    waiters_.push_back({fd, POLLOUT, waiter});
+  }
+
+  // Runs until there are no more waiters.
+  void Run() {
+    while (!waiters_.empty()) {
+      std::vector<pollfd> fds;
+      for (const auto& waiter : waiters_)
+        fds.push_back({waiter.fd, waiter.events, 0});
+
+      if (poll(fds.data(), fds.size(), -1) < 0)
+        return;
+
+      std::vector<Waiter> waiters;
+      waiters.swap(waiters_);
+      for (std::size_t i = 0; i < waiters.size(); i++) {
+        if (fds[i].revents)
+          waiters[i].waiter->Notify();
+        else
+          waiters_.push_back(waiters[i]);
+      }
+    }
+  }
+
+ private:
+  struct Waiter {
+    int fd;
+    short events;
+    IoWaiter* waiter;
+  };
+
+  std::vector<Waiter> waiters_;
+};
+
+// Coroutine type that starts immediately and is not awaited.
+struct Task {
+  struct promise_type {
+    Task get_return_object() { return {}; }
+    std::suspend_never initial_suspend() { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+struct Message {
+  std::uint32_t sequence;
+  std::vector<std::string> lines;
+  NOP_STRUCTURE(Message, sequence, lines);
+};
+
+constexpr std::uint32_t kMessageCount = 4;
+
+Message MakeMessage(std::uint32_t sequence) {
+  return {sequence, std::vector<std::string>(2048, std::string(100, 'a'))};
+}
+
+Task Produce(AsyncSerializer<PollScheduler>* serializer) {
+  for (std::uint32_t i = 0; i < kMessageCount; i++) {
+    (co_await serializer->Write(MakeMessage(i))) ||
+        Die("Failed to write message");
+    std::cout << "Wrote message " << i << std::endl;
+  }
+}
+
+Task Consume(AsyncDeserializer<PollScheduler>* deserializer) {
+  for (std::uint32_t i = 0; i < kMessageCount; i++) {
+    Message message;
+    (co_await deserializer->Read(&message)) || Die("Failed to read message");
+    std::cout << "Read message " << message.sequence << " with "
+              << message.lines.size() << " lines" << std::endl;
+  }
+}
+
+}  // anonymous namespace
+
+int main(int /*argc*/, char** /*argv*/) {
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+    std::cerr << "Failed to create socket pair." << std::endl;
+    return -1;
+  }
+  for (int fd : fds) {
+    if (fcntl(fd, F_SETFL, O_NONBLOCK) < 0) {
+      std::cerr << "Failed to set O_NONBLOCK." << std::endl;
+      return -1;
+    }
+  }
+
+  PollScheduler scheduler;
+  AsyncSerializer<PollScheduler> serializer{fds[0], &scheduler};
+  AsyncDeserializer<PollScheduler> deserializer{fds[1], &scheduler};
+
+  Consume(&deserializer);
+  Produce(&serializer);
+  scheduler.Run();
+
+  close(fds[0]);
+  close(fds[1]);
+  return 0;
+}
+
+#else
+
+int main(int /*argc*/, char** /*argv*/) {
+  std::cout << "This example requires C++20 coroutine support." << std::endl;
+  return 0;
+}
+
+#endif
@@ -0,0 +1,124 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+
+#include <nop/utility/memory_arena.h>
+
+#ifdef NOP_HAS_MEMORY_RESOURCE
+
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/buffer_writer.h>
+#include <nop/utility/die.h>
+
+using nop::ArenaMemoryResource;
+using nop::BufferReader;
+using nop::BufferWriter;
+using nop::Deserializer;
+using nop::MemoryArena;
+using nop::Serializer;
+
+//
+// Example of decoding std::pmr containers through ArenaMemoryResource. The
+// containers passed to the deserializer are constructed with the arena's
+// memory resource, and every nested container and string created while
+// decoding inherits it through uses-allocator construction. The default
+// resource is replaced with std::pmr::null_memory_resource() while decoding so
+// that any allocation that escapes the arena fails loudly.
+//
+
+namespace {
+
+auto Die(const char* error_message = "Error") {
+  return nop::Die(std::cerr, error_message);
+}
+
+using Tags = std::pmr::vector<std::pmr::string>;
+using Index = std::pmr::map<std::pmr::string, Tags>;
+
+// Strings longer than the small string buffer so that decoding them
+// allocates.
+const char kTitle[] = "Decoding std::pmr containers through a memory arena";
+const char kFirstKey[] = "first key that does not fit in the string buffer";
+const char kSecondKey[] = "second key that does not fit in the string buffer";
+
+bool UsesResource(const std::pmr::string& value,
+                  std::pmr::memory_resource* resource) {
+  return value.get_allocator().resource() == resource;
+}
+
+}  // anonymous namespace
+
+int main(int /*argc*/, char** /*argv*/) {
+  std::uint8_t buffer[1024];
+  Serializer<BufferWriter> serializer{buffer};
+  serializer.Write(std::string{kTitle}) || Die();
+  serializer.Write(std::map<std::string, std::vector<std::string>>{
+      {kFirstKey, {kTitle, kSecondKey}}, {kSecondKey, {kFirstKey}}}) ||
+      Die();
+  const std::size_t size = serializer.writer().size();
+
+  MemoryArena arena;
+  ArenaMemoryResource resource{&arena};
+
+  std::pmr::memory_resource* previous =
+      std::pmr::set_default_resource(std::pmr::null_memory_resource());
+
+  std::pmr::string title{&resource};
+  Index index{&resource};
+  Deserializer<BufferReader> deserializer{buffer, size};
+  deserializer.Read(&title) || Die();
+  deserializer.Read(&index) || Die();
+
+  std::pmr::set_default_resource(previous);
+
+  bool in_arena = UsesResource(title, &resource);
+  for (const auto& entry : index) {
+    in_arena = in_arena && UsesResource(entry.first, &resource) &&
+               entry.second.get_allocator().resource() == &resource;
+    for (const auto& tag : entry.second)
+      in_arena = in_arena && UsesResource(tag, &resource);
+  }
+
+  std::cout << "Title: " << title << std::endl;
+  for (const auto& entry : index) {
+    std::cout << entry.first << ":" << std::endl;
+    for (const auto& tag : entry.second)
+      std::cout << "  " << tag << std::endl;
+  }
+  std::cout << "Arena bytes allocated: " << arena.bytes_allocated()
+            << std::endl;
+
+  if (!in_arena) {
+    std::cerr << "A decoded value does not use the arena." << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+#else
+
+int main(int /*argc*/, char** /*argv*/) {
+  std::cout << "This example requires <memory_resource>." << std::endl;
+  return 0;
+}
+
+#endif
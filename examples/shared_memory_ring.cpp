@@ -0,0 +1,252 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <errno.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/status.h>
+#include <nop/structure.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/buffer_writer.h>
+#include <nop/utility/die.h>
+#include <nop/utility/shared_memory_ring.h>
+#include <nop/utility/shared_memory_ring_reader.h>
+#include <nop/utility/shared_memory_ring_writer.h>
+
+//
+// Benchmark comparing the shared memory ring transport with a pipe between a
+// parent and child process, as in the pipe example. The parent sends a stream
+// of messages and the child decodes them.
+//
+// Over the pipe each message is serialized into a buffer, written to the pipe
+// with a length prefix, read into a second buffer by the child, and then
+// decoded: two copies and at least two system calls per message. Over the ring
+// each message is serialized directly into shared memory and decoded in place,
+// and system calls are only made to wake a sleeping peer.
+//
+
+using nop::BufferReader;
+using nop::BufferWriter;
+using nop::Deserializer;
+using nop::ErrorStatus;
+using nop::Serializer;
+using nop::SharedMemoryRing;
+using nop::SharedMemoryRingReader;
+using nop::SharedMemoryRingWriter;
+using nop::Status;
+
+namespace {
+
+auto Die(const char* error_message = "Error") {
+  return nop::Die(std::cerr, error_message);
+}
+
+// Message sent from parent to child.
+struct Sample {
+  std::uint64_t sequence{0};
+  std::vector<std::uint8_t> payload;
+  NOP_STRUCTURE(Sample, sequence, payload);
+};
+
+// Writes or reads exactly |size| bytes, retrying partial transfers.
+Status<void> WriteAll(int fd, const void* data, std::size_t size) {
+  const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+  while (size > 0) {
+    const ssize_t count = write(fd, bytes, size);
+    if (count < 0 && errno == EINTR)
+      continue;
+    else if (count < 0)
+      return ErrorStatus::IOError;
+    bytes += count;
+    size -= count;
+  }
+  return {};
+}
+
+Status<void> ReadAll(int fd, void* data, std::size_t size) {
+  std::uint8_t* bytes = static_cast<std::uint8_t*>(data);
+  while (size > 0) {
+    const ssize_t count = read(fd, bytes, size);
+    if (count < 0 && errno == EINTR)
+      continue;
+    else if (count < 0)
+      return ErrorStatus::IOError;
+    else if (count == 0)
+      return ErrorStatus::ReadLimitReached;
+    bytes += count;
+    size -= count;
+  }
+  return {};
+}
+
+// Checks the decoded sample and returns non-zero on mismatch.
+int CheckSample(const Sample& sample, std::uint64_t sequence,
+                std::size_t payload_size) {
+  return sample.sequence != sequence || sample.payload.size() != payload_size;
+}
+
+int PipeConsumer(int fd, std::uint64_t count, std::size_t payload_size) {
+  std::vector<std::uint8_t> buffer;
+  Sample sample;
+  int result = 0;
+  for (std::uint64_t i = 0; i < count; i++) {
+    std::uint32_t size;
+    ReadAll(fd, &size, sizeof(size)) || Die("Child failed to read size");
+    buffer.resize(size);
+    ReadAll(fd, buffer.data(), size) || Die("Child failed to read message");
+
+    Deserializer<BufferReader> deserializer{buffer.data(), buffer.size()};
+    deserializer.Read(&sample) || Die("Child failed to decode message");
+    result |= CheckSample(sample, i, payload_size);
+  }
+  return result;
+}
+
+void PipeProducer(int fd, std::uint64_t count, std::size_t payload_size) {
+  Sample sample;
+  sample.payload.resize(payload_size, 0x5a);
+  std::vector<std::uint8_t> buffer;
+  for (std::uint64_t i = 0; i < count; i++) {
+    sample.sequence = i;
+    Serializer<BufferWriter> serializer;
+    const std::uint32_t size = serializer.GetSize(sample);
+    buffer.resize(sizeof(size) + size);
+    std::memcpy(buffer.data(), &size, sizeof(size));
+    serializer.writer() = BufferWriter{buffer.data() + sizeof(size), size};
+    serializer.Write(sample) || Die("Parent failed to encode message");
+    WriteAll(fd, buffer.data(), buffer.size()) ||
+        Die("Parent failed to write message");
+  }
+}
+
+int RingConsumer(SharedMemoryRing* ring, std::uint64_t count,
+                 std::size_t payload_size) {
+  Deserializer<SharedMemoryRingReader> deserializer{ring};
+  Sample sample;
+  int result = 0;
+  for (std::uint64_t i = 0; i < count; i++) {
+    deserializer.reader().Receive() || Die("Child failed to receive message");
+    deserializer.Read(&sample) || Die("Child failed to decode message");
+    result |= CheckSample(sample, i, payload_size);
+  }
+  return result;
+}
+
+void RingProducer(SharedMemoryRing* ring, std::uint64_t count,
+                  std::size_t payload_size) {
+  Sample sample;
+  sample.payload.resize(payload_size, 0x5a);
+  Serializer<SharedMemoryRingWriter> serializer{ring};
+  for (std::uint64_t i = 0; i < count; i++) {
+    sample.sequence = i;
+    serializer.Write(sample) || Die("Parent failed to encode message");
+    serializer.writer().Commit() || Die("Parent failed to commit message");
+  }
+}
+
+// Forks a child to run |consumer| while the parent runs |producer|, and
+// returns the time until the child has decoded every message.
+template <typename Producer, typename Consumer>
+double Run(Producer&& producer, Consumer&& consumer) {
+  const auto start = std::chrono::steady_clock::now();
+  const pid_t pid = fork();
+  if (pid < 0) {
+    std::cerr << "Failed to fork: " << strerror(errno) << std::endl;
+    std::exit(-1);
+  } else if (pid == 0) {
+    _exit(consumer());
+  }
+
+  producer();
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    std::cerr << "Child reported an error." << std::endl;
+
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+double RunPipe(std::uint64_t count, std::size_t payload_size) {
+  int pipe_fds[2];
+  if (pipe(pipe_fds) < 0) {
+    std::cerr << "Failed to create pipe: " << strerror(errno) << std::endl;
+    std::exit(-1);
+  }
+
+  const double seconds = Run(
+      [&] {
+        close(pipe_fds[0]);
+        PipeProducer(pipe_fds[1], count, payload_size);
+        close(pipe_fds[1]);
+      },
+      [&] {
+        close(pipe_fds[1]);
+        return PipeConsumer(pipe_fds[0], count, payload_size);
+      });
+  return seconds;
+}
+
+double RunRing(std::uint64_t count, std::size_t payload_size) {
+  const std::size_t kRingSize = 4 * 1024 * 1024;
+  auto ring_status =
+      SharedMemoryRing::Create(kRingSize) || Die("Failed to create ring");
+  SharedMemoryRing ring = ring_status.take();
+
+  return Run([&] { RingProducer(&ring, count, payload_size); },
+             [&] { return RingConsumer(&ring, count, payload_size); });
+}
+
+void Report(const char* name, std::uint64_t count, std::size_t payload_size,
+            double seconds) {
+  const double messages_per_second = count / seconds;
+  const double megabytes_per_second =
+      count * payload_size / seconds / (1024.0 * 1024.0);
+  std::cout << std::setw(6) << name << std::setw(10) << payload_size
+            << std::setw(14) << std::fixed << std::setprecision(0)
+            << messages_per_second << std::setw(12) << std::setprecision(1)
+            << megabytes_per_second << std::endl;
+}
+
+}  // anonymous namespace
+
+int main(int /*argc*/, char** /*argv*/) {
+  const std::size_t kPayloadSizes[] = {16, 256, 4096, 65536};
+  const std::uint64_t kTotalBytes = 512 * 1024 * 1024;
+  const std::uint64_t kMaxCount = 1000000;
+
+  std::cout << "  path   payload    messages/s        MB/s" << std::endl;
+  for (std::size_t payload_size : kPayloadSizes) {
+    const std::uint64_t count =
+        std::min<std::uint64_t>(kMaxCount, kTotalBytes / payload_size);
+    Report("pipe", count, payload_size, RunPipe(count, payload_size));
+    Report("ring", count, payload_size, RunRing(count, payload_size));
+  }
+
+  return 0;
+}
@@ -102,6 +102,25 @@ struct Encoding<std::array<T, Length>, EnableIfNotIntegral<T>>
 
     return {};
   }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* reader) {
+    SizeType size = 0;
+    auto status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+    else if (size != Length)
+      return ErrorStatus::InvalidContainerLength;
+
+    for (SizeType i = 0; i < Length; i++) {
+      status = Encoding<T>::Validate(reader);
+      if (!status)
+        return status;
+    }
+
+    return {};
+  }
 };
 
 template <typename T, std::size_t Length>
@@ -160,6 +179,25 @@ struct Encoding<T[Length], EnableIfNotIntegral<T>> : EncodingIO<T[Length]> {
 
     return {};
   }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* reader) {
+    SizeType size = 0;
+    auto status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+    else if (size != Length)
+      return ErrorStatus::InvalidContainerLength;
+
+    for (SizeType i = 0; i < Length; i++) {
+      status = Encoding<T>::Validate(reader);
+      if (!status)
+        return status;
+    }
+
+    return {};
+  }
 };
 
 template <typename T, std::size_t Length>
@@ -204,6 +242,23 @@ struct Encoding<std::array<T, Length>, EnableIfIntegral<T>>
 
     return reader->Read(&(*value)[0], &(*value)[Length]);
   }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* reader) {
+    SizeType size = 0;
+    auto status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+    else if (size != Length * sizeof(T))
+      return ErrorStatus::InvalidContainerLength;
+
+    status = reader->Ensure(size);
+    if (!status)
+      return status;
+
+    return reader->Skip(size);
+  }
 };
 
 template <typename T, std::size_t Length>
@@ -247,6 +302,23 @@ struct Encoding<T[Length], EnableIfIntegral<T>> : EncodingIO<T[Length]> {
 
     return reader->Read(&(*value)[0], &(*value)[Length]);
   }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* reader) {
+    SizeType size = 0;
+    auto status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+    else if (size != Length * sizeof(T))
+      return ErrorStatus::InvalidContainerLength;
+
+    status = reader->Ensure(size);
+    if (!status)
+      return status;
+
+    return reader->Skip(size);
+  }
 };
 
 }  // namespace nop
@@ -0,0 +1,321 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_BASE_COLUMNAR_H_
+#define LIBNOP_INCLUDE_NOP_BASE_COLUMNAR_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include <nop/base/encoding.h>
+#include <nop/base/utility.h>
+#include <nop/types/columnar.h>
+#include <nop/types/detail/member_pointer.h>
+
+namespace nop {
+
+//
+// ColumnarVector<T> encoding format:
+//
+// +-----+-----------+---------+-----//----+
+// | STC | INT64:M+1 | INT64:N | M COLUMNS |
+// +-----+-----------+---------+-----//----+
+//
+// M is the number of members of T and N is the number of elements. The
+// encoding is a structure with N as its first member, followed by one column
+// per member of T, in member order.
+//
+// Columns of arithmetic members other than bool:
+//
+// +-----+---------+---------+
+// | BIN | INT64:L | L BYTES |
+// +-----+---------+---------+
+//
+// L must equal N * sizeof(member type).
+//
+// Columns of other members:
+//
+// +-----+---------+------//-----+
+// | ARY | INT64:N | N ELEMENTS  |
+// +-----+---------+------//-----+
+//
+// Elements must be valid encodings of the member type.
+//
+
+template <typename T, typename Allocator>
+struct Encoding<ColumnarVector<T, Allocator>>
+    : EncodingIO<ColumnarVector<T, Allocator>> {
+  using Type = ColumnarVector<T, Allocator>;
+
+  static constexpr EncodingByte Prefix(const Type& /*value*/) {
+    return EncodingByte::Structure;
+  }
+
+  static constexpr std::size_t Size(const Type& value) {
+    return BaseEncodingSize(Prefix(value)) +
+           Encoding<SizeType>::Size(Count + 1) +
+           Encoding<SizeType>::Size(value.size()) +
+           ColumnsSize(value, Index<Count>{});
+  }
+
+  static constexpr bool Match(EncodingByte prefix) {
+    return prefix == EncodingByte::Structure;
+  }
+
+  template <typename Writer>
+  static constexpr Status<void> WritePayload(EncodingByte /*prefix*/,
+                                             const Type& value,
+                                             Writer* writer) {
+    auto status = Encoding<SizeType>::Write(Count + 1, writer);
+    if (!status)
+      return status;
+
+    status = Encoding<SizeType>::Write(value.size(), writer);
+    if (!status)
+      return status;
+
+    return WriteColumns(value, writer, Index<Count>{});
+  }
+
+  template <typename Reader>
+  static constexpr Status<void> ReadPayload(EncodingByte /*prefix*/,
+                                            Type* value, Reader* reader) {
+    SizeType member_count = 0;
+    auto status = Encoding<SizeType>::Read(&member_count, reader);
+    if (!status)
+      return status;
+    else if (member_count != Count + 1)
+      return ErrorStatus::InvalidMemberCount;
+
+    SizeType size = 0;
+    status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+
+    // The first column grows the vector as its data is read, rather than
+    // trusting the element count, as a defense against abusive sizes.
+    value->clear();
+    return ReadColumns(size, value, reader, Index<Count>{});
+  }
+
+ private:
+  enum : std::size_t { Count = MemberListTraits<T>::MemberList::Count };
+  static_assert(Count > 0, "ColumnarVector<T> requires T to have members.");
+
+  // Number of arithmetic values gathered or scattered at a time.
+  enum : std::size_t { kChunkSize = 256 };
+
+  using MemberList = typename MemberListTraits<T>::MemberList;
+
+  template <std::size_t Index>
+  using PointerAt = typename MemberList::template At<Index>;
+
+  template <typename Pointer>
+  using IsBinaryColumn = std::integral_constant<
+      bool, std::is_arithmetic<typename Pointer::Type>::value &&
+                !std::is_same<typename Pointer::Type, bool>::value>;
+
+  static constexpr std::size_t ColumnsSize(const Type& /*value*/, Index<0>) {
+    return 0;
+  }
+
+  template <std::size_t index>
+  static constexpr std::size_t ColumnsSize(const Type& value, Index<index>) {
+    using Pointer = PointerAt<index - 1>;
+    return ColumnsSize(value, Index<index - 1>{}) +
+           ColumnSize<Pointer>(value, IsBinaryColumn<Pointer>{});
+  }
+
+  template <typename Pointer>
+  static constexpr std::size_t ColumnSize(const Type& value, std::true_type) {
+    const SizeType length = value.size() * sizeof(typename Pointer::Type);
+    return BaseEncodingSize(EncodingByte::Binary) +
+           Encoding<SizeType>::Size(length) + length;
+  }
+
+  template <typename Pointer>
+  static constexpr std::size_t ColumnSize(const Type& value, std::false_type) {
+    std::size_t size = BaseEncodingSize(EncodingByte::Array) +
+                       Encoding<SizeType>::Size(value.size());
+    for (const T& element : value)
+      size += Pointer::Size(element);
+    return size;
+  }
+
+  template <typename Writer>
+  static constexpr Status<void> WriteColumns(const Type& /*value*/,
+                                             Writer* /*writer*/, Index<0>) {
+    return {};
+  }
+
+  template <std::size_t index, typename Writer>
+  static constexpr Status<void> WriteColumns(const Type& value, Writer* writer,
+                                             Index<index>) {
+    using Pointer = PointerAt<index - 1>;
+    auto status = WriteColumns(value, writer, Index<index - 1>{});
+    if (!status)
+      return status;
+    else
+      return WriteColumn<Pointer>(value, writer, IsBinaryColumn<Pointer>{});
+  }
+
+  // Gathers the member values into a local chunk and writes the chunk in bulk.
+  template <typename Pointer, typename Writer>
+  static Status<void> WriteColumn(const Type& value, Writer* writer,
+                                  std::true_type) {
+    using Member = typename Pointer::Type;
+    auto status =
+        writer->Write(static_cast<std::uint8_t>(EncodingByte::Binary));
+    if (!status)
+      return status;
+
+    status = Encoding<SizeType>::Write(value.size() * sizeof(Member), writer);
+    if (!status)
+      return status;
+
+    Member chunk[kChunkSize];
+    for (std::size_t i = 0; i < value.size(); i += kChunkSize) {
+      const std::size_t count = std::min<std::size_t>(kChunkSize,
+                                                      value.size() - i);
+      for (std::size_t j = 0; j < count; j++)
+        chunk[j] = Pointer::Resolve(value[i + j]);
+
+      status = writer->Write(chunk, chunk + count);
+      if (!status)
+        return status;
+    }
+
+    return {};
+  }
+
+  template <typename Pointer, typename Writer>
+  static Status<void> WriteColumn(const Type& value, Writer* writer,
+                                  std::false_type) {
+    auto status = writer->Write(static_cast<std::uint8_t>(EncodingByte::Array));
+    if (!status)
+      return status;
+
+    status = Encoding<SizeType>::Write(value.size(), writer);
+    if (!status)
+      return status;
+
+    for (const T& element : value) {
+      status = Pointer::Write(element, writer, MemberList{});
+      if (!status)
+        return status;
+    }
+
+    return {};
+  }
+
+  template <typename Reader>
+  static constexpr Status<void> ReadColumns(SizeType /*size*/, Type* /*value*/,
+                                            Reader* /*reader*/, Index<0>) {
+    return {};
+  }
+
+  template <std::size_t index, typename Reader>
+  static constexpr Status<void> ReadColumns(SizeType size, Type* value,
+                                            Reader* reader, Index<index>) {
+    using Pointer = PointerAt<index - 1>;
+    auto status = ReadColumns(size, value, reader, Index<index - 1>{});
+    if (!status)
+      return status;
+    else
+      return ReadColumn<Pointer>(size, index == 1, value, reader,
+                                 IsBinaryColumn<Pointer>{});
+  }
+
+  // Reads the column into a local chunk in bulk and scatters the values into
+  // the elements.
+  template <typename Pointer, typename Reader>
+  static Status<void> ReadColumn(SizeType size, bool first, Type* value,
+                                 Reader* reader, std::true_type) {
+    using Member = typename Pointer::Type;
+    std::uint8_t prefix = 0;
+    auto status = reader->Read(&prefix);
+    if (!status)
+      return status;
+    else if (prefix != static_cast<std::uint8_t>(EncodingByte::Binary))
+      return ErrorStatus::UnexpectedEncodingType;
+
+    SizeType length = 0;
+    status = Encoding<SizeType>::Read(&length, reader);
+    if (!status)
+      return status;
+    else if (size > std::numeric_limits<SizeType>::max() / sizeof(Member) ||
+             length != size * sizeof(Member))
+      return ErrorStatus::InvalidContainerLength;
+
+    // Make sure the reader has enough data to fulfill the requested size as a
+    // defense against abusive or erroneous sizes.
+    status = reader->Ensure(length);
+    if (!status)
+      return status;
+
+    if (first)
+      value->resize(size);
+
+    Member chunk[kChunkSize];
+    for (std::size_t i = 0; i < size; i += kChunkSize) {
+      const std::size_t count = std::min<std::size_t>(kChunkSize, size - i);
+      status = reader->Read(chunk, chunk + count);
+      if (!status)
+        return status;
+
+      for (std::size_t j = 0; j < count; j++)
+        *Pointer::Resolve(&(*value)[i + j]) = chunk[j];
+    }
+
+    return {};
+  }
+
+  template <typename Pointer, typename Reader>
+  static Status<void> ReadColumn(SizeType size, bool first, Type* value,
+                                 Reader* reader, std::false_type) {
+    std::uint8_t prefix = 0;
+    auto status = reader->Read(&prefix);
+    if (!status)
+      return status;
+    else if (prefix != static_cast<std::uint8_t>(EncodingByte::Array))
+      return ErrorStatus::UnexpectedEncodingType;
+
+    SizeType count = 0;
+    status = Encoding<SizeType>::Read(&count, reader);
+    if (!status)
+      return status;
+    else if (count != size)
+      return ErrorStatus::InvalidContainerLength;
+
+    for (SizeType i = 0; i < size; i++) {
+      if (first)
+        value->emplace_back();
+
+      status = Pointer::Read(&(*value)[i], reader, MemberList{});
+      if (!status)
+        return status;
+    }
+
+    return {};
+  }
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_BASE_COLUMNAR_H_
@@ -28,6 +28,7 @@
 #include <nop/base/encoding_byte.h>
 #include <nop/base/utility.h>
 #include <nop/status.h>
+#include <nop/traits/is_trusted_reader.h>
 
 namespace nop {
 
@@ -128,13 +129,59 @@ struct EncodingIO {
       return status;
 
     const EncodingByte prefix = static_cast<EncodingByte>(prefix_byte);
-    if (Encoding<T>::Match(prefix))
+    if (IsTrustedReader<Reader>::value || Encoding<T>::Match(prefix))
       return Encoding<T>::ReadPayload(prefix, value, reader);
     else
       return ErrorStatus::UnexpectedEncodingType;
   }
 
+  // Checks that the next value in the reader is a well-formed encoding of
+  // type T without storing the decoded value. The reader is advanced past the
+  // value on success.
+  template <typename Reader>
+  static constexpr Status<void> Validate(Reader* reader) {
+    std::uint8_t prefix_byte = 0;
+    auto status = reader->Read(&prefix_byte);
+    if (!status)
+      return status;
+
+    const EncodingByte prefix = static_cast<EncodingByte>(prefix_byte);
+    if (Encoding<T>::Match(prefix))
+      return Encoding<T>::ValidatePayload(prefix, reader);
+    else
+      return ErrorStatus::UnexpectedEncodingType;
+  }
+
+  // Default payload validation, used by encodings that do not provide their
+  // own ValidatePayload(). The payload of arithmetic types is fully determined
+  // by the prefix. Other types are decoded into a temporary value.
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte prefix,
+                                                Reader* reader) {
+    return ValidatePayload(prefix, reader, std::is_arithmetic<T>{});
+  }
+
  protected:
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte prefix,
+                                                Reader* reader,
+                                                std::true_type) {
+    const std::size_t size = BaseEncodingSize(prefix) - 1;
+    auto status = reader->Ensure(size);
+    if (!status)
+      return status;
+
+    return reader->Skip(size);
+  }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte prefix,
+                                                Reader* reader,
+                                                std::false_type) {
+    T value{};
+    return Encoding<T>::ReadPayload(prefix, &value, reader);
+  }
+
   template <typename As, typename From, typename Writer,
             typename Enabled = EnableIfArithmetic<As, From>>
   static constexpr Status<void> WriteAs(From value, Writer* writer) {
@@ -61,6 +61,12 @@ struct Encoding<T, EnableIfEnum<T>> : EncodingIO<T> {
         prefix, reinterpret_cast<IntegerType*>(value), reader);
   }
 
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte prefix,
+                                                Reader* reader) {
+    return Encoding<IntegerType>::ValidatePayload(prefix, reader);
+  }
+
  private:
   using IntegerType = typename std::underlying_type<T>::type;
 };
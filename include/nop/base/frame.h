@@ -0,0 +1,87 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_BASE_FRAME_H_
+#define LIBNOP_INCLUDE_NOP_BASE_FRAME_H_
+
+#include <cstddef>
+
+#include <nop/base/encoding.h>
+#include <nop/status.h>
+#include <nop/utility/bounded_reader.h>
+#include <nop/utility/bounded_writer.h>
+
+namespace nop {
+
+//
+// Framed value format:
+//
+// +---------+---------+
+// | INT64:L | L BYTES |
+// +---------+---------+
+//
+// Each frame holds exactly one complete encoded value. The length prefix allows
+// the frames in a stream to be located without examining their contents, so
+// that independent values may be split apart and decoded in any order.
+//
+// L is the size reported by Encoding<T>::Size(). Since a few encodings
+// overestimate their size, the value may be followed by padding that fills out
+// the rest of the frame, as with table entries.
+//
+
+// Returns the number of bytes needed to write |value| as a single frame.
+template <typename T>
+std::size_t FrameSize(const T& value) {
+  const SizeType length = Encoding<T>::Size(value);
+  return Encoding<SizeType>::Size(length) + length;
+}
+
+// Writes |value| to |writer| as a single frame.
+template <typename T, typename Writer>
+Status<void> WriteFrame(const T& value, Writer* writer) {
+  const SizeType length = Encoding<T>::Size(value);
+  auto status = Encoding<SizeType>::Write(length, writer);
+  if (!status)
+    return status;
+
+  BoundedWriter<Writer> bounded_writer{writer, length};
+  status = Encoding<T>::Write(value, &bounded_writer);
+  if (!status)
+    return status;
+
+  return bounded_writer.WritePadding();
+}
+
+// Reads a single frame from |reader| into |value|, skipping any padding that
+// follows the value.
+template <typename T, typename Reader>
+Status<void> ReadFrame(T* value, Reader* reader) {
+  SizeType length = 0;
+  auto status = Encoding<SizeType>::Read(&length, reader);
+  if (!status)
+    return status;
+
+  BoundedReader<Reader> bounded_reader{reader, length};
+  status = Encoding<T>::Read(value, &bounded_reader);
+  if (!status)
+    return status;
+
+  return bounded_reader.ReadPadding();
+}
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_BASE_FRAME_H_
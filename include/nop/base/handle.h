@@ -89,6 +89,22 @@ struct Encoding<Handle<Policy>> : EncodingIO<Handle<Policy>> {
     *value = get_status.take();
     return {};
   }
+
+  // Validates the handle type and reference without resolving the handle
+  // through the reader, since the handles of a message may not be available
+  // until it is decoded.
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* reader) {
+    HandleType handle_type;
+    auto status = Encoding<HandleType>::Read(&handle_type, reader);
+    if (!status)
+      return status;
+    else if (handle_type != Policy::HandleType())
+      return ErrorStatus::UnexpectedHandleType;
+
+    return Encoding<HandleReference>::Validate(reader);
+  }
 };
 
 }  // namespace nop
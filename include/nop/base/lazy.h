@@ -0,0 +1,120 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_BASE_LAZY_H_
+#define LIBNOP_INCLUDE_NOP_BASE_LAZY_H_
+
+#include <type_traits>
+
+#include <nop/base/encoding.h>
+#include <nop/base/skip.h>
+#include <nop/traits/is_contiguous_reader.h>
+#include <nop/types/lazy.h>
+
+namespace nop {
+
+//
+// Lazy<T> encoding format:
+//
+// +-------+
+// | VALUE |
+// +-------+
+//
+// VALUE must be a valid encoding of type T. The encoding of Lazy<T> is the same
+// as the encoding of T.
+//
+
+template <typename T>
+struct Encoding<Lazy<T>> : EncodingIO<Lazy<T>> {
+  using Type = Lazy<T>;
+
+  static constexpr EncodingByte Prefix(const Type& value) {
+    return value.is_encoded() ? value.encoded_prefix()
+                              : Encoding<T>::Prefix(Value(value));
+  }
+
+  static constexpr std::size_t Size(const Type& value) {
+    return value.is_encoded()
+               ? BaseEncodingSize(EncodingByte::Nil) + value.encoded_size()
+               : Encoding<T>::Size(Value(value));
+  }
+
+  static constexpr bool Match(EncodingByte prefix) {
+    return Encoding<T>::Match(prefix);
+  }
+
+  template <typename Writer>
+  static constexpr Status<void> WritePayload(EncodingByte prefix,
+                                             const Type& value,
+                                             Writer* writer) {
+    if (value.is_encoded()) {
+      return writer->Write(value.encoded_data(),
+                           value.encoded_data() + value.encoded_size());
+    } else {
+      return Encoding<T>::WritePayload(prefix, Value(value), writer);
+    }
+  }
+
+  template <typename Reader>
+  static constexpr Status<void> ReadPayload(EncodingByte prefix, Type* value,
+                                            Reader* reader) {
+    return ReadPayload(prefix, value, reader, IsContiguousReader<Reader>{});
+  }
+
+  // Validation checks the full encoding of T, so that deferred decoding of a
+  // validated message cannot fail.
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte prefix,
+                                                Reader* reader) {
+    return Encoding<T>::ValidatePayload(prefix, reader);
+  }
+
+ private:
+  // Returns the held value of an instance that is not encoded. The value is
+  // always present in this case, so the status can be ignored.
+  static const T& Value(const Type& value) { return *value.get().get(); }
+
+  // Records the range of the payload in the reader's buffer.
+  template <typename Reader>
+  static Status<void> ReadPayload(EncodingByte prefix, Type* value,
+                                  Reader* reader, std::true_type) {
+    const std::uint8_t* begin = reader->cursor();
+    auto status = SkipPayload(prefix, reader);
+    if (!status)
+      return status;
+
+    value->SetEncoded(prefix, begin, reader->cursor() - begin);
+    return {};
+  }
+
+  // Decodes the value immediately when the encoded bytes are not retained by
+  // the reader.
+  template <typename Reader>
+  static Status<void> ReadPayload(EncodingByte prefix, Type* value,
+                                  Reader* reader, std::false_type) {
+    T temp{};
+    auto status = Encoding<T>::ReadPayload(prefix, &temp, reader);
+    if (!status)
+      return status;
+
+    *value = std::move(temp);
+    return {};
+  }
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_BASE_LAZY_H_
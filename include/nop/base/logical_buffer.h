@@ -148,6 +148,25 @@ struct Encoding<
     value->size() = size;
     return {};
   }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* reader) {
+    SizeType size = 0;
+    auto status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+    else if (!IsUnbounded && size > Length)
+      return ErrorStatus::InvalidContainerLength;
+
+    for (SizeType i = 0; i < size; i++) {
+      status = Encoding<ValueType>::Validate(reader);
+      if (!status)
+        return status;
+    }
+
+    return {};
+  }
 };
 
 // Encoding type that handles integral element types. Logical buffers of
@@ -206,6 +225,25 @@ struct Encoding<LogicalBuffer<BufferType, SizeType, IsUnbounded>,
     value->size() = size;
     return reader->Read(value->begin(), value->end());
   }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* reader) {
+    SizeType size_bytes = 0;
+    auto status = Encoding<SizeType>::Read(&size_bytes, reader);
+    if (!status) {
+      return status;
+    } else if ((!IsUnbounded && size_bytes > Length * sizeof(ValueType)) ||
+               size_bytes % sizeof(ValueType) != 0) {
+      return ErrorStatus::InvalidContainerLength;
+    }
+
+    status = reader->Ensure(size_bytes);
+    if (!status)
+      return status;
+
+    return reader->Skip(size_bytes);
+  }
 };
 
 }  // namespace nop
@@ -22,6 +22,8 @@
 #include <unordered_map>
 
 #include <nop/base/encoding.h>
+#include <nop/base/parallel.h>
+#include <nop/traits/is_parallel_writer.h>
 
 namespace nop {
 
@@ -48,7 +50,7 @@ struct Encoding<std::map<Key, T, Compare, Allocator>>
     return BaseEncodingSize(Prefix(value)) +
            Encoding<SizeType>::Size(value.size()) +
            std::accumulate(
-               value.cbegin(), value.cend(), 0U,
+               value.cbegin(), value.cend(), std::size_t{0},
                [](const std::size_t& sum, const std::pair<Key, T>& element) {
                  return sum + Encoding<Key>::Size(element.first) +
                         Encoding<T>::Size(element.second);
@@ -67,43 +69,93 @@ struct Encoding<std::map<Key, T, Compare, Allocator>>
     if (!status)
       return status;
 
-    for (const auto& element : value) {
-      status = Encoding<Key>::Write(element.first, writer);
+    return WriteElements(value, writer, IsParallelWriter<Writer>{});
+  }
+
+  template <typename Reader>
+  static constexpr Status<void> ReadPayload(EncodingByte /*prefix*/,
+                                            Type* value, Reader* reader) {
+    SizeType size = 0;
+    auto status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+
+    value->clear();
+    for (SizeType i = 0; i < size; i++) {
+      std::pair<Key, T> element{
+          MakeWithAllocator<Key>(value->get_allocator()),
+          MakeWithAllocator<T>(value->get_allocator())};
+      status = Encoding<Key>::Read(&element.first, reader);
       if (!status)
         return status;
 
-      status = Encoding<T>::Write(element.second, writer);
+      status = Encoding<T>::Read(&element.second, reader);
       if (!status)
         return status;
+
+      value->emplace(std::move(element));
     }
 
     return {};
   }
 
   template <typename Reader>
-  static constexpr Status<void> ReadPayload(EncodingByte /*prefix*/,
-                                            Type* value, Reader* reader) {
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* reader) {
     SizeType size = 0;
     auto status = Encoding<SizeType>::Read(&size, reader);
     if (!status)
       return status;
 
-    value->clear();
     for (SizeType i = 0; i < size; i++) {
-      std::pair<Key, T> element;
-      status = Encoding<Key>::Read(&element.first, reader);
+      status = Encoding<Key>::Validate(reader);
       if (!status)
         return status;
 
-      status = Encoding<T>::Read(&element.second, reader);
+      status = Encoding<T>::Validate(reader);
       if (!status)
         return status;
+    }
 
-      value->emplace(std::move(element));
+    return {};
+  }
+
+ private:
+  template <typename Writer>
+  static Status<void> WriteElements(const Type& value, Writer* writer,
+                                    std::false_type) {
+    for (const auto& element : value) {
+      auto status = WriteElement(element, writer);
+      if (!status)
+        return status;
     }
 
     return {};
   }
+
+  template <typename Writer>
+  static Status<void> WriteElements(const Type& value, Writer* writer,
+                                    std::true_type) {
+    return WriteElementsInParallel(
+        value.cbegin(), value.size(), writer,
+        [](const typename Type::value_type& element) {
+          return Encoding<Key>::Size(element.first) +
+                 Encoding<T>::Size(element.second);
+        },
+        [](const typename Type::value_type& element, auto* element_writer) {
+          return WriteElement(element, element_writer);
+        });
+  }
+
+  template <typename Writer>
+  static Status<void> WriteElement(const typename Type::value_type& element,
+                                   Writer* writer) {
+    auto status = Encoding<Key>::Write(element.first, writer);
+    if (!status)
+      return status;
+
+    return Encoding<T>::Write(element.second, writer);
+  }
 };
 
 template <typename Key, typename T, typename Hash, typename KeyEqual,
@@ -120,7 +172,7 @@ struct Encoding<std::unordered_map<Key, T, Hash, KeyEqual, Allocator>>
     return BaseEncodingSize(Prefix(value)) +
            Encoding<SizeType>::Size(value.size()) +
            std::accumulate(
-               value.cbegin(), value.cend(), 0U,
+               value.cbegin(), value.cend(), std::size_t{0},
                [](const std::size_t& sum, const std::pair<Key, T>& element) {
                  return sum + Encoding<Key>::Size(element.first) +
                         Encoding<T>::Size(element.second);
@@ -139,43 +191,93 @@ struct Encoding<std::unordered_map<Key, T, Hash, KeyEqual, Allocator>>
     if (!status)
       return status;
 
-    for (const auto& element : value) {
-      status = Encoding<Key>::Write(element.first, writer);
+    return WriteElements(value, writer, IsParallelWriter<Writer>{});
+  }
+
+  template <typename Reader>
+  static constexpr Status<void> ReadPayload(EncodingByte /*prefix*/,
+                                            Type* value, Reader* reader) {
+    SizeType size = 0;
+    auto status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+
+    value->clear();
+    for (SizeType i = 0; i < size; i++) {
+      std::pair<Key, T> element{
+          MakeWithAllocator<Key>(value->get_allocator()),
+          MakeWithAllocator<T>(value->get_allocator())};
+      status = Encoding<Key>::Read(&element.first, reader);
       if (!status)
         return status;
 
-      status = Encoding<T>::Write(element.second, writer);
+      status = Encoding<T>::Read(&element.second, reader);
       if (!status)
         return status;
+
+      value->emplace(std::move(element));
     }
 
     return {};
   }
 
   template <typename Reader>
-  static constexpr Status<void> ReadPayload(EncodingByte /*prefix*/,
-                                            Type* value, Reader* reader) {
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* reader) {
     SizeType size = 0;
     auto status = Encoding<SizeType>::Read(&size, reader);
     if (!status)
       return status;
 
-    value->clear();
     for (SizeType i = 0; i < size; i++) {
-      std::pair<Key, T> element;
-      status = Encoding<Key>::Read(&element.first, reader);
+      status = Encoding<Key>::Validate(reader);
       if (!status)
         return status;
 
-      status = Encoding<T>::Read(&element.second, reader);
+      status = Encoding<T>::Validate(reader);
       if (!status)
         return status;
+    }
 
-      value->emplace(std::move(element));
+    return {};
+  }
+
+ private:
+  template <typename Writer>
+  static Status<void> WriteElements(const Type& value, Writer* writer,
+                                    std::false_type) {
+    for (const auto& element : value) {
+      auto status = WriteElement(element, writer);
+      if (!status)
+        return status;
     }
 
     return {};
   }
+
+  template <typename Writer>
+  static Status<void> WriteElements(const Type& value, Writer* writer,
+                                    std::true_type) {
+    return WriteElementsInParallel(
+        value.cbegin(), value.size(), writer,
+        [](const typename Type::value_type& element) {
+          return Encoding<Key>::Size(element.first) +
+                 Encoding<T>::Size(element.second);
+        },
+        [](const typename Type::value_type& element, auto* element_writer) {
+          return WriteElement(element, element_writer);
+        });
+  }
+
+  template <typename Writer>
+  static Status<void> WriteElement(const typename Type::value_type& element,
+                                   Writer* writer) {
+    auto status = Encoding<Key>::Write(element.first, writer);
+    if (!status)
+      return status;
+
+    return Encoding<T>::Write(element.second, writer);
+  }
 };
 
 }  // namespace nop
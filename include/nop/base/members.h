@@ -66,12 +66,25 @@ struct Encoding<T, EnableIfHasMemberList<T>> : EncodingIO<T> {
     auto status = Encoding<SizeType>::Read(&size, reader);
     if (!status)
       return status;
-    else if (size != Count)
+    else if (!IsTrustedReader<Reader>::value && size != Count)
       return ErrorStatus::InvalidMemberCount;
     else
       return ReadMembers(value, reader, Index<Count>{});
   }
 
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* reader) {
+    SizeType size = 0;
+    auto status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+    else if (size != Count)
+      return ErrorStatus::InvalidMemberCount;
+    else
+      return ValidateMembers(reader, Index<Count>{});
+  }
+
  private:
   enum : std::size_t { Count = MemberListTraits<T>::MemberList::Count };
 
@@ -118,6 +131,20 @@ struct Encoding<T, EnableIfHasMemberList<T>> : EncodingIO<T> {
     else
       return PointerAt<index - 1>::Read(value, reader, MemberList{});
   }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidateMembers(Reader* /*reader*/, Index<0>) {
+    return {};
+  }
+
+  template <std::size_t index, typename Reader>
+  static constexpr Status<void> ValidateMembers(Reader* reader, Index<index>) {
+    auto status = ValidateMembers(reader, Index<index - 1>{});
+    if (!status)
+      return status;
+    else
+      return PointerAt<index - 1>::Validate(reader, MemberList{});
+  }
 };
 
 }  // namespace nop
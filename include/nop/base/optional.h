@@ -82,6 +82,15 @@ struct Encoding<Optional<T>> : EncodingIO<Optional<T>> {
 
     return {};
   }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte prefix,
+                                                Reader* reader) {
+    if (prefix == EncodingByte::Nil)
+      return {};
+    else
+      return Encoding<T>::ValidatePayload(prefix, reader);
+  }
 };
 
 }  // namespace nop
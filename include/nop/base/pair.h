@@ -84,6 +84,23 @@ struct Encoding<std::pair<T, U>> : EncodingIO<std::pair<T, U>> {
     return Encoding<Second>::Read(&value->second, reader);
   }
 
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* reader) {
+    SizeType size = 0;
+    auto status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+    else if (size != 2u)
+      return ErrorStatus::InvalidContainerLength;
+
+    status = Encoding<First>::Validate(reader);
+    if (!status)
+      return status;
+
+    return Encoding<Second>::Validate(reader);
+  }
+
  private:
   using First = std::remove_cv_t<std::remove_reference_t<T>>;
   using Second = std::remove_cv_t<std::remove_reference_t<U>>;
@@ -0,0 +1,214 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_BASE_PARALLEL_H_
+#define LIBNOP_INCLUDE_NOP_BASE_PARALLEL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <numeric>
+#include <vector>
+
+#include <nop/base/encoding.h>
+#include <nop/base/skip.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/buffer_writer.h>
+
+namespace nop {
+
+// Containers with fewer elements than this are always written sequentially.
+enum : std::size_t { kParallelWriteThreshold = 4096 };
+
+// Containers with fewer elements than this are always read sequentially.
+enum : std::size_t { kParallelReadThreshold = 4096 };
+
+// Minimum number of elements written by each parallel task and the number of
+// tasks created per executor thread, to balance uneven element sizes.
+enum : std::size_t { kParallelWriteGrain = 1024, kParallelTasksPerThread = 4 };
+
+// Minimum number of elements read by each parallel task.
+enum : std::size_t { kParallelReadGrain = 1024 };
+
+// Writes |count| elements starting at |begin| to a parallel writer (see
+// IsParallelWriter). |size_function| returns the encoded size of an element
+// and |write_function| writes an element to the writer pointer it is given,
+// which is either |writer| or a BufferWriter over a region of its buffer.
+//
+// The elements are divided into tasks, the encoded size of each task is
+// computed in parallel, and the prefix sum of the sizes gives each task a
+// disjoint region of the output to write. The output is identical to writing
+// the elements in order.
+template <typename Iterator, typename Writer, typename SizeFunction,
+          typename WriteFunction>
+Status<void> WriteElementsInParallel(Iterator begin, std::size_t count,
+                                     Writer* writer,
+                                     SizeFunction size_function,
+                                     WriteFunction write_function) {
+  auto* executor = writer->executor();
+  const std::size_t task_count =
+      executor == nullptr
+          ? 0
+          : std::min<std::size_t>(
+                count / kParallelWriteGrain,
+                executor->concurrency() * kParallelTasksPerThread);
+
+  if (count < kParallelWriteThreshold || task_count <= 1) {
+    for (std::size_t i = 0; i < count; i++, ++begin) {
+      auto status = write_function(*begin, writer);
+      if (!status)
+        return status;
+    }
+    return {};
+  }
+
+  // Find the first element of each task. This is linear for containers
+  // without random access iterators, but cheap relative to encoding.
+  std::vector<Iterator> task_begins;
+  task_begins.reserve(task_count + 1);
+  task_begins.push_back(begin);
+  for (std::size_t i = 1; i <= task_count; i++) {
+    const std::size_t task_size =
+        count * i / task_count - count * (i - 1) / task_count;
+    task_begins.push_back(std::next(task_begins.back(), task_size));
+  }
+
+  std::vector<std::size_t> offsets(task_count + 1, 0);
+  executor->ParallelFor(task_count, [&](std::size_t task) {
+    std::size_t size = 0;
+    for (Iterator it = task_begins[task]; it != task_begins[task + 1]; ++it)
+      size += size_function(*it);
+    offsets[task + 1] = size;
+  });
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+  auto claim_status = writer->Claim(offsets.back());
+  if (!claim_status)
+    return claim_status.error();
+
+  std::uint8_t* const buffer = claim_status.get();
+  std::vector<ErrorStatus> errors(task_count, ErrorStatus::None);
+  executor->ParallelFor(task_count, [&](std::size_t task) {
+    const std::size_t task_size = offsets[task + 1] - offsets[task];
+    BufferWriter task_writer{buffer + offsets[task], task_size};
+    for (Iterator it = task_begins[task]; it != task_begins[task + 1]; ++it) {
+      auto status = write_function(*it, &task_writer);
+      if (!status) {
+        errors[task] = status.error();
+        return;
+      }
+    }
+
+    // Encoded sizes are exact; a mismatch indicates an inconsistent encoding.
+    if (task_writer.size() != task_size)
+      errors[task] = ErrorStatus::WriteLimitReached;
+  });
+
+  for (ErrorStatus error : errors) {
+    if (error != ErrorStatus::None)
+      return error;
+  }
+
+  writer->Commit(offsets.back());
+  return {};
+}
+
+// Reads |count| elements of type T from a parallel reader (see
+// IsParallelReader) into |value|, replacing its contents. The reader must be
+// positioned at the first element.
+//
+// The elements are first skipped structurally to find the offset of the first
+// element of each task. This scan also bounds the size of the vector by the
+// bytes actually present in the reader before any allocation is made. The
+// vector is then resized and each task decodes its elements in place from its
+// own region of the buffer. Errors are reported for the first failing task in
+// element order; the contents of |value| are unspecified on error.
+template <typename T, typename Allocator, typename Reader>
+Status<void> ReadElementsInParallel(std::size_t count,
+                                    std::vector<T, Allocator>* value,
+                                    Reader* reader) {
+  auto* executor = reader->executor();
+  const std::size_t task_count =
+      executor == nullptr
+          ? 0
+          : std::min<std::size_t>(
+                count / kParallelReadGrain,
+                executor->concurrency() * kParallelTasksPerThread);
+
+  if (count < kParallelReadThreshold || task_count <= 1) {
+    value->clear();
+    for (std::size_t i = 0; i < count; i++) {
+      T element;
+      auto status = Encoding<T>::Read(&element, reader);
+      if (!status)
+        return status;
+
+      value->push_back(std::move(element));
+    }
+    return {};
+  }
+
+  // Record the byte offset of the first element of each task, and the offset
+  // of the end of the last element.
+  const std::uint8_t* const buffer = reader->cursor();
+  BufferReader scan_reader{buffer, reader->remaining()};
+  std::vector<std::size_t> offsets;
+  offsets.reserve(task_count + 1);
+  for (std::size_t task = 0; task < task_count; task++) {
+    offsets.push_back(reader->remaining() - scan_reader.remaining());
+    const std::size_t task_size =
+        count * (task + 1) / task_count - count * task / task_count;
+    for (std::size_t i = 0; i < task_size; i++) {
+      auto status = SkipValue(&scan_reader);
+      if (!status)
+        return status;
+    }
+  }
+  offsets.push_back(reader->remaining() - scan_reader.remaining());
+
+  value->clear();
+  value->resize(count);
+
+  std::vector<ErrorStatus> errors(task_count, ErrorStatus::None);
+  executor->ParallelFor(task_count, [&](std::size_t task) {
+    BufferReader task_reader{buffer + offsets[task],
+                             offsets[task + 1] - offsets[task]};
+    const std::size_t end = count * (task + 1) / task_count;
+    for (std::size_t i = count * task / task_count; i < end; i++) {
+      auto status = Encoding<T>::Read(&(*value)[i], &task_reader);
+      if (!status) {
+        errors[task] = status.error();
+        return;
+      }
+    }
+
+    // Each element must decode from exactly the bytes found by the scan.
+    if (!task_reader.empty())
+      errors[task] = ErrorStatus::InvalidContainerLength;
+  });
+
+  for (ErrorStatus error : errors) {
+    if (error != ErrorStatus::None)
+      return error;
+  }
+
+  return reader->Skip(offsets.back());
+}
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_BASE_PARALLEL_H_
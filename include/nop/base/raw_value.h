@@ -0,0 +1,116 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_BASE_RAW_VALUE_H_
+#define LIBNOP_INCLUDE_NOP_BASE_RAW_VALUE_H_
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include <nop/base/encoding.h>
+#include <nop/base/skip.h>
+#include <nop/traits/is_contiguous_reader.h>
+#include <nop/types/raw_value.h>
+#include <nop/utility/capture_reader.h>
+
+namespace nop {
+
+//
+// RawValue encoding format:
+//
+// +-------+
+// | VALUE |
+// +-------+
+//
+// VALUE may be any complete encoding with a defined payload format. An empty
+// RawValue is encoded as NIL.
+//
+
+template <>
+struct Encoding<RawValue> : EncodingIO<RawValue> {
+  using Type = RawValue;
+
+  static EncodingByte Prefix(const Type& value) {
+    return value.empty() ? EncodingByte::Nil
+                         : static_cast<EncodingByte>(value.data()[0]);
+  }
+
+  static std::size_t Size(const Type& value) {
+    return value.empty() ? BaseEncodingSize(EncodingByte::Nil) : value.size();
+  }
+
+  static constexpr bool Match(EncodingByte prefix) {
+    return !(prefix >= EncodingByte::ReservedMin &&
+             prefix <= EncodingByte::ReservedMax) &&
+           prefix != EncodingByte::Extension;
+  }
+
+  template <typename Writer>
+  static constexpr Status<void> WritePayload(EncodingByte /*prefix*/,
+                                             const Type& value,
+                                             Writer* writer) {
+    if (value.empty())
+      return {};
+    else
+      return writer->Write(value.data() + 1, value.data() + value.size());
+  }
+
+  template <typename Reader>
+  static constexpr Status<void> ReadPayload(EncodingByte prefix, Type* value,
+                                            Reader* reader) {
+    return ReadPayload(prefix, value, reader, IsContiguousReader<Reader>{});
+  }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte prefix,
+                                                Reader* reader) {
+    return SkipPayload(prefix, reader);
+  }
+
+ private:
+  // Borrows the encoded value from the reader's buffer. The prefix byte was
+  // consumed by the reader immediately before the payload.
+  template <typename Reader>
+  static Status<void> ReadPayload(EncodingByte prefix, Type* value,
+                                  Reader* reader, std::true_type) {
+    const std::uint8_t* begin = reader->cursor() - 1;
+    auto status = SkipPayload(prefix, reader);
+    if (!status)
+      return status;
+
+    *value = Type::Borrow(begin, reader->cursor() - begin);
+    return {};
+  }
+
+  // Copies the encoded value out of the reader.
+  template <typename Reader>
+  static Status<void> ReadPayload(EncodingByte prefix, Type* value,
+                                  Reader* reader, std::false_type) {
+    std::vector<std::uint8_t> bytes{static_cast<std::uint8_t>(prefix)};
+    CaptureReader<Reader> capture_reader{reader, &bytes};
+    auto status = SkipPayload(prefix, &capture_reader);
+    if (!status)
+      return status;
+
+    *value = Type{std::move(bytes)};
+    return {};
+  }
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_BASE_RAW_VALUE_H_
@@ -54,6 +54,12 @@ struct Encoding<std::reference_wrapper<T>>
                                             Reader* reader) {
     return Encoding<T>::ReadPayload(prefix, &value->get(), reader);
   }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte prefix,
+                                                Reader* reader) {
+    return Encoding<T>::ValidatePayload(prefix, reader);
+  }
 };
 
 }  // namespace nop
@@ -88,6 +88,15 @@ struct Encoding<Result<ErrorEnum, T>> : EncodingIO<Result<ErrorEnum, T>> {
       return Encoding<T>::ReadPayload(prefix, &value->get(), reader);
     }
   }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte prefix,
+                                                Reader* reader) {
+    if (prefix == EncodingByte::Error)
+      return Encoding<ErrorEnum>::Validate(reader);
+    else
+      return Encoding<T>::ValidatePayload(prefix, reader);
+  }
 };
 
 template <typename T>
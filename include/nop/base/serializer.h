@@ -17,9 +17,12 @@
 #ifndef LIBNOP_INCLUDE_NOP_BASE_SERIALIZER_H_
 #define LIBNOP_INCLUDE_NOP_BASE_SERIALIZER_H_
 
+#include <iterator>
 #include <memory>
+#include <type_traits>
 
 #include <nop/base/encoding.h>
+#include <nop/base/frame.h>
 #include <nop/status.h>
 
 namespace nop {
@@ -48,7 +51,12 @@ namespace nop {
 // deserialization tasks.
 //
 
-// Implementation of Write method common to all Serializer specializations.
+// Selects whether the values written by WriteBatch() and read by ReadBatch()
+// are each wrapped in a frame (see base/frame.h). Framed batches may be split
+// into individual values without decoding them, for example by BatchDecoder.
+enum class BatchFraming { None, Framed };
+
+// Implementation of Write methods common to all Serializer specializations.
 struct SerializerCommon {
   template <typename T, typename Writer>
   static constexpr Status<void> Write(const T& value, Writer* writer) {
@@ -63,6 +71,62 @@ struct SerializerCommon {
     // Serialize the data to the writer.
     return Encoding<T>::Write(value, writer);
   }
+
+  template <typename Range, typename Writer>
+  static Status<void> WriteBatch(const Range& values, BatchFraming framing,
+                                 Writer* writer) {
+    using T = std::decay_t<decltype(*std::begin(values))>;
+    const bool framed = framing == BatchFraming::Framed;
+
+    // Prepare the writer once for the entire batch.
+    std::size_t size_bytes = 0;
+    for (const T& value : values)
+      size_bytes += framed ? FrameSize(value) : Encoding<T>::Size(value);
+
+    auto status = writer->Prepare(size_bytes);
+    if (!status)
+      return status;
+
+    if (framed) {
+      for (const T& value : values) {
+        status = WriteFrame(value, writer);
+        if (!status)
+          return status;
+      }
+    } else {
+      for (const T& value : values) {
+        status = Encoding<T>::Write(value, writer);
+        if (!status)
+          return status;
+      }
+    }
+
+    return {};
+  }
+};
+
+// Implementation of ReadBatch method common to all Deserializer
+// specializations.
+struct DeserializerCommon {
+  template <typename T, typename Reader>
+  static Status<void> ReadBatch(T* values, std::size_t count,
+                                BatchFraming framing, Reader* reader) {
+    if (framing == BatchFraming::Framed) {
+      for (std::size_t i = 0; i < count; i++) {
+        auto status = ReadFrame(&values[i], reader);
+        if (!status)
+          return status;
+      }
+    } else {
+      for (std::size_t i = 0; i < count; i++) {
+        auto status = Encoding<T>::Read(&values[i], reader);
+        if (!status)
+          return status;
+      }
+    }
+
+    return {};
+  }
 };
 
 // Serializer with internal instance of Writer.
@@ -88,6 +152,14 @@ class Serializer {
     return SerializerCommon::Write(value, &writer_);
   }
 
+  // Serializes each value in |values| to the Writer, preparing the Writer once
+  // for the entire batch.
+  template <typename Range>
+  Status<void> WriteBatch(const Range& values,
+                          BatchFraming framing = BatchFraming::None) {
+    return SerializerCommon::WriteBatch(values, framing, &writer_);
+  }
+
   constexpr const Writer& writer() const { return writer_; }
   constexpr Writer& writer() { return writer_; }
   constexpr Writer&& take() { return std::move(writer_); }
@@ -121,6 +193,14 @@ class Serializer<Writer*> {
     return SerializerCommon::Write(value, writer_);
   }
 
+  // Serializes each value in |values| to the Writer, preparing the Writer once
+  // for the entire batch.
+  template <typename Range>
+  Status<void> WriteBatch(const Range& values,
+                          BatchFraming framing = BatchFraming::None) {
+    return SerializerCommon::WriteBatch(values, framing, writer_);
+  }
+
   constexpr const Writer& writer() const { return *writer_; }
   constexpr Writer& writer() { return *writer_; }
 
@@ -151,6 +231,14 @@ class Serializer<std::unique_ptr<Writer>> {
     return SerializerCommon::Write(value, writer_.get());
   }
 
+  // Serializes each value in |values| to the Writer, preparing the Writer once
+  // for the entire batch.
+  template <typename Range>
+  Status<void> WriteBatch(const Range& values,
+                          BatchFraming framing = BatchFraming::None) {
+    return SerializerCommon::WriteBatch(values, framing, writer_.get());
+  }
+
   constexpr const Writer& writer() const { return *writer_; }
   constexpr Writer& writer() { return *writer_; }
 
@@ -178,6 +266,20 @@ class Deserializer {
     return Encoding<T>::Read(value, &reader_);
   }
 
+  // Checks that the next value in the reader is a well-formed encoding of T
+  // and skips over it, without deserializing it.
+  template <typename T>
+  constexpr Status<void> Validate() {
+    return Encoding<T>::Validate(&reader_);
+  }
+
+  // Deserializes |count| consecutive values from the reader into |values|.
+  template <typename T>
+  Status<void> ReadBatch(T* values, std::size_t count,
+                         BatchFraming framing = BatchFraming::None) {
+    return DeserializerCommon::ReadBatch(values, count, framing, &reader_);
+  }
+
   constexpr const Reader& reader() const { return reader_; }
   constexpr Reader& reader() { return reader_; }
   constexpr Reader&& take() { return std::move(reader_); }
@@ -204,6 +306,20 @@ class Deserializer<Reader*> {
     return Encoding<T>::Read(value, reader_);
   }
 
+  // Checks that the next value in the reader is a well-formed encoding of T
+  // and skips over it, without deserializing it.
+  template <typename T>
+  constexpr Status<void> Validate() {
+    return Encoding<T>::Validate(reader_);
+  }
+
+  // Deserializes |count| consecutive values from the reader into |values|.
+  template <typename T>
+  Status<void> ReadBatch(T* values, std::size_t count,
+                         BatchFraming framing = BatchFraming::None) {
+    return DeserializerCommon::ReadBatch(values, count, framing, reader_);
+  }
+
   constexpr const Reader& reader() const { return *reader_; }
   constexpr Reader& reader() { return *reader_; }
 
@@ -227,6 +343,20 @@ class Deserializer<std::unique_ptr<Reader>> {
     return Encoding<T>::Read(value, reader_.get());
   }
 
+  // Checks that the next value in the reader is a well-formed encoding of T
+  // and skips over it, without deserializing it.
+  template <typename T>
+  constexpr Status<void> Validate() {
+    return Encoding<T>::Validate(reader_.get());
+  }
+
+  // Deserializes |count| consecutive values from the reader into |values|.
+  template <typename T>
+  Status<void> ReadBatch(T* values, std::size_t count,
+                         BatchFraming framing = BatchFraming::None) {
+    return DeserializerCommon::ReadBatch(values, count, framing, reader_.get());
+  }
+
   constexpr const Reader& reader() const { return *reader_; }
   constexpr Reader& reader() { return *reader_; }
 
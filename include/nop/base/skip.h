@@ -0,0 +1,213 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_BASE_SKIP_H_
+#define LIBNOP_INCLUDE_NOP_BASE_SKIP_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <nop/base/encoding.h>
+#include <nop/status.h>
+#include <nop/types/handle.h>
+
+namespace nop {
+
+//
+// Structural skipping of encoded values.
+//
+// SkipValue() and SkipPayload() advance a reader past exactly one encoded
+// value without decoding it into a C++ type. Only the structure of the encoding
+// is examined: container lengths and element counts are read and followed, but
+// the types of the elements are not checked against any high-level protocol
+// definition. This is the same information the table encoding relies on to skip
+// unknown entries, generalized to every base encoding.
+//
+// Sized payloads (strings, binary containers, and table entries) are predicated
+// on Reader::Ensure() before skipping, matching the convention of the string
+// and binary container decoders.
+//
+// The extension prefix and the reserved prefix range have no defined payload
+// format and result in ErrorStatus::UnexpectedEncodingType.
+//
+
+// Maximum container nesting depth followed by SkipValue() before returning
+// ErrorStatus::InvalidContainerLength. The skipper is recursive, unlike the
+// type-directed decoders whose recursion is bounded by the C++ types involved,
+// so the depth is capped to avoid exhausting the stack on hostile input.
+enum : std::size_t { kMaxSkipDepth = 128 };
+
+template <typename Reader>
+Status<void> SkipValue(Reader* reader, std::size_t depth = kMaxSkipDepth);
+
+// Skips the payload that follows |prefix|, which must already have been read
+// from |reader|.
+template <typename Reader>
+Status<void> SkipPayload(EncodingByte prefix, Reader* reader,
+                         std::size_t depth = kMaxSkipDepth) {
+  if ((prefix >= EncodingByte::PositiveFixIntMin &&
+       prefix <= EncodingByte::PositiveFixIntMax) ||
+      (prefix >= EncodingByte::NegativeFixIntMin &&
+       prefix <= EncodingByte::NegativeFixIntMax)) {
+    return {};
+  }
+
+  switch (prefix) {
+    case EncodingByte::U8:
+    case EncodingByte::I8:
+    case EncodingByte::U16:
+    case EncodingByte::I16:
+    case EncodingByte::U32:
+    case EncodingByte::I32:
+    case EncodingByte::F32:
+    case EncodingByte::U64:
+    case EncodingByte::I64:
+    case EncodingByte::F64: {
+      const std::size_t size = BaseEncodingSize(prefix) - 1;
+      auto status = reader->Ensure(size);
+      if (!status)
+        return status;
+
+      return reader->Skip(size);
+    }
+
+    case EncodingByte::Nil:
+      return {};
+
+    case EncodingByte::Binary:
+    case EncodingByte::String: {
+      SizeType size = 0;
+      auto status = Encoding<SizeType>::Read(&size, reader);
+      if (!status)
+        return status;
+
+      status = reader->Ensure(size);
+      if (!status)
+        return status;
+
+      return reader->Skip(size);
+    }
+
+    case EncodingByte::Array:
+    case EncodingByte::Structure:
+    case EncodingByte::Map: {
+      if (depth == 0)
+        return ErrorStatus::InvalidContainerLength;
+
+      SizeType count = 0;
+      auto status = Encoding<SizeType>::Read(&count, reader);
+      if (!status)
+        return status;
+
+      // Maps have two encoded values per element.
+      const std::size_t values_per_element =
+          prefix == EncodingByte::Map ? 2 : 1;
+      for (SizeType i = 0; i < count; i++) {
+        for (std::size_t j = 0; j < values_per_element; j++) {
+          status = SkipValue(reader, depth - 1);
+          if (!status)
+            return status;
+        }
+      }
+      return {};
+    }
+
+    case EncodingByte::Variant: {
+      if (depth == 0)
+        return ErrorStatus::InvalidContainerLength;
+
+      std::int64_t index = 0;
+      auto status = Encoding<std::int64_t>::Read(&index, reader);
+      if (!status)
+        return status;
+
+      return SkipValue(reader, depth - 1);
+    }
+
+    case EncodingByte::Error:
+      if (depth == 0)
+        return ErrorStatus::InvalidContainerLength;
+      else
+        return SkipValue(reader, depth - 1);
+
+    case EncodingByte::Handle: {
+      if (depth == 0)
+        return ErrorStatus::InvalidContainerLength;
+
+      auto status = SkipValue(reader, depth - 1);
+      if (!status)
+        return status;
+
+      HandleReference handle_reference = kEmptyHandleReference;
+      return Encoding<HandleReference>::Read(&handle_reference, reader);
+    }
+
+    case EncodingByte::Table: {
+      std::uint64_t hash = 0;
+      auto status = Encoding<std::uint64_t>::Read(&hash, reader);
+      if (!status)
+        return status;
+
+      SizeType count = 0;
+      status = Encoding<SizeType>::Read(&count, reader);
+      if (!status)
+        return status;
+
+      // Entries are wrapped in sized binary containers and never need to be
+      // parsed to be skipped.
+      for (SizeType i = 0; i < count; i++) {
+        std::uint64_t id = 0;
+        status = Encoding<std::uint64_t>::Read(&id, reader);
+        if (!status)
+          return status;
+
+        SizeType size = 0;
+        status = Encoding<SizeType>::Read(&size, reader);
+        if (!status)
+          return status;
+
+        status = reader->Ensure(size);
+        if (!status)
+          return status;
+
+        status = reader->Skip(size);
+        if (!status)
+          return status;
+      }
+      return {};
+    }
+
+    /* case EncodingByte::ReservedMin ... EncodingByte::ReservedMax: */
+    case EncodingByte::Extension:
+    default:
+      return ErrorStatus::UnexpectedEncodingType;
+  }
+}
+
+// Skips one complete encoded value, including its prefix, from |reader|.
+template <typename Reader>
+Status<void> SkipValue(Reader* reader, std::size_t depth) {
+  std::uint8_t prefix_byte = 0;
+  auto status = reader->Read(&prefix_byte);
+  if (!status)
+    return status;
+
+  return SkipPayload(static_cast<EncodingByte>(prefix_byte), reader, depth);
+}
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_BASE_SKIP_H_
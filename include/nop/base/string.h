@@ -85,6 +85,23 @@ struct Encoding<std::basic_string<CharType, Traits, Allocator>>
     value->resize(size);
     return reader->Read(&(*value)[0], &(*value)[size]);
   }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* reader) {
+    SizeType length_bytes = 0;
+    auto status = Encoding<SizeType>::Read(&length_bytes, reader);
+    if (!status)
+      return status;
+    else if (length_bytes % CharSize != 0)
+      return ErrorStatus::InvalidStringLength;
+
+    status = reader->Ensure(length_bytes);
+    if (!status)
+      return status;
+
+    return reader->Skip(length_bytes);
+  }
 };
 
 }  // namespace nop
@@ -0,0 +1,228 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_BASE_STRUCTURE_COLUMNS_H_
+#define LIBNOP_INCLUDE_NOP_BASE_STRUCTURE_COLUMNS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+#include <nop/base/encoding.h>
+#include <nop/base/utility.h>
+#include <nop/types/detail/member_pointer.h>
+#include <nop/types/structure_columns.h>
+
+namespace nop {
+
+//
+// StructureColumns<T> encoding format:
+//
+// +-----+---------+-----//-----+
+// | ARY | INT64:N | N ELEMENTS |
+// +-----+---------+-----//-----+
+//
+// Each element is encoded as a structure of type T, formed from the values at
+// the same index in each column:
+//
+// +-----+---------+-----//----+
+// | STC | INT64:M | M MEMBERS |
+// +-----+---------+-----//----+
+//
+// The encoding is the same as std::vector<T>.
+//
+
+template <typename T>
+struct Encoding<StructureColumns<T>> : EncodingIO<StructureColumns<T>> {
+  using Type = StructureColumns<T>;
+
+  static constexpr EncodingByte Prefix(const Type& /*value*/) {
+    return EncodingByte::Array;
+  }
+
+  static constexpr std::size_t Size(const Type& value) {
+    const std::size_t size = value.size();
+    return BaseEncodingSize(Prefix(value)) + Encoding<SizeType>::Size(size) +
+           size * (BaseEncodingSize(EncodingByte::Structure) +
+                   Encoding<SizeType>::Size(Count)) +
+           ColumnsSize(value, Index<Count>{});
+  }
+
+  static constexpr bool Match(EncodingByte prefix) {
+    return prefix == EncodingByte::Array;
+  }
+
+  template <typename Writer>
+  static constexpr Status<void> WritePayload(EncodingByte /*prefix*/,
+                                             const Type& value,
+                                             Writer* writer) {
+    const std::size_t size = value.size();
+    if (!SizesMatch(value, size, Index<Count>{}))
+      return ErrorStatus::InvalidContainerLength;
+
+    auto status = Encoding<SizeType>::Write(size, writer);
+    if (!status)
+      return status;
+
+    for (std::size_t i = 0; i < size; i++) {
+      status =
+          writer->Write(static_cast<std::uint8_t>(EncodingByte::Structure));
+      if (!status)
+        return status;
+
+      status = Encoding<SizeType>::Write(Count, writer);
+      if (!status)
+        return status;
+
+      status = WriteMembers(value, i, writer, Index<Count>{});
+      if (!status)
+        return status;
+    }
+
+    return {};
+  }
+
+  template <typename Reader>
+  static constexpr Status<void> ReadPayload(EncodingByte /*prefix*/,
+                                            Type* value, Reader* reader) {
+    SizeType size = 0;
+    auto status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+
+    // Every element occupies at least one byte. Make sure the reader has that
+    // much data before sizing the columns as a defense against abusive or
+    // erroneous sizes.
+    status = reader->Ensure(size);
+    if (!status)
+      return status;
+
+    value->resize(size);
+    for (SizeType i = 0; i < size; i++) {
+      std::uint8_t prefix = 0;
+      status = reader->Read(&prefix);
+      if (!status)
+        return status;
+      else if (prefix != static_cast<std::uint8_t>(EncodingByte::Structure))
+        return ErrorStatus::UnexpectedEncodingType;
+
+      SizeType count = 0;
+      status = Encoding<SizeType>::Read(&count, reader);
+      if (!status)
+        return status;
+      else if (count != Count)
+        return ErrorStatus::InvalidMemberCount;
+
+      status = ReadMembers(value, i, reader, Index<Count>{});
+      if (!status)
+        return status;
+    }
+
+    return {};
+  }
+
+ private:
+  enum : std::size_t { Count = Type::ColumnCount };
+
+  template <std::size_t I>
+  using MemberType = typename Type::template ColumnType<I>::value_type;
+
+  static constexpr bool SizesMatch(const Type& /*value*/, std::size_t /*size*/,
+                                   Index<0>) {
+    return true;
+  }
+
+  template <std::size_t index>
+  static constexpr bool SizesMatch(const Type& value, std::size_t size,
+                                   Index<index>) {
+    return SizesMatch(value, size, Index<index - 1>{}) &&
+           value.template column<index - 1>().size() == size;
+  }
+
+  static constexpr std::size_t ColumnsSize(const Type& /*value*/, Index<0>) {
+    return 0;
+  }
+
+  // Sums the sizes of the members column by column. Columns that are longer
+  // than the first column fail to write, but are still sized safely.
+  template <std::size_t index>
+  static constexpr std::size_t ColumnsSize(const Type& value, Index<index>) {
+    using Member = MemberType<index - 1>;
+    std::size_t size = ColumnsSize(value, Index<index - 1>{});
+    for (const Member& member : value.template column<index - 1>())
+      size += Encoding<Member>::Size(member);
+    return size;
+  }
+
+  template <typename Writer>
+  static constexpr Status<void> WriteMembers(const Type& /*value*/,
+                                             std::size_t /*i*/,
+                                             Writer* /*writer*/, Index<0>) {
+    return {};
+  }
+
+  template <std::size_t index, typename Writer>
+  static constexpr Status<void> WriteMembers(const Type& value, std::size_t i,
+                                             Writer* writer, Index<index>) {
+    auto status = WriteMembers(value, i, writer, Index<index - 1>{});
+    if (!status)
+      return status;
+    else
+      return Encoding<MemberType<index - 1>>::Write(
+          value.template column<index - 1>()[i], writer);
+  }
+
+  template <typename Reader>
+  static constexpr Status<void> ReadMembers(Type* /*value*/, std::size_t /*i*/,
+                                            Reader* /*reader*/, Index<0>) {
+    return {};
+  }
+
+  template <std::size_t index, typename Reader>
+  static constexpr Status<void> ReadMembers(Type* value, std::size_t i,
+                                            Reader* reader, Index<index>) {
+    auto status = ReadMembers(value, i, reader, Index<index - 1>{});
+    if (!status)
+      return status;
+    else
+      return ReadMember(&value->template column<index - 1>(), i, reader);
+  }
+
+  // Decodes the member directly into its column.
+  template <typename Column, typename Reader>
+  static Status<void> ReadMember(Column* column, std::size_t i,
+                                 Reader* reader) {
+    return Encoding<typename Column::value_type>::Read(&(*column)[i], reader);
+  }
+
+  // std::vector<bool> does not provide addressable elements.
+  template <typename Allocator, typename Reader>
+  static Status<void> ReadMember(std::vector<bool, Allocator>* column,
+                                 std::size_t i, Reader* reader) {
+    bool member = false;
+    auto status = Encoding<bool>::Read(&member, reader);
+    if (!status)
+      return status;
+
+    (*column)[i] = member;
+    return {};
+  }
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_BASE_STRUCTURE_COLUMNS_H_
@@ -17,12 +17,19 @@
 #ifndef LIBNOP_INCLUDE_NOP_BASE_TABLE_H_
 #define LIBNOP_INCLUDE_NOP_BASE_TABLE_H_
 
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
 #include <nop/base/encoding.h>
 #include <nop/base/members.h>
 #include <nop/base/utility.h>
 #include <nop/table.h>
+#include <nop/traits/is_contiguous_reader.h>
 #include <nop/utility/bounded_reader.h>
 #include <nop/utility/bounded_writer.h>
+#include <nop/utility/capture_reader.h>
 
 namespace nop {
 
@@ -58,6 +65,14 @@ namespace nop {
 // active entries in the table. Older code may encounter unknown entry ids when
 // reading data from newer table definitions.
 //
+// UnknownEntries encoding format:
+//
+// +----------+------------+--------------+
+// | INT64:ID | INT64:SIZE | OPAQUE BYTES |
+// +----------+------------+--------------+
+//
+// Repeated for each unknown entry held. Unknown entries are counted in N.
+//
 
 template <typename Table>
 struct Encoding<Table, EnableIfHasEntryList<Table>> : EncodingIO<Table> {
@@ -116,6 +131,38 @@ struct Encoding<Table, EnableIfHasEntryList<Table>> : EncodingIO<Table> {
     return ReadEntries(value, count, reader);
   }
 
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* reader) {
+    std::uint64_t hash = 0;
+    auto status = Encoding<std::uint64_t>::Read(&hash, reader);
+    if (!status)
+      return status;
+    else if (hash != EntryListTraits<Table>::EntryList::Hash)
+      return ErrorStatus::InvalidTableHash;
+
+    SizeType count = 0;
+    status = Encoding<SizeType>::Read(&count, reader);
+    if (!status)
+      return status;
+
+    // Tracks the active entries encountered so far to detect duplicates, as
+    // ReadPayload() does by clearing the destination entries.
+    std::array<bool, Count> seen{};
+    for (SizeType i = 0; i < count; i++) {
+      std::uint64_t id = 0;
+      status = Encoding<std::uint64_t>::Read(&id, reader);
+      if (!status)
+        return status;
+
+      status = ValidateEntryForId(&seen, id, reader, Index<Count>{});
+      if (!status)
+        return status;
+    }
+
+    return {};
+  }
+
  private:
   enum : std::size_t { Count = EntryListTraits<Table>::EntryList::Count };
 
@@ -132,8 +179,29 @@ struct Encoding<Table, EnableIfHasEntryList<Table>> : EncodingIO<Table> {
   static constexpr std::size_t ActiveEntryCount(const Table& value,
                                                 Index<index>) {
     using Pointer = PointerAt<index - 1>;
-    const std::size_t count = Pointer::Resolve(value) ? 1 : 0;
-    return ActiveEntryCount(value, Index<index - 1>{}) + count;
+    return ActiveEntryCount(value, Index<index - 1>{}) +
+           EntryCount(Pointer::Resolve(value));
+  }
+
+  template <typename T, std::uint64_t Id, typename Kind>
+  static constexpr std::size_t EntryCount(const Entry<T, Id, Kind>& entry) {
+    return entry ? 1 : 0;
+  }
+
+  static std::size_t EntryCount(const UnknownEntries& entries) {
+    return entries.size();
+  }
+
+  // Returns true if the given member is the entry with the given id.
+  template <typename T, std::uint64_t Id, typename Kind>
+  static constexpr bool HasId(const Entry<T, Id, Kind>* /*entry*/,
+                              std::uint64_t id) {
+    return Id == id;
+  }
+
+  static constexpr bool HasId(const UnknownEntries* /*entries*/,
+                              std::uint64_t /*id*/) {
+    return false;
   }
 
   template <typename T, std::uint64_t Id>
@@ -153,6 +221,15 @@ struct Encoding<Table, EnableIfHasEntryList<Table>> : EncodingIO<Table> {
     return 0;
   }
 
+  static std::size_t Size(const UnknownEntries& entries) {
+    std::size_t size = 0;
+    for (const auto& item : entries) {
+      size += Encoding<std::uint64_t>::Size(item.id) +
+              Encoding<SizeType>::Size(item.bytes.size()) + item.bytes.size();
+    }
+    return size;
+  }
+
   static constexpr std::size_t Size(const Table& /*value*/, Index<0>) {
     return 0;
   }
@@ -210,6 +287,26 @@ struct Encoding<Table, EnableIfHasEntryList<Table>> : EncodingIO<Table> {
     return {};
   }
 
+  template <typename Writer>
+  static Status<void> WriteEntry(const UnknownEntries& entries,
+                                 Writer* writer) {
+    for (const auto& item : entries) {
+      auto status = Encoding<std::uint64_t>::Write(item.id, writer);
+      if (!status)
+        return status;
+
+      status = Encoding<SizeType>::Write(item.bytes.size(), writer);
+      if (!status)
+        return status;
+
+      status = writer->Write(item.bytes.data(),
+                             item.bytes.data() + item.bytes.size());
+      if (!status)
+        return status;
+    }
+    return {};
+  }
+
   template <typename Writer>
   static constexpr Status<void> WriteEntries(const Table& /*value*/,
                                              Writer* /*writer*/, Index<0>) {
@@ -273,24 +370,179 @@ struct Encoding<Table, EnableIfHasEntryList<Table>> : EncodingIO<Table> {
     return SkipEntry(reader);
   }
 
+  // UnknownEntries never matches an id; see ReadUnknownEntry below.
   template <typename Reader>
-  static constexpr Status<void> ReadEntryForId(Table* /*value*/,
-                                               std::uint64_t /*id*/,
-                                               Reader* reader, Index<0>) {
+  static constexpr Status<void> ReadEntry(UnknownEntries* /*entries*/,
+                                          Reader* reader) {
     return SkipEntry(reader);
   }
 
+  template <typename Reader>
+  static constexpr Status<void> ReadEntryForId(Table* value, std::uint64_t id,
+                                               Reader* reader, Index<0>) {
+    return ReadUnknownEntry(value, id, reader, Index<Count>{});
+  }
+
   template <typename Reader, std::size_t index>
   static constexpr Status<void> ReadEntryForId(Table* value, std::uint64_t id,
                                                Reader* reader, Index<index>) {
     using Pointer = PointerAt<index - 1>;
-    using Type = typename Pointer::Type;
-    if (Type::Id == id)
+    if (HasId(Pointer::Resolve(value), id))
       return ReadEntry(Pointer::Resolve(value), reader);
     else
       return ReadEntryForId(value, id, reader, Index<index - 1>{});
   }
 
+  // Stores an entry with an unrecognized id in the UnknownEntries member of the
+  // table, if there is one. Otherwise the entry is skipped.
+  template <typename Reader>
+  static constexpr Status<void> ReadUnknownEntry(Table* /*value*/,
+                                                 std::uint64_t /*id*/,
+                                                 Reader* reader, Index<0>) {
+    return SkipEntry(reader);
+  }
+
+  template <typename Reader, std::size_t index>
+  static constexpr Status<void> ReadUnknownEntry(Table* value, std::uint64_t id,
+                                                 Reader* reader, Index<index>) {
+    using Pointer = PointerAt<index - 1>;
+    using Type = typename Pointer::Type;
+    return ReadUnknownEntry(value, id, reader, Index<index - 1>{},
+                            std::is_same<Type, UnknownEntries>{});
+  }
+
+  template <typename Reader, std::size_t index>
+  static constexpr Status<void> ReadUnknownEntry(Table* value, std::uint64_t id,
+                                                 Reader* reader, Index<index>,
+                                                 std::false_type) {
+    return ReadUnknownEntry(value, id, reader, Index<index>{});
+  }
+
+  template <typename Reader, std::size_t index>
+  static Status<void> ReadUnknownEntry(Table* value, std::uint64_t id,
+                                       Reader* reader, Index<index>,
+                                       std::true_type) {
+    using Pointer = PointerAt<index>;
+    SizeType size = 0;
+    auto status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+
+    status = reader->Ensure(size);
+    if (!status)
+      return status;
+
+    RawValue bytes;
+    status =
+        ReadUnknownBytes(size, &bytes, reader, IsContiguousReader<Reader>{});
+    if (!status)
+      return status;
+
+    Pointer::Resolve(value)->Add(id, std::move(bytes));
+    return {};
+  }
+
+  // Borrows the entry bytes from the reader's buffer.
+  template <typename Reader>
+  static Status<void> ReadUnknownBytes(SizeType size, RawValue* bytes,
+                                       Reader* reader, std::true_type) {
+    const std::uint8_t* begin = reader->cursor();
+    auto status = reader->Skip(size);
+    if (!status)
+      return status;
+
+    *bytes = RawValue::Borrow(begin, size);
+    return {};
+  }
+
+  // Copies the entry bytes out of the reader.
+  template <typename Reader>
+  static Status<void> ReadUnknownBytes(SizeType size, RawValue* bytes,
+                                       Reader* reader, std::false_type) {
+    std::vector<std::uint8_t> storage;
+    CaptureReader<Reader> capture_reader{reader, &storage};
+    auto status = capture_reader.Skip(size);
+    if (!status)
+      return status;
+
+    *bytes = RawValue{std::move(storage)};
+    return {};
+  }
+
+  // Validates the binary container of an entry and, for active entries, the
+  // encoding of the value inside of it.
+  template <typename T, std::uint64_t Id, typename Reader>
+  static constexpr Status<void> ValidateEntry(
+      const Entry<T, Id, ActiveEntry>* /*entry*/, bool* seen, Reader* reader) {
+    if (*seen)
+      return ErrorStatus::DuplicateTableEntry;
+    *seen = true;
+
+    SizeType size = 0;
+    auto status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+
+    status = reader->Ensure(size);
+    if (!status)
+      return status;
+
+    BoundedReader<Reader> bounded_reader{reader, size};
+    status = Encoding<T>::Validate(&bounded_reader);
+    if (!status)
+      return status;
+
+    return bounded_reader.ReadPadding();
+  }
+
+  template <typename T, std::uint64_t Id, typename Reader>
+  static constexpr Status<void> ValidateEntry(
+      const Entry<T, Id, DeletedEntry>* /*entry*/, bool* /*seen*/,
+      Reader* reader) {
+    return ValidateUnknownEntry(reader);
+  }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidateEntry(const UnknownEntries* /*entries*/,
+                                              bool* /*seen*/, Reader* reader) {
+    return ValidateUnknownEntry(reader);
+  }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidateUnknownEntry(Reader* reader) {
+    SizeType size = 0;
+    auto status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+
+    status = reader->Ensure(size);
+    if (!status)
+      return status;
+
+    return reader->Skip(size);
+  }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidateEntryForId(
+      std::array<bool, Count>* /*seen*/, std::uint64_t /*id*/, Reader* reader,
+      Index<0>) {
+    return ValidateUnknownEntry(reader);
+  }
+
+  template <typename Reader, std::size_t index>
+  static constexpr Status<void> ValidateEntryForId(
+      std::array<bool, Count>* seen, std::uint64_t id, Reader* reader,
+      Index<index>) {
+    using Pointer = PointerAt<index - 1>;
+    using Type = typename Pointer::Type;
+    const Type* entry = nullptr;
+    if (HasId(entry, id)) {
+      return ValidateEntry(entry, &(*seen)[index - 1], reader);
+    } else {
+      return ValidateEntryForId(seen, id, reader, Index<index - 1>{});
+    }
+  }
+
   template <typename Reader>
   static constexpr Status<void> ReadEntries(Table* value, SizeType count,
                                             Reader* reader) {
@@ -75,6 +75,19 @@ struct Encoding<std::tuple<Types...>> : EncodingIO<std::tuple<Types...>> {
       return ReadElements(value, reader, Index<sizeof...(Types)>{});
   }
 
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* reader) {
+    SizeType size = 0;
+    auto status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+    else if (size != sizeof...(Types))
+      return ErrorStatus::InvalidContainerLength;
+    else
+      return ValidateElements(reader, Index<sizeof...(Types)>{});
+  }
+
  private:
   template <std::size_t Index>
   using ElementType = std::remove_cv_t<
@@ -126,6 +139,20 @@ struct Encoding<std::tuple<Types...>> : EncodingIO<std::tuple<Types...>> {
     return Encoding<ElementType<index - 1>>::Read(&std::get<index - 1>(*value),
                                                   reader);
   }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidateElements(Reader* /*reader*/, Index<0>) {
+    return {};
+  }
+
+  template <std::size_t index, typename Reader>
+  static constexpr Status<void> ValidateElements(Reader* reader, Index<index>) {
+    auto status = ValidateElements(reader, Index<index - 1>{});
+    if (!status)
+      return status;
+
+    return Encoding<ElementType<index - 1>>::Validate(reader);
+  }
 };
 
 }  // namespace nop
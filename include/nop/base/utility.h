@@ -17,7 +17,9 @@
 #ifndef LIBNOP_INCLUDE_NOP_BASE_UTILITY_H_
 #define LIBNOP_INCLUDE_NOP_BASE_UTILITY_H_
 
+#include <array>
 #include <cstddef>
+#include <memory>
 #include <type_traits>
 
 #include <nop/traits/is_template_base_of.h>
@@ -135,6 +137,31 @@ struct Or<A, B> : std::integral_constant<bool, A::value || B::value> {};
 template <typename A, typename B, typename... Rest>
 struct Or<A, B, Rest...> : Or<A, Or<B, Rest...>> {};
 
+// Trait to determine whether T is an allocator-aware type that may be
+// constructed from a copy of Allocator (uses-allocator construction). This is
+// used to allocate the temporary elements of a container from the allocator of
+// the container being decoded.
+template <typename T, typename Allocator>
+struct IsAllocatorConstructible
+    : And<std::uses_allocator<T, Allocator>,
+          std::is_constructible<T, const Allocator&>> {};
+
+// Returns a value-initialized T, using uses-allocator construction with
+// |allocator| when T supports it.
+template <typename T, typename Allocator>
+T MakeWithAllocator(const Allocator& allocator, std::true_type) {
+  return T(allocator);
+}
+template <typename T, typename Allocator>
+T MakeWithAllocator(const Allocator& /*allocator*/, std::false_type) {
+  return T{};
+}
+template <typename T, typename Allocator>
+T MakeWithAllocator(const Allocator& allocator) {
+  return MakeWithAllocator<T>(allocator,
+                              IsAllocatorConstructible<T, Allocator>{});
+}
+
 // Utility to determine whether a set of one or more types is a true set,
 // containing no duplicates, according to the given comparison template. The
 // comparison template must accept two type arguments and evaluate to true if
@@ -63,6 +63,12 @@ struct Encoding<T, EnableIfIsValueWrapper<T>> : EncodingIO<T> {
                                             Reader* reader) {
     return Pointer::ReadPayload(prefix, value, reader, MemberList{});
   }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte prefix,
+                                                Reader* reader) {
+    return Pointer::ValidatePayload(prefix, reader, MemberList{});
+  }
 };
 
 }  // namespace nop
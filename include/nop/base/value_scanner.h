@@ -0,0 +1,369 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_BASE_VALUE_SCANNER_H_
+#define LIBNOP_INCLUDE_NOP_BASE_VALUE_SCANNER_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <nop/base/encoding.h>
+#include <nop/base/skip.h>
+#include <nop/status.h>
+
+namespace nop {
+
+//
+// ValueScanner is the incremental counterpart of SkipValue(). It finds the end
+// of one complete encoded value in a stream of bytes that arrives in arbitrary
+// pieces, such as the reads from a non-blocking socket.
+//
+// The position of the scan, including the nesting of arrays, maps, structures,
+// tables, variants, and handles, is kept on an explicit stack instead of the
+// call stack, so that scanning can stop at the end of any piece and continue
+// with the next piece without examining any byte twice. Like SkipValue(), only
+// the structure of the encoding is examined and the nesting depth is limited to
+// kMaxSkipDepth.
+//
+// Example of finding the end of a value received in two pieces:
+//
+//   ValueScanner scanner;
+//   auto status = scanner.Scan(first_piece, first_size);
+//   // status.get() == first_size, scanner.done() == false.
+//   status = scanner.Scan(second_piece, second_size);
+//   // scanner.done() == true if the value is complete; status.get() is the
+//   // number of bytes of the second piece that belong to the value.
+//
+class ValueScanner {
+ public:
+  ValueScanner() = default;
+
+  // Returns true when the end of the value has been reached.
+  bool done() const { return done_; }
+
+  // Prepares the scanner to scan another value.
+  void Reset() {
+    stack_.clear();
+    state_ = State::Prefix;
+    skip_entry_ = false;
+    done_ = false;
+  }
+
+  // Scans the given bytes, continuing from the position reached by the previous
+  // call. Returns the number of bytes consumed, which is less than |size| only
+  // when the end of the value is reached before the end of the bytes.
+  Status<std::size_t> Scan(const std::uint8_t* data, std::size_t size) {
+    std::size_t index = 0;
+    while (!done_ && index < size) {
+      Status<void> status;
+      switch (state_) {
+        case State::Prefix:
+          status = BeginValue(static_cast<EncodingByte>(data[index++]));
+          break;
+
+        case State::FieldPrefix:
+          status = BeginField(static_cast<EncodingByte>(data[index++]));
+          break;
+
+        case State::FieldBytes:
+          field_value_ |= static_cast<std::uint64_t>(data[index++])
+                          << field_shift_;
+          field_shift_ += 8;
+          if (--remaining_ == 0)
+            status = EndField();
+          break;
+
+        case State::Skip: {
+          const std::size_t count =
+              static_cast<std::size_t>(std::min<std::uint64_t>(
+                  remaining_, size - index));
+          index += count;
+          remaining_ -= count;
+          if (remaining_ == 0)
+            status = EndSkip();
+          break;
+        }
+      }
+
+      if (!status)
+        return status.error();
+    }
+
+    return index;
+  }
+
+ private:
+  // What the next byte of the stream is expected to be.
+  enum class State {
+    Prefix,       // The prefix of a value.
+    FieldPrefix,  // The prefix of an integer field of a container.
+    FieldBytes,   // The remaining bytes of an integer field.
+    Skip,         // Opaque payload bytes.
+  };
+
+  // The integer fields of container encodings.
+  enum class Field {
+    Length,
+    Count,
+    MapCount,
+    VariantIndex,
+    TableHash,
+    TableCount,
+    EntryId,
+    EntrySize,
+    HandleReference,
+  };
+
+  enum class FrameType {
+    Values,  // A number of values, such as the elements of an array.
+    Table,   // A number of sized table entries.
+    Handle,  // The type value of a handle, followed by the reference.
+  };
+
+  struct Frame {
+    FrameType type;
+    std::uint64_t remaining;
+  };
+
+  // Returns true if the value of the field is a length or count, which must be
+  // encoded as an unsigned integer.
+  static constexpr bool IsSizeField(Field field) {
+    return field == Field::Length || field == Field::Count ||
+           field == Field::MapCount || field == Field::TableCount ||
+           field == Field::EntrySize;
+  }
+
+  Status<void> BeginValue(EncodingByte prefix) {
+    if ((prefix >= EncodingByte::PositiveFixIntMin &&
+         prefix <= EncodingByte::PositiveFixIntMax) ||
+        (prefix >= EncodingByte::NegativeFixIntMin &&
+         prefix <= EncodingByte::NegativeFixIntMax)) {
+      return CompleteValue();
+    }
+
+    switch (prefix) {
+      case EncodingByte::U8:
+      case EncodingByte::I8:
+      case EncodingByte::U16:
+      case EncodingByte::I16:
+      case EncodingByte::U32:
+      case EncodingByte::I32:
+      case EncodingByte::F32:
+      case EncodingByte::U64:
+      case EncodingByte::I64:
+      case EncodingByte::F64:
+        return BeginSkip(BaseEncodingSize(prefix) - 1);
+
+      case EncodingByte::Nil:
+        return CompleteValue();
+
+      case EncodingByte::Binary:
+      case EncodingByte::String:
+        return ExpectField(Field::Length);
+
+      case EncodingByte::Array:
+      case EncodingByte::Structure:
+        return ExpectField(Field::Count);
+
+      case EncodingByte::Map:
+        return ExpectField(Field::MapCount);
+
+      case EncodingByte::Variant:
+        return ExpectField(Field::VariantIndex);
+
+      case EncodingByte::Table:
+        return ExpectField(Field::TableHash);
+
+      case EncodingByte::Error:
+        return PushFrame(FrameType::Values, 1);
+
+      case EncodingByte::Handle:
+        return PushFrame(FrameType::Handle, 1);
+
+      /* case EncodingByte::ReservedMin ... EncodingByte::ReservedMax: */
+      case EncodingByte::Extension:
+      default:
+        return ErrorStatus::UnexpectedEncodingType;
+    }
+  }
+
+  Status<void> ExpectField(Field field) {
+    field_ = field;
+    state_ = State::FieldPrefix;
+    return {};
+  }
+
+  Status<void> BeginField(EncodingByte prefix) {
+    field_value_ = 0;
+    field_shift_ = 0;
+
+    if (prefix >= EncodingByte::PositiveFixIntMin &&
+        prefix <= EncodingByte::PositiveFixIntMax) {
+      field_value_ = static_cast<std::uint64_t>(prefix);
+      return EndField();
+    } else if (prefix >= EncodingByte::NegativeFixIntMin &&
+               prefix <= EncodingByte::NegativeFixIntMax) {
+      if (IsSizeField(field_))
+        return ErrorStatus::UnexpectedEncodingType;
+      else
+        return EndField();
+    }
+
+    switch (prefix) {
+      case EncodingByte::I8:
+      case EncodingByte::I16:
+      case EncodingByte::I32:
+      case EncodingByte::I64:
+        if (IsSizeField(field_))
+          return ErrorStatus::UnexpectedEncodingType;
+        // Fall through.
+      case EncodingByte::U8:
+      case EncodingByte::U16:
+      case EncodingByte::U32:
+      case EncodingByte::U64:
+        remaining_ = BaseEncodingSize(prefix) - 1;
+        state_ = State::FieldBytes;
+        return {};
+
+      default:
+        return ErrorStatus::UnexpectedEncodingType;
+    }
+  }
+
+  Status<void> EndField() {
+    switch (field_) {
+      case Field::Length:
+        return BeginSkip(field_value_);
+
+      case Field::Count:
+        return PushFrame(FrameType::Values, field_value_);
+
+      case Field::MapCount:
+        // Maps have two encoded values per element.
+        if (field_value_ > std::numeric_limits<std::uint64_t>::max() / 2)
+          return ErrorStatus::InvalidContainerLength;
+        else
+          return PushFrame(FrameType::Values, field_value_ * 2);
+
+      case Field::VariantIndex:
+        return PushFrame(FrameType::Values, 1);
+
+      case Field::TableHash:
+        return ExpectField(Field::TableCount);
+
+      case Field::TableCount:
+        return PushFrame(FrameType::Table, field_value_);
+
+      case Field::EntryId:
+        return ExpectField(Field::EntrySize);
+
+      case Field::EntrySize:
+        skip_entry_ = true;
+        return BeginSkip(field_value_);
+
+      case Field::HandleReference:
+        stack_.pop_back();
+        return CompleteValue();
+    }
+
+    return ErrorStatus::ProtocolError;
+  }
+
+  Status<void> BeginSkip(std::uint64_t size) {
+    remaining_ = size;
+    state_ = State::Skip;
+    if (remaining_ == 0)
+      return EndSkip();
+    else
+      return {};
+  }
+
+  Status<void> EndSkip() {
+    if (skip_entry_) {
+      skip_entry_ = false;
+      return CompleteEntry();
+    } else {
+      return CompleteValue();
+    }
+  }
+
+  Status<void> PushFrame(FrameType type, std::uint64_t count) {
+    if (count == 0) {
+      return CompleteValue();
+    } else if (stack_.size() >= kMaxSkipDepth) {
+      return ErrorStatus::InvalidContainerLength;
+    }
+
+    stack_.push_back({type, count});
+    if (type == FrameType::Table)
+      return ExpectField(Field::EntryId);
+
+    state_ = State::Prefix;
+    return {};
+  }
+
+  // Called at the end of each value to advance the enclosing containers.
+  Status<void> CompleteValue() {
+    while (!stack_.empty()) {
+      Frame& frame = stack_.back();
+      switch (frame.type) {
+        case FrameType::Values:
+          if (--frame.remaining != 0) {
+            state_ = State::Prefix;
+            return {};
+          }
+          stack_.pop_back();
+          break;
+
+        case FrameType::Handle:
+          return ExpectField(Field::HandleReference);
+
+        case FrameType::Table:
+          // Table entries are skipped as opaque bytes and never end with a
+          // value.
+          return ErrorStatus::ProtocolError;
+      }
+    }
+
+    done_ = true;
+    return {};
+  }
+
+  Status<void> CompleteEntry() {
+    Frame& frame = stack_.back();
+    if (--frame.remaining != 0)
+      return ExpectField(Field::EntryId);
+
+    stack_.pop_back();
+    return CompleteValue();
+  }
+
+  std::vector<Frame> stack_;
+  State state_{State::Prefix};
+  Field field_{Field::Length};
+  std::uint64_t field_value_{0};
+  std::size_t field_shift_{0};
+  std::uint64_t remaining_{0};
+  bool skip_entry_{false};
+  bool done_{false};
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_BASE_VALUE_SCANNER_H_
@@ -17,7 +17,11 @@
 #ifndef LIBNOP_INCLUDE_NOP_BASE_VARIANT_H_
 #define LIBNOP_INCLUDE_NOP_BASE_VARIANT_H_
 
+#include <type_traits>
+#include <utility>
+
 #include <nop/base/encoding.h>
+#include <nop/base/utility.h>
 #include <nop/types/variant.h>
 
 namespace nop {
@@ -71,6 +75,12 @@ struct Encoding<EmptyVariant> : EncodingIO<EmptyVariant> {
                                             Reader* /*reader*/) {
     return {};
   }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* /*reader*/) {
+    return {};
+  }
 };
 
 template <typename... Ts>
@@ -120,12 +130,95 @@ struct Encoding<Variant<Ts...>> : EncodingIO<Variant<Ts...>> {
       return ErrorStatus::UnexpectedVariantType;
     }
 
-    value->Become(type);
+    return ReadElement(type, value, reader, UseReadTable{});
+  }
 
-    return value->Visit([reader](auto&& element) {
-      using Element = typename std::decay<decltype(element)>::type;
-      return Encoding<Element>::Read(&element, reader);
-    });
+  template <typename Reader>
+  static Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                      Reader* reader) {
+    std::int32_t type = 0;
+    auto status = Encoding<std::int32_t>::Read(&type, reader);
+    if (!status) {
+      return status;
+    } else if (type < Type::kEmptyIndex ||
+               type >= static_cast<std::int32_t>(sizeof...(Ts))) {
+      return ErrorStatus::UnexpectedVariantType;
+    }
+
+    return ValidateElement(type, reader, std::make_index_sequence<Count>{});
+  }
+
+ private:
+  enum : std::size_t { Count = sizeof...(Ts) };
+
+  // Selects constant-time table dispatch for Variants with many element types,
+  // matching the visitation strategy of Variant.
+  using UseReadTable =
+      std::integral_constant<bool, (Count > detail::kVisitTableThreshold)>;
+
+  // Reads the element at index I directly into the storage of the Variant. The
+  // element is only constructed if it is not already active, in which case the
+  // existing element is reused as the destination.
+  template <std::size_t I, typename Reader>
+  static Status<void> ReadElementAt(Type* value, Reader* reader) {
+    using Element = std::decay_t<detail::TypeForIndex<I, Ts...>>;
+    return Encoding<Element>::Read(&value->template Become<I>(), reader);
+  }
+
+  template <typename Reader>
+  static Status<void> ReadEmpty(Type* value, Reader* reader) {
+    value->Become(Type::kEmptyIndex);
+    EmptyVariant empty;
+    return Encoding<EmptyVariant>::Read(&empty, reader);
+  }
+
+  template <typename Reader>
+  static Status<void> ReadElementForIndex(std::int32_t /*type*/, Type* value,
+                                          Reader* reader, Index<0>) {
+    return ReadEmpty(value, reader);
+  }
+
+  template <std::size_t index, typename Reader>
+  static Status<void> ReadElementForIndex(std::int32_t type, Type* value,
+                                          Reader* reader, Index<index>) {
+    if (type == static_cast<std::int32_t>(index - 1))
+      return ReadElementAt<index - 1>(value, reader);
+    else
+      return ReadElementForIndex(type, value, reader, Index<index - 1>{});
+  }
+
+  template <typename Reader>
+  static Status<void> ReadElement(std::int32_t type, Type* value,
+                                  Reader* reader, std::false_type) {
+    return ReadElementForIndex(type, value, reader, Index<Count>{});
+  }
+
+  template <typename Reader>
+  static Status<void> ReadElement(std::int32_t type, Type* value,
+                                  Reader* reader, std::true_type) {
+    return ReadElementFromTable(type, value, reader,
+                                std::make_index_sequence<Count>{});
+  }
+
+  template <typename Reader, std::size_t... Is>
+  static Status<void> ReadElementFromTable(std::int32_t type, Type* value,
+                                           Reader* reader,
+                                           std::index_sequence<Is...>) {
+    using Thunk = Status<void> (*)(Type*, Reader*);
+    static constexpr Thunk kTable[] = {&ReadEmpty<Reader>,
+                                       &ReadElementAt<Is, Reader>...};
+    return kTable[type + 1](value, reader);
+  }
+
+  template <typename Reader, std::size_t... Is>
+  static Status<void> ValidateElement(std::int32_t type, Reader* reader,
+                                      std::index_sequence<Is...>) {
+    using Thunk = Status<void> (*)(Reader*);
+    static constexpr Thunk kTable[] = {
+        &Encoding<EmptyVariant>::template Validate<Reader>,
+        &Encoding<std::decay_t<detail::TypeForIndex<Is, Ts...>>>::template
+            Validate<Reader>...};
+    return kTable[type + 1](reader);
   }
 };
 
@@ -18,7 +18,10 @@
 #define LIBNOP_INCLUDE_NOP_BASE_VECTOR_H_
 
 #include <nop/base/encoding.h>
+#include <nop/base/parallel.h>
 #include <nop/base/utility.h>
+#include <nop/traits/is_parallel_reader.h>
+#include <nop/traits/is_parallel_writer.h>
 
 #include <numeric>
 #include <vector>
@@ -59,7 +62,7 @@ struct Encoding<std::vector<T, Allocator>, EnableIfNotIntegral<T>>
   static constexpr std::size_t Size(const Type& value) {
     return BaseEncodingSize(Prefix(value)) +
            Encoding<SizeType>::Size(value.size()) +
-           std::accumulate(value.cbegin(), value.cend(), 0U,
+           std::accumulate(value.cbegin(), value.cend(), std::size_t{0},
                            [](const std::size_t& sum, const T& element) {
                              return sum + Encoding<T>::Size(element);
                            });
@@ -77,13 +80,7 @@ struct Encoding<std::vector<T, Allocator>, EnableIfNotIntegral<T>>
     if (!status)
       return status;
 
-    for (const T& element : value) {
-      status = Encoding<T>::Write(element, writer);
-      if (!status)
-        return status;
-    }
-
-    return {};
+    return WriteElements(value, writer, IsParallelWriter<Writer>{});
   }
 
   template <typename Reader>
@@ -94,6 +91,30 @@ struct Encoding<std::vector<T, Allocator>, EnableIfNotIntegral<T>>
     if (!status)
       return status;
 
+    return ReadElements(size, value, reader, IsParallelReader<Reader>{});
+  }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* reader) {
+    SizeType size = 0;
+    auto status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+
+    for (SizeType i = 0; i < size; i++) {
+      status = Encoding<T>::Validate(reader);
+      if (!status)
+        return status;
+    }
+
+    return {};
+  }
+
+ private:
+  template <typename Reader>
+  static Status<void> ReadElements(SizeType size, Type* value, Reader* reader,
+                                   std::false_type) {
     // Clear the vector to make sure elements are inserted at the correct
     // indices. Intentionally avoid calling reserve() to prevent abuse from very
     // large size values. Regardless of the size specified in the encoding the
@@ -101,16 +122,71 @@ struct Encoding<std::vector<T, Allocator>, EnableIfNotIntegral<T>>
     // of allocations.
     value->clear();
     for (SizeType i = 0; i < size; i++) {
-      T element;
-      status = Encoding<T>::Read(&element, reader);
+      auto status =
+          ReadElement(value, reader, IsAllocatorConstructible<T, Allocator>{});
       if (!status)
         return status;
+    }
+
+    return {};
+  }
+
+  template <typename Reader>
+  static Status<void> ReadElements(SizeType size, Type* value, Reader* reader,
+                                   std::true_type) {
+    return ReadElementsInParallel(size, value, reader);
+  }
+
+  // Allocator-aware elements, such as strings and vectors using the same kind
+  // of allocator, allocate from the vector's allocator while they are decoded.
+  // This keeps nested containers in the same memory resource as the vector and
+  // avoids reallocating them when they are moved into place.
+  template <typename Reader>
+  static Status<void> ReadElement(Type* value, Reader* reader,
+                                  std::true_type) {
+    T element(value->get_allocator());
+    auto status = Encoding<T>::Read(&element, reader);
+    if (!status)
+      return status;
 
-      value->push_back(std::move(element));
+    value->push_back(std::move(element));
+    return {};
+  }
+
+  template <typename Reader>
+  static Status<void> ReadElement(Type* value, Reader* reader,
+                                  std::false_type) {
+    T element;
+    auto status = Encoding<T>::Read(&element, reader);
+    if (!status)
+      return status;
+
+    value->push_back(std::move(element));
+    return {};
+  }
+
+  template <typename Writer>
+  static Status<void> WriteElements(const Type& value, Writer* writer,
+                                    std::false_type) {
+    for (const T& element : value) {
+      auto status = Encoding<T>::Write(element, writer);
+      if (!status)
+        return status;
     }
 
     return {};
   }
+
+  template <typename Writer>
+  static Status<void> WriteElements(const Type& value, Writer* writer,
+                                    std::true_type) {
+    return WriteElementsInParallel(
+        value.cbegin(), value.size(), writer,
+        [](const T& element) { return Encoding<T>::Size(element); },
+        [](const T& element, auto* element_writer) {
+          return Encoding<T>::Write(element, element_writer);
+        });
+  }
 };
 
 // Specialization for integral types.
@@ -168,6 +244,24 @@ struct Encoding<std::vector<T, Allocator>, EnableIfIntegral<T>>
     value->resize(length);
     return reader->Read(value->data(), value->data() + length);
   }
+
+  template <typename Reader>
+  static constexpr Status<void> ValidatePayload(EncodingByte /*prefix*/,
+                                                Reader* reader) {
+    SizeType size = 0;
+    auto status = Encoding<SizeType>::Read(&size, reader);
+    if (!status)
+      return status;
+
+    if (size % sizeof(T) != 0)
+      return ErrorStatus::InvalidContainerLength;
+
+    status = reader->Ensure(size);
+    if (!status)
+      return status;
+
+    return reader->Skip(size);
+  }
 };
 
 }  // namespace nop
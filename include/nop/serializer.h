@@ -18,17 +18,21 @@
 #define LIBNOP_INCLUDE_NOP_SERIALIZER_H_
 
 #include <nop/base/array.h>
+#include <nop/base/columnar.h>
 #include <nop/base/encoding.h>
 #include <nop/base/enum.h>
 #include <nop/base/handle.h>
+#include <nop/base/lazy.h>
 #include <nop/base/map.h>
 #include <nop/base/members.h>
 #include <nop/base/optional.h>
 #include <nop/base/pair.h>
+#include <nop/base/raw_value.h>
 #include <nop/base/reference_wrapper.h>
 #include <nop/base/result.h>
 #include <nop/base/serializer.h>
 #include <nop/base/string.h>
+#include <nop/base/structure_columns.h>
 #include <nop/base/table.h>
 #include <nop/base/tuple.h>
 #include <nop/base/value.h>
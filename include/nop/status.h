@@ -49,6 +49,7 @@ enum class ErrorStatus {
   IOError,                 // 16
   SystemError,             // 17
   DebugError,              // 18
+  WouldBlock,              // 19
 };
 
 template <typename T>
@@ -95,6 +96,8 @@ struct Status : Result<ErrorStatus, T> {
         return "System Error";
       case ErrorStatus::DebugError:
         return "Debug Error";
+      case ErrorStatus::WouldBlock:
+        return "Would Block";
       default:
         return "Unknown Error";
     }
@@ -17,11 +17,15 @@
 #ifndef LIBNOP_INCLUDE_NOP_TABLE_H_
 #define LIBNOP_INCLUDE_NOP_TABLE_H_
 
+#include <cstdint>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <nop/base/macros.h>
 #include <nop/structure.h>
 #include <nop/types/optional.h>
+#include <nop/types/raw_value.h>
 #include <nop/utility/sip_hash.h>
 
 namespace nop {
@@ -110,6 +114,64 @@ struct Entry<T, Id_, DeletedEntry> {
   void clear() {}
 };
 
+// Table member that preserves entries with ids that are not recognized by the
+// table definition. Without this member unknown entries are skipped during
+// deserialization and lost when the table is serialized again. Adding an
+// UnknownEntries member to a table allows intermediaries built with older table
+// definitions to forward newer data without losing information:
+//
+// struct MyTable {
+//   Entry<Address, 0> address;
+//   Entry<PhoneNumber, 1> phone_number;
+//   UnknownEntries unknown;
+//   NOP_TABLE(MyTable, address, phone_number, unknown);
+// };
+//
+// Each unknown entry retains the bytes of its sized byte string, including any
+// padding. When read from a contiguous reader (see IsContiguousReader) the
+// bytes are borrowed from the reader's buffer, which must outlive the table;
+// call own() to copy them into internal storage. Unknown entries are written
+// in the order they were read, at the position of the UnknownEntries member in
+// the table's entry list. A table may have at most one UnknownEntries member.
+class UnknownEntries {
+ public:
+  struct Item {
+    std::uint64_t id;
+    RawValue bytes;
+  };
+
+  using Iterator = std::vector<Item>::const_iterator;
+
+  UnknownEntries() = default;
+  UnknownEntries(const UnknownEntries&) = default;
+  UnknownEntries(UnknownEntries&&) = default;
+  UnknownEntries& operator=(const UnknownEntries&) = default;
+  UnknownEntries& operator=(UnknownEntries&&) = default;
+
+  // Appends an entry with the given id and byte string contents. The id must
+  // not be used by any other entry of the table.
+  void Add(std::uint64_t id, RawValue bytes) {
+    items_.push_back({id, std::move(bytes)});
+  }
+
+  // Copies any borrowed entry bytes into internal storage.
+  void own() {
+    for (auto& item : items_)
+      item.bytes.own();
+  }
+
+  bool empty() const { return items_.empty(); }
+  std::size_t size() const { return items_.size(); }
+  explicit operator bool() const { return !empty(); }
+  void clear() { items_.clear(); }
+
+  Iterator begin() const { return items_.begin(); }
+  Iterator end() const { return items_.end(); }
+
+ private:
+  std::vector<Item> items_;
+};
+
 // Defines a table type, its namespace hash, and its members. This macro must be
 // invoked once within a table struct or class to inform the serialization
 // engine about the table members and hash value. The macro befriends several
@@ -138,9 +200,16 @@ struct Entry<T, Id_, DeletedEntry> {
 // saves space in the encoding when namespace checks are not desired.
 #define NOP_TABLE(type, ... /*entries*/) NOP_TABLE_HASH(0, type, __VA_ARGS__)
 
-// Determines whether two entries have the same id.
+// Determines whether two entries have the same id. UnknownEntries has no id and
+// only compares equal to itself, preventing more than one such member.
 template <typename A, typename B>
 struct SameEntryId : std::integral_constant<bool, A::Id == B::Id> {};
+template <typename A>
+struct SameEntryId<A, UnknownEntries> : std::false_type {};
+template <typename B>
+struct SameEntryId<UnknownEntries, B> : std::false_type {};
+template <>
+struct SameEntryId<UnknownEntries, UnknownEntries> : std::true_type {};
 
 // Similar to MemberList used for serializable structures/classes. This type
 // also records the hash of the table name for sanity checking during
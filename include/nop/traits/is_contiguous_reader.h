@@ -0,0 +1,44 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_TRAITS_IS_CONTIGUOUS_READER_H_
+#define LIBNOP_INCLUDE_NOP_TRAITS_IS_CONTIGUOUS_READER_H_
+
+#include <cstdint>
+#include <utility>
+
+#include <nop/traits/is_detected.h>
+
+namespace nop {
+
+// Trait that determines whether a reader reads from a contiguous buffer that
+// outlives the read operation. Such readers expose the method:
+//
+//   const std::uint8_t* cursor() const;
+//
+// which returns a pointer to the next unread byte. Successive reads must
+// advance through the buffer in order, so that bytes already consumed remain
+// immediately before the cursor. Encodings may use this to refer to ranges of
+// encoded bytes in place instead of copying them.
+template <typename Reader>
+using ReaderCursorTest = decltype(std::declval<const Reader&>().cursor());
+
+template <typename Reader>
+using IsContiguousReader = IsDetected<ReaderCursorTest, Reader>;
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_TRAITS_IS_CONTIGUOUS_READER_H_
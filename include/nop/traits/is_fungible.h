@@ -29,6 +29,7 @@
 #include <nop/base/members.h>
 #include <nop/base/table.h>
 #include <nop/base/utility.h>
+#include <nop/types/lazy.h>
 #include <nop/types/optional.h>
 #include <nop/types/result.h>
 #include <nop/types/variant.h>
@@ -212,6 +213,11 @@ template <typename A, typename B>
 struct IsFungible<Optional<A>, Optional<B>>
     : IsFungible<std::decay_t<A>, std::decay_t<B>> {};
 
+// Compares Lazy<A> and Lazy<B> to see if A and B are fungible.
+template <typename A, typename B>
+struct IsFungible<Lazy<A>, Lazy<B>>
+    : IsFungible<std::decay_t<A>, std::decay_t<B>> {};
+
 // Compares Entry<A> and Entry<B> to see if A and B are fungible.
 template <typename A, typename B, std::uint64_t Id, typename Type>
 struct IsFungible<Entry<A, Id, Type>, Entry<B, Id, Type>>
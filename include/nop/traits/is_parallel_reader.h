@@ -0,0 +1,41 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_TRAITS_IS_PARALLEL_READER_H_
+#define LIBNOP_INCLUDE_NOP_TRAITS_IS_PARALLEL_READER_H_
+
+#include <utility>
+
+#include <nop/traits/is_detected.h>
+
+namespace nop {
+
+// Trait that determines whether a reader reads from a contiguous buffer that
+// may be decoded concurrently by an executor. Such readers provide the methods
+// of BufferReader, including cursor() and remaining(), and the method:
+//
+//   Executor* executor() const;
+//
+// where Executor has the interface described in IsParallelWriter.
+template <typename Reader>
+using ReaderExecutorTest = decltype(std::declval<const Reader&>().executor());
+
+template <typename Reader>
+using IsParallelReader = IsDetected<ReaderExecutorTest, Reader>;
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_TRAITS_IS_PARALLEL_READER_H_
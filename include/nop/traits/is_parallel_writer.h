@@ -0,0 +1,48 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_TRAITS_IS_PARALLEL_WRITER_H_
+#define LIBNOP_INCLUDE_NOP_TRAITS_IS_PARALLEL_WRITER_H_
+
+#include <utility>
+
+#include <nop/traits/is_detected.h>
+
+namespace nop {
+
+// Trait that determines whether a writer writes to a contiguous buffer that
+// may be filled in concurrently by an executor. Such writers provide the
+// methods of BufferWriter, including Claim() and Commit(), and the method:
+//
+//   Executor* executor() const;
+//
+// where Executor has the methods:
+//
+//   std::size_t concurrency() const;
+//   void ParallelFor(std::size_t count, Function&& function);
+//
+// ParallelFor() calls function(i) for each i in [0, count), possibly
+// concurrently, and returns when all of the calls have returned. See ThreadPool
+// for an implementation.
+template <typename Writer>
+using WriterExecutorTest = decltype(std::declval<const Writer&>().executor());
+
+template <typename Writer>
+using IsParallelWriter = IsDetected<WriterExecutorTest, Writer>;
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_TRAITS_IS_PARALLEL_WRITER_H_
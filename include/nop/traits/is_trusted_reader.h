@@ -0,0 +1,41 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_TRAITS_IS_TRUSTED_READER_H_
+#define LIBNOP_INCLUDE_NOP_TRAITS_IS_TRUSTED_READER_H_
+
+#include <nop/traits/is_detected.h>
+
+namespace nop {
+
+// Trait that determines whether a reader only reads data that is known to be
+// well-formed, such as a buffer that has been checked with Validate(). Such
+// readers declare the nested type:
+//
+//   using TrustedReaderTag = void;
+//
+// Encodings may omit prefix and length checks when reading from a trusted
+// reader, since these checks can never fail on validated data. Reading
+// malformed data from a trusted reader results in undefined behavior.
+template <typename Reader>
+using TrustedReaderTest = typename Reader::TrustedReaderTag;
+
+template <typename Reader>
+using IsTrustedReader = IsDetected<TrustedReaderTest, Reader>;
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_TRAITS_IS_TRUSTED_READER_H_
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_TYPES_COLUMNAR_H_
+#define LIBNOP_INCLUDE_NOP_TYPES_COLUMNAR_H_
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <nop/types/detail/member_pointer.h>
+
+namespace nop {
+
+// ColumnarVector<T> is a std::vector<T> of NOP_STRUCTURE types that is encoded
+// column by column instead of element by element: the values of each member
+// across all of the elements are grouped together. Columns of arithmetic
+// members are encoded as single binary blocks, which are written and read in
+// bulk and compress much better than interleaved elements. Other members are
+// encoded as arrays of the member type.
+//
+// The columnar encoding is not compatible with the encoding of std::vector<T>;
+// both ends of a protocol must agree to use ColumnarVector<T>.
+//
+// Example:
+//
+//  struct Sample {
+//    std::uint64_t time;
+//    float value;
+//    std::string source;
+//    NOP_STRUCTURE(Sample, time, value, source);
+//  };
+//
+//  struct Batch {
+//    std::uint32_t sensor;
+//    nop::ColumnarVector<Sample> samples;
+//    NOP_STRUCTURE(Batch, sensor, samples);
+//  };
+//
+template <typename T, typename Allocator = std::allocator<T>>
+class ColumnarVector : public std::vector<T, Allocator> {
+  static_assert(HasMemberList<T>::value,
+                "ColumnarVector<T> requires T to be a NOP_STRUCTURE type.");
+
+ public:
+  using VectorType = std::vector<T, Allocator>;
+  using VectorType::VectorType;
+
+  ColumnarVector() = default;
+  ColumnarVector(const VectorType& other) : VectorType(other) {}
+  ColumnarVector(VectorType&& other) : VectorType(std::move(other)) {}
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_TYPES_COLUMNAR_H_
@@ -76,6 +76,19 @@ struct MemberPointer<T Class::*, Pointer> {
                                             MemberList /*member_list*/) {
     return Encoding<Type>::ReadPayload(prefix, Resolve(instance), reader);
   }
+
+  template <typename Reader, typename MemberList>
+  static constexpr Status<void> Validate(Reader* reader,
+                                         MemberList /*member_list*/) {
+    return Encoding<Type>::Validate(reader);
+  }
+
+  template <typename Reader, typename MemberList>
+  static constexpr Status<void> ValidatePayload(EncodingByte prefix,
+                                                Reader* reader,
+                                                MemberList /*member_list*/) {
+    return Encoding<Type>::ValidatePayload(prefix, reader);
+  }
 };
 
 // Test expression for the external unbounded logical buffer tag.
@@ -145,6 +158,19 @@ struct MemberPointer<First Class::*, FirstPointer, Second Class::*,
     Type pair = Resolve(instance);
     return Encoding<Type>::ReadPayload(prefix, &pair, reader);
   }
+
+  template <typename Reader, typename MemberList>
+  static constexpr Status<void> Validate(Reader* reader,
+                                         MemberList /*member_list*/) {
+    return Encoding<Type>::Validate(reader);
+  }
+
+  template <typename Reader, typename MemberList>
+  static constexpr Status<void> ValidatePayload(EncodingByte prefix,
+                                                Reader* reader,
+                                                MemberList /*member_list*/) {
+    return Encoding<Type>::ValidatePayload(prefix, reader);
+  }
 };
 
 // Captures a list of MemberPointers.
@@ -398,6 +398,51 @@ union Union<First, Rest...> {
   Union<Rest...> rest_;
 };
 
+// Number of element types above which visitation dispatches through a table of
+// function pointers instead of recursively traversing the union. The recursive
+// traversal compiles to a chain of comparisons that is cheap for a handful of
+// types but grows linearly with the number of types.
+constexpr std::size_t kVisitTableThreshold = 8;
+
+// Dispatches a visitor to the active element of Union<Types...> in constant
+// time using a table of function pointers indexed by the active element. The
+// first table entry handles the empty state.
+template <typename... Types>
+struct VisitTable {
+  template <typename UnionType, typename Op>
+  static decltype(auto) Visit(UnionType& value, std::int32_t target_index,
+                              Op&& op) {
+    using Return = decltype(std::declval<Op>()(
+        value.get(TypeTag<TypeForIndex<0, Types...>>{})));
+    using Thunk = Return (*)(UnionType&, Op&&);
+
+    static constexpr Thunk kTable[] = {
+        &VisitEmpty<Return, UnionType, Op>,
+        &VisitElement<Return, Types, UnionType, Op>...};
+    return kTable[target_index + 1](value, std::forward<Op>(op));
+  }
+
+ private:
+  template <typename Return, typename UnionType, typename Op>
+  static Return VisitEmpty(UnionType& /*value*/, Op&& op) {
+    return std::forward<Op>(op)(EmptyVariant{});
+  }
+
+  template <typename Return, typename T, typename UnionType, typename Op>
+  static Return VisitElement(UnionType& value, Op&& op) {
+    return std::forward<Op>(op)(value.get(TypeTag<T>{}));
+  }
+};
+
+// Visitor that destroys the active element of a union.
+struct DestroyElement {
+  template <typename T>
+  void operator()(T& element) const {
+    element.~T();
+  }
+  void operator()(EmptyVariant) const {}
+};
+
 }  // namespace detail
 }  // namespace nop
 
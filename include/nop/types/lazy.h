@@ -0,0 +1,184 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_TYPES_LAZY_H_
+#define LIBNOP_INCLUDE_NOP_TYPES_LAZY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include <nop/base/encoding.h>
+#include <nop/status.h>
+#include <nop/types/optional.h>
+#include <nop/utility/pedantic_buffer_reader.h>
+
+namespace nop {
+
+// Lazy<T> is a wrapper for members of type T that are expensive to decode and
+// are not always needed by the consumer of a message.
+//
+// When a Lazy<T> is read from a contiguous reader (see IsContiguousReader) only
+// the structure of the encoded value is examined and the range of encoded bytes
+// is recorded. The value of type T is decoded from these bytes on first access
+// through get() and cached for subsequent accesses. When a Lazy<T> that has not
+// been modified is written, the recorded bytes are written verbatim without
+// re-encoding the value. Reading from other readers decodes the value
+// immediately, since the encoded bytes are not available after the read.
+//
+// Lazy<T> may be used anywhere T may be used, including as a member of
+// NOP_STRUCTURE types and as the value of table entries:
+//
+//  struct Message {
+//    std::uint32_t id;
+//    nop::Lazy<std::vector<Sample>> samples;
+//    NOP_STRUCTURE(Message, id, samples);
+//  };
+//
+// Lazy<T> has several restrictions that users must be aware of:
+//   1. The recorded bytes are borrowed from the reader's buffer, which must
+//      outlive the Lazy<T> or any copies of it until the value is decoded or
+//      replaced. Use take() or get_mutable() to decode before the buffer is
+//      released.
+//   2. Errors in the encoding of T are only detected during the structural
+//      scan of the read; type mismatches are reported by get().
+//   3. Deferred decoding does not have access to the reader that produced the
+//      bytes. Types that contain handles must not be wrapped in Lazy<T>.
+//   4. get() is a const method that updates the internal cache and is not safe
+//      to call concurrently on the same instance.
+//
+template <typename T>
+class Lazy {
+  static_assert(std::is_default_constructible<T>::value,
+                "Lazy<T> requires T to be default constructible.");
+
+ public:
+  // Constructs a Lazy<T> holding a default constructed T.
+  Lazy() : value_{T{}} {}
+
+  // Constructs a Lazy<T> holding the given value.
+  Lazy(const T& value) : value_{value} {}
+  Lazy(T&& value) : value_{std::move(value)} {}
+
+  Lazy(const Lazy&) = default;
+  Lazy(Lazy&&) = default;
+  Lazy& operator=(const Lazy&) = default;
+  Lazy& operator=(Lazy&&) = default;
+
+  Lazy& operator=(const T& value) {
+    Reset();
+    value_ = value;
+    return *this;
+  }
+  Lazy& operator=(T&& value) {
+    Reset();
+    value_ = std::move(value);
+    return *this;
+  }
+
+  // Returns true if this instance refers to encoded bytes that have not been
+  // replaced by a modified value.
+  bool is_encoded() const { return encoded_; }
+
+  // Returns true if the value of type T is available without decoding.
+  bool is_decoded() const { return !value_.empty(); }
+
+  // Returns a pointer to the value, decoding the recorded bytes if necessary.
+  Status<const T*> get() const {
+    auto status = Decode();
+    if (!status)
+      return status.error();
+    else
+      return &value_.get();
+  }
+
+  // Returns a mutable pointer to the value, decoding the recorded bytes if
+  // necessary. The recorded bytes are released, causing subsequent writes to
+  // encode the value of type T instead.
+  Status<T*> get_mutable() {
+    auto status = Decode();
+    if (!status)
+      return status.error();
+
+    Reset();
+    return &value_.get();
+  }
+
+  // Decodes the value if necessary and moves it out of this instance.
+  Status<T> take() {
+    auto status = get_mutable();
+    if (!status)
+      return status.error();
+    else
+      return std::move(*status.get());
+  }
+
+  // Returns the prefix of the recorded encoding. Only valid when is_encoded()
+  // returns true.
+  EncodingByte encoded_prefix() const { return encoded_prefix_; }
+
+  // Returns the recorded payload bytes that follow the prefix. Only valid when
+  // is_encoded() returns true.
+  const std::uint8_t* encoded_data() const { return encoded_data_; }
+  std::size_t encoded_size() const { return encoded_size_; }
+
+  // Records the payload bytes of an encoded T, discarding any held value.
+  void SetEncoded(EncodingByte prefix, const std::uint8_t* data,
+                  std::size_t size) {
+    value_.clear();
+    encoded_ = true;
+    encoded_prefix_ = prefix;
+    encoded_data_ = data;
+    encoded_size_ = size;
+  }
+
+ private:
+  // Decodes the recorded bytes into the cache if the value is not already
+  // available.
+  Status<void> Decode() const {
+    if (!value_.empty())
+      return {};
+    else if (!Encoding<T>::Match(encoded_prefix_))
+      return ErrorStatus::UnexpectedEncodingType;
+
+    PedanticBufferReader reader{encoded_data_, encoded_size_};
+    T temp{};
+    auto status = Encoding<T>::ReadPayload(encoded_prefix_, &temp, &reader);
+    if (!status)
+      return status;
+
+    value_ = std::move(temp);
+    return {};
+  }
+
+  void Reset() {
+    encoded_ = false;
+    encoded_prefix_ = EncodingByte::Nil;
+    encoded_data_ = nullptr;
+    encoded_size_ = 0;
+  }
+
+  mutable Optional<T> value_;
+  bool encoded_{false};
+  EncodingByte encoded_prefix_{EncodingByte::Nil};
+  const std::uint8_t* encoded_data_{nullptr};
+  std::size_t encoded_size_{0};
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_TYPES_LAZY_H_
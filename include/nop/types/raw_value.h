@@ -0,0 +1,125 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_TYPES_RAW_VALUE_H_
+#define LIBNOP_INCLUDE_NOP_TYPES_RAW_VALUE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace nop {
+
+// RawValue holds exactly one complete encoded value, including its prefix, as
+// opaque bytes. It may be used in place of any type in a structure, tuple,
+// variant, or container to forward a subvalue without decoding it.
+//
+// When read from a contiguous reader (see IsContiguousReader) a RawValue
+// borrows the bytes from the reader's buffer, which must outlive the RawValue
+// and any copies of it. Call own() to copy borrowed bytes into internal
+// storage. When read from other readers the bytes are always copied.
+//
+// Writing a RawValue emits the held bytes verbatim. An empty RawValue encodes
+// as NIL.
+//
+// Example of a routing envelope that forwards its payload untouched:
+//
+//  struct Envelope {
+//    std::string destination;
+//    nop::RawValue payload;
+//    NOP_STRUCTURE(Envelope, destination, payload);
+//  };
+//
+class RawValue {
+ public:
+  RawValue() = default;
+
+  // Constructs a RawValue that owns a copy of the given encoded bytes.
+  RawValue(const std::uint8_t* data, std::size_t size)
+      : storage_(data, data + size),
+        data_{storage_.data()},
+        size_{storage_.size()} {}
+
+  // Constructs a RawValue that owns the given encoded bytes.
+  explicit RawValue(std::vector<std::uint8_t> storage)
+      : storage_(std::move(storage)),
+        data_{storage_.data()},
+        size_{storage_.size()} {}
+
+  RawValue(const RawValue& other) { *this = other; }
+  RawValue(RawValue&& other) noexcept { *this = std::move(other); }
+
+  RawValue& operator=(const RawValue& other) {
+    if (this != &other) {
+      storage_ = other.storage_;
+      data_ = other.owned() ? storage_.data() : other.data_;
+      size_ = other.size_;
+    }
+    return *this;
+  }
+
+  RawValue& operator=(RawValue&& other) noexcept {
+    if (this != &other) {
+      const bool owned = other.owned();
+      storage_ = std::move(other.storage_);
+      data_ = owned ? storage_.data() : other.data_;
+      size_ = other.size_;
+      other.clear();
+    }
+    return *this;
+  }
+
+  // Returns a RawValue that refers to the given encoded bytes without copying
+  // them.
+  static RawValue Borrow(const std::uint8_t* data, std::size_t size) {
+    RawValue value;
+    value.data_ = data;
+    value.size_ = size;
+    return value;
+  }
+
+  // Copies borrowed bytes into internal storage. Has no effect if the bytes
+  // are already owned.
+  void own() {
+    if (!owned()) {
+      storage_.assign(data_, data_ + size_);
+      data_ = storage_.data();
+    }
+  }
+
+  // Returns true if the bytes are held in internal storage.
+  bool owned() const { return size_ == 0 || data_ == storage_.data(); }
+
+  bool empty() const { return size_ == 0; }
+  const std::uint8_t* data() const { return data_; }
+  std::size_t size() const { return size_; }
+
+  void clear() {
+    storage_.clear();
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+ private:
+  std::vector<std::uint8_t> storage_;
+  const std::uint8_t* data_{nullptr};
+  std::size_t size_{0};
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_TYPES_RAW_VALUE_H_
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_TYPES_STRUCTURE_COLUMNS_H_
+#define LIBNOP_INCLUDE_NOP_TYPES_STRUCTURE_COLUMNS_H_
+
+#include <cstddef>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <nop/base/utility.h>
+#include <nop/types/detail/member_pointer.h>
+
+namespace nop {
+
+// StructureColumns<T> holds a sequence of NOP_STRUCTURE type T as one vector
+// per member of T (structure of arrays), in member order. It has the same
+// encoding as std::vector<T>, so arrays of T produced by any writer may be
+// decoded into columns for vectorized processing, and columns may be encoded
+// for consumers that expect std::vector<T>.
+//
+// Decoding sizes every column up front and decodes each member directly into
+// its column, without constructing intermediate T values.
+//
+// The members of T must be named individually in NOP_STRUCTURE; array and size
+// pairs (logical buffers) are not supported.
+//
+// Example:
+//
+//  struct Sample {
+//    std::uint64_t time;
+//    float value;
+//    NOP_STRUCTURE(Sample, time, value);
+//  };
+//
+//  nop::StructureColumns<Sample> samples;
+//  auto status = deserializer.Read(&samples);
+//  const std::vector<float>& values = samples.column<1>();
+//
+template <typename T>
+class StructureColumns {
+  static_assert(HasMemberList<T>::value,
+                "StructureColumns<T> requires T to be a NOP_STRUCTURE type.");
+
+  using MemberList = typename MemberListTraits<T>::MemberList;
+
+  template <typename Members>
+  struct ColumnsTraits;
+  template <typename... Pointers>
+  struct ColumnsTraits<std::tuple<Pointers...>> {
+    using Type = std::tuple<std::vector<typename Pointers::Type>...>;
+    enum : bool {
+      IsPlain = And<std::is_same<decltype(Pointers::Resolve(
+                                     std::declval<T*>())),
+                                 typename Pointers::Type*>...>::value
+    };
+  };
+
+  using Traits = ColumnsTraits<typename MemberList::Members>;
+  static_assert(Traits::IsPlain,
+                "StructureColumns<T> does not support logical buffer members.");
+
+ public:
+  using Columns = typename Traits::Type;
+
+  enum : std::size_t { ColumnCount = MemberList::Count };
+  static_assert(ColumnCount > 0,
+                "StructureColumns<T> requires T to have members.");
+
+  template <std::size_t Index>
+  using ColumnType = typename std::tuple_element<Index, Columns>::type;
+
+  StructureColumns() = default;
+  StructureColumns(const StructureColumns&) = default;
+  StructureColumns(StructureColumns&&) = default;
+  StructureColumns& operator=(const StructureColumns&) = default;
+  StructureColumns& operator=(StructureColumns&&) = default;
+
+  // Returns the number of elements, which is the size of the first column.
+  // All of the columns must have the same size when the value is written.
+  std::size_t size() const { return std::get<0>(columns_).size(); }
+  bool empty() const { return size() == 0; }
+
+  template <std::size_t Index>
+  ColumnType<Index>& column() {
+    return std::get<Index>(columns_);
+  }
+  template <std::size_t Index>
+  const ColumnType<Index>& column() const {
+    return std::get<Index>(columns_);
+  }
+
+  Columns& columns() { return columns_; }
+  const Columns& columns() const { return columns_; }
+
+  // Resizes every column to |size| elements.
+  void resize(std::size_t size) {
+    Resize(size, std::make_index_sequence<ColumnCount>{});
+  }
+
+  void clear() { resize(0); }
+
+ private:
+  template <std::size_t... Is>
+  void Resize(std::size_t size, std::index_sequence<Is...>) {
+    (void)std::initializer_list<int>{(std::get<Is>(columns_).resize(size),
+                                      0)...};
+  }
+
+  Columns columns_;
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_TYPES_STRUCTURE_COLUMNS_H_
@@ -20,6 +20,7 @@
 #include <cstdint>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 
 #include <nop/types/detail/variant.h>
 
@@ -60,6 +61,12 @@ class Variant {
   template <typename R, typename T>
   using EnableIfAssignable = detail::EnableIfAssignable<R, T, Types...>;
 
+  // Selects constant-time table dispatch for Variants with many element types.
+  using UseVisitTable =
+      std::integral_constant<bool, (sizeof...(Types) >
+                                    detail::kVisitTableThreshold)>;
+  using VisitTable = detail::VisitTable<std::decay_t<Types>...>;
+
   struct Direct {};
   struct Convert {};
   template <typename T>
@@ -164,15 +171,29 @@ class Variant {
     }
   }
 
+  // Becomes the element type at index I, constructing a new element from the
+  // given arguments if necessary, and returns a reference to the active
+  // element. Unlike Become(target_index) the target type is resolved at compile
+  // time, so no search over the element types is performed.
+  template <std::size_t I, typename... Args>
+  TypeForIndex<I>& Become(Args&&... args) {
+    if (index() != static_cast<std::int32_t>(I)) {
+      Destruct();
+      Construct(TypeTagForIndex<I>{}, std::forward<Args>(args)...);
+    }
+    return value_.get(TypeTagForIndex<I>{});
+  }
+
   // Invokes |Op| on the active element. If the Variant is empty |Op| is invoked
-  // on EmptyVariant.
+  // on EmptyVariant. Variants with more than detail::kVisitTableThreshold
+  // element types dispatch through a table indexed by the active element.
   template <typename Op>
   decltype(auto) Visit(Op&& op) {
-    return value_.Visit(index_, std::forward<Op>(op));
+    return Dispatch(value_, index_, std::forward<Op>(op), UseVisitTable{});
   }
   template <typename Op>
   decltype(auto) Visit(Op&& op) const {
-    return value_.Visit(index_, std::forward<Op>(op));
+    return Dispatch(value_, index_, std::forward<Op>(op), UseVisitTable{});
   }
 
   // Index returned when the Variant is empty.
@@ -244,9 +265,26 @@ class Variant {
 
   // Destroys the active element of the Variant.
   void Destruct() {
-    value_.Destruct(index_);
+    Destruct(UseVisitTable{});
     index_ = kEmptyIndex;
   }
+  void Destruct(std::false_type) { value_.Destruct(index_); }
+  void Destruct(std::true_type) {
+    VisitTable::Visit(value_, index_, detail::DestroyElement{});
+  }
+
+  // Dispatches |Op| to the active element either by recursive traversal of the
+  // union or through the visit table.
+  template <typename UnionType, typename Op>
+  static decltype(auto) Dispatch(UnionType& value, std::int32_t index,
+                                 Op&& op, std::false_type) {
+    return value.Visit(index, std::forward<Op>(op));
+  }
+  template <typename UnionType, typename Op>
+  static decltype(auto) Dispatch(UnionType& value, std::int32_t index,
+                                 Op&& op, std::true_type) {
+    return VisitTable::Visit(value, index, std::forward<Op>(op));
+  }
 
   // Assigns the Variant when non-empty and the current type matches the target
   // type, otherwise destroys the current value and constructs a element of the
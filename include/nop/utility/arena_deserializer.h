@@ -0,0 +1,110 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_ARENA_DESERIALIZER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_ARENA_DESERIALIZER_H_
+
+#include <cstddef>
+#include <utility>
+
+#include <nop/base/serializer.h>
+#include <nop/status.h>
+#include <nop/utility/memory_arena.h>
+
+namespace nop {
+
+// ArenaDeserializer is a Deserializer that installs a MemoryArena as the
+// current arena of the calling thread while it decodes. Every container using
+// ArenaAllocator that is created during decoding, at any depth, allocates from
+// the arena, so a decoded message is freed by a single MemoryArena::Reset()
+// instead of one free per container.
+//
+// The top-level value keeps the allocator it already has. Construct it inside
+// an ArenaScope, or use Read<T>(), which constructs the value while the arena
+// is installed.
+//
+// Example of decoding requests in a loop:
+//
+//   nop::MemoryArena arena;
+//   nop::ArenaDeserializer<nop::BufferReader> deserializer{&arena};
+//   while (...) {
+//     deserializer.reader() = nop::BufferReader{data, size};
+//     auto request = deserializer.Read<Request>();
+//     if (request)
+//       Handle(request.get());
+//     arena.Reset();
+//   }
+//
+// Containers using std::allocator are not affected by the arena.
+template <typename Reader>
+class ArenaDeserializer {
+ public:
+  template <typename... Args>
+  explicit ArenaDeserializer(MemoryArena* arena, Args&&... args)
+      : arena_{arena}, deserializer_{std::forward<Args>(args)...} {}
+
+  ArenaDeserializer(ArenaDeserializer&&) = default;
+  ArenaDeserializer& operator=(ArenaDeserializer&&) = default;
+
+  // Deserializes the next value into |value|, allocating nested containers
+  // from the arena.
+  template <typename T>
+  Status<void> Read(T* value) {
+    ArenaScope scope{arena_};
+    return deserializer_.Read(value);
+  }
+
+  // Constructs and deserializes the next value of type T, allocating the value
+  // and its nested containers from the arena.
+  template <typename T>
+  Status<T> Read() {
+    ArenaScope scope{arena_};
+    T value;
+    auto status = deserializer_.Read(&value);
+    if (!status)
+      return status.error();
+    else
+      return {std::move(value)};
+  }
+
+  // Deserializes |count| values into the array |values|. See
+  // Deserializer::ReadBatch().
+  template <typename T>
+  Status<void> ReadBatch(T* values, std::size_t count,
+                         BatchFraming framing = BatchFraming::None) {
+    ArenaScope scope{arena_};
+    return deserializer_.ReadBatch(values, count, framing);
+  }
+
+  MemoryArena* arena() const { return arena_; }
+
+  const Reader& reader() const { return deserializer_.reader(); }
+  Reader& reader() { return deserializer_.reader(); }
+
+  const Deserializer<Reader>& deserializer() const { return deserializer_; }
+  Deserializer<Reader>& deserializer() { return deserializer_; }
+
+ private:
+  MemoryArena* arena_;
+  Deserializer<Reader> deserializer_;
+
+  ArenaDeserializer(const ArenaDeserializer&) = delete;
+  ArenaDeserializer& operator=(const ArenaDeserializer&) = delete;
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_ARENA_DESERIALIZER_H_
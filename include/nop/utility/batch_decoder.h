@@ -0,0 +1,218 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_BATCH_DECODER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_BATCH_DECODER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <nop/base/encoding.h>
+#include <nop/base/frame.h>
+#include <nop/status.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/thread_pool.h>
+
+namespace nop {
+
+// Decodes batches of framed records (see base/frame.h), such as a log file read
+// into memory or mapped with mmap(), across the threads of an executor. Records
+// are decoded into caller-provided slots in the order in which they appear in
+// the buffer.
+//
+// The frames in a batch are located sequentially, which only requires reading
+// their length prefixes, and are then grouped into work items of consecutive
+// records. Executor threads take work items from a shared counter until none
+// remain, so threads that finish early pick up the remaining work.
+//
+// Counters accumulate across batches and may be read from any thread while a
+// batch is being decoded.
+//
+// Example:
+//
+//  nop::ThreadPool pool;
+//  nop::BatchDecoder<> decoder{&pool};
+//  std::vector<Record> records(kMaxBatch);
+//  while (!log.empty()) {
+//    auto status = decoder.Decode(log.data(), log.size(), records.data(),
+//                                 records.size());
+//    if (!status)
+//      return status.error();
+//    Apply(records.data(), status.get().records);
+//    log.Consume(status.get().bytes);
+//  }
+//
+template <typename Executor = ThreadPool>
+class BatchDecoder {
+ public:
+  // Number of records and bytes consumed by a call to Decode().
+  struct Batch {
+    std::size_t records;
+    std::size_t bytes;
+  };
+
+  // Snapshot of the decoder counters.
+  struct Stats {
+    std::uint64_t batches;
+    std::uint64_t records;
+    std::uint64_t bytes;
+    std::uint64_t errors;
+    std::chrono::nanoseconds decode_time;
+    // Number of work items of the current batch that have not been started.
+    std::size_t queue_depth;
+
+    double records_per_second() const {
+      return decode_time.count() == 0
+                 ? 0.0
+                 : records * 1e9 / static_cast<double>(decode_time.count());
+    }
+
+    double bytes_per_second() const {
+      return decode_time.count() == 0
+                 ? 0.0
+                 : bytes * 1e9 / static_cast<double>(decode_time.count());
+    }
+  };
+
+  // Target number of work items per executor thread in each batch.
+  enum : std::size_t { kWorkItemsPerThread = 8 };
+
+  explicit BatchDecoder(Executor* executor) : executor_{executor} {}
+
+  BatchDecoder(const BatchDecoder&) = delete;
+  BatchDecoder& operator=(const BatchDecoder&) = delete;
+
+  // Decodes the complete frames at the start of the given buffer into
+  // |slots|, stopping when all of the slots are filled or when the remaining
+  // bytes do not hold a complete frame. A partial frame at the end of the
+  // buffer is not an error and is left for a later call, after more data is
+  // available. Returns the number of records decoded and bytes consumed.
+  //
+  // Returns the error of the first record that fails to decode, in buffer
+  // order. The contents of the slots are unspecified on error.
+  template <typename T>
+  Status<Batch> Decode(const void* data, std::size_t size, T* slots,
+                        std::size_t slot_count) {
+    const auto start_time = std::chrono::steady_clock::now();
+
+    std::vector<Frame> frames;
+    auto status = Split(static_cast<const std::uint8_t*>(data), size,
+                        slot_count, &frames);
+    if (!status)
+      return Fail(status.error());
+
+    const std::size_t frame_count = frames.size();
+    const std::size_t item_count =
+        std::min(frame_count, executor_->concurrency() * kWorkItemsPerThread);
+    std::vector<ErrorStatus> errors(item_count, ErrorStatus::None);
+
+    remaining_items_ = item_count;
+    executor_->ParallelFor(item_count, [&](std::size_t item) {
+      remaining_items_--;
+      const std::size_t begin = frame_count * item / item_count;
+      const std::size_t end = frame_count * (item + 1) / item_count;
+      for (std::size_t i = begin; i < end; i++) {
+        BufferReader reader{frames[i].data, frames[i].size};
+        // Any bytes after the record are padding that fills out the frame.
+        auto status = Encoding<T>::Read(&slots[i], &reader);
+        if (!status) {
+          errors[item] = status.error();
+          return;
+        }
+      }
+    });
+
+    for (ErrorStatus error : errors) {
+      if (error != ErrorStatus::None)
+        return Fail(error);
+    }
+
+    const std::size_t bytes =
+        frames.empty()
+            ? 0
+            : frames.back().data + frames.back().size -
+                  static_cast<const std::uint8_t*>(data);
+
+    batches_++;
+    records_ += frame_count;
+    bytes_ += bytes;
+    decode_time_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start_time)
+                        .count();
+    return Batch{frame_count, bytes};
+  }
+
+  Stats stats() const {
+    return {batches_,
+            records_,
+            bytes_,
+            errors_,
+            std::chrono::nanoseconds{decode_time_.load()},
+            remaining_items_};
+  }
+
+  Executor* executor() const { return executor_; }
+
+ private:
+  struct Frame {
+    const std::uint8_t* data;
+    std::size_t size;
+  };
+
+  // Locates up to |max_frames| complete frames at the start of the buffer.
+  static Status<void> Split(const std::uint8_t* data, std::size_t size,
+                            std::size_t max_frames,
+                            std::vector<Frame>* frames) {
+    BufferReader reader{data, size};
+    while (frames->size() < max_frames && !reader.empty()) {
+      SizeType length = 0;
+      auto status = Encoding<SizeType>::Read(&length, &reader);
+      if (!status && status.error() == ErrorStatus::ReadLimitReached)
+        break;
+      else if (!status)
+        return status;
+
+      if (length > reader.remaining())
+        break;
+
+      frames->push_back({reader.cursor(), static_cast<std::size_t>(length)});
+      reader.Skip(length);
+    }
+    return {};
+  }
+
+  ErrorStatus Fail(ErrorStatus error) {
+    errors_++;
+    remaining_items_ = 0;
+    return error;
+  }
+
+  Executor* executor_;
+  std::atomic<std::uint64_t> batches_{0};
+  std::atomic<std::uint64_t> records_{0};
+  std::atomic<std::uint64_t> bytes_{0};
+  std::atomic<std::uint64_t> errors_{0};
+  std::atomic<std::int64_t> decode_time_{0};
+  std::atomic<std::size_t> remaining_items_{0};
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_BATCH_DECODER_H_
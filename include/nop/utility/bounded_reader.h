@@ -20,6 +20,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <iterator>
+#include <utility>
 
 #include <nop/base/encoding.h>
 #include <nop/base/handle.h>
@@ -105,7 +106,14 @@ class BoundedReader {
 
   template <typename HandleType>
   constexpr Status<HandleType> GetHandle(HandleReference handle_reference) {
-    return reader_->GetHandle(handle_reference);
+    return reader_->template GetHandle<HandleType>(handle_reference);
+  }
+
+  // Forwards to the underlying reader when it exposes its position in a
+  // contiguous buffer. See IsContiguousReader.
+  template <typename R = Reader>
+  constexpr auto cursor() const -> decltype(std::declval<const R&>().cursor()) {
+    return reader_->cursor();
   }
 
   constexpr bool empty() const { return index_ == size_; }
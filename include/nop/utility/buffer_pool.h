@@ -0,0 +1,377 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_BUFFER_POOL_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_BUFFER_POOL_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <nop/base/encoding.h>
+#include <nop/base/serializer.h>
+#include <nop/base/utility.h>
+#include <nop/types/optional.h>
+#include <nop/types/thread_local.h>
+
+namespace nop {
+
+// PooledBuffer is a move-only byte buffer borrowed from BufferPool. The buffer
+// returns to the pool of the destroying thread, with its capacity kept, when
+// the PooledBuffer is destroyed or reset.
+class PooledBuffer {
+ public:
+  PooledBuffer() = default;
+  PooledBuffer(PooledBuffer&& other) noexcept { *this = std::move(other); }
+  ~PooledBuffer() { reset(); }
+
+  PooledBuffer& operator=(PooledBuffer&& other) noexcept {
+    if (this != &other) {
+      reset();
+      data_ = std::move(other.data_);
+      capacity_ = other.capacity_;
+      size_ = other.size_;
+      other.capacity_ = 0;
+      other.size_ = 0;
+    }
+    return *this;
+  }
+
+  std::uint8_t* data() { return data_.get(); }
+  const std::uint8_t* data() const { return data_.get(); }
+
+  // Returns the number of bytes in use, as set by the writer that filled the
+  // buffer.
+  std::size_t size() const { return size_; }
+  void set_size(std::size_t size) { size_ = std::min(size, capacity_); }
+
+  std::size_t capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+
+  // Returns the buffer to the pool.
+  inline void reset();
+
+ private:
+  friend class BufferPool;
+
+  PooledBuffer(std::unique_ptr<std::uint8_t[]> data, std::size_t capacity)
+      : data_{std::move(data)}, capacity_{capacity} {}
+
+  std::unique_ptr<std::uint8_t[]> data_;
+  std::size_t capacity_{0};
+  std::size_t size_{0};
+
+  PooledBuffer(const PooledBuffer&) = delete;
+  PooledBuffer& operator=(const PooledBuffer&) = delete;
+};
+
+// BufferPool hands out reusable byte buffers from a cache local to the calling
+// thread, so that the common pattern of serializing each message into a fresh
+// buffer stops allocating once the cache is warm. Acquiring and releasing a
+// buffer do not take locks.
+//
+// Buffers are bucketed into power-of-two size classes from kMinCapacity to
+// kMaxCapacity. Larger buffers are allocated and freed directly. Each thread
+// tracks the high-water mark of buffers in use per size class, and every
+// kTrimInterval releases it frees cached buffers beyond the high-water mark
+// of the last interval. This keeps the cache from growing without bound after
+// a burst.
+class BufferPool {
+ public:
+  enum : std::size_t {
+    kMinCapacity = 256,
+    kMaxCapacity = 4 * 1024 * 1024,
+    kMaxCachedPerClass = 16,
+    kTrimInterval = 256,
+  };
+
+  // Per-thread pool statistics.
+  struct Stats {
+    std::size_t hits;
+    std::size_t misses;
+    std::size_t cached_buffers;
+    std::size_t cached_bytes;
+  };
+
+  // Returns a buffer with a capacity of at least |capacity| bytes and a size
+  // of zero. The contents of the buffer are unspecified.
+  static PooledBuffer Acquire(std::size_t capacity) {
+    const std::size_t size_class = SizeClassOf(capacity);
+    if (size_class == kNoSizeClass) {
+      return PooledBuffer{std::unique_ptr<std::uint8_t[]>{
+                              new std::uint8_t[capacity]},
+                          capacity};
+    }
+
+    Cache& cache = GetCache();
+    Bucket& bucket = cache.buckets[size_class];
+    bucket.in_use++;
+    bucket.high_water = std::max(bucket.high_water, bucket.in_use);
+
+    const std::size_t class_capacity = CapacityOf(size_class);
+    if (bucket.free.empty()) {
+      cache.misses++;
+      return PooledBuffer{std::unique_ptr<std::uint8_t[]>{
+                              new std::uint8_t[class_capacity]},
+                          class_capacity};
+    }
+
+    cache.hits++;
+    PooledBuffer buffer{std::move(bucket.free.back()), class_capacity};
+    bucket.free.pop_back();
+    return buffer;
+  }
+
+  // Returns the statistics of the calling thread's cache.
+  static Stats stats() {
+    Cache& cache = GetCache();
+    Stats stats{cache.hits, cache.misses, 0, 0};
+    for (std::size_t i = 0; i < kSizeClassCount; i++) {
+      stats.cached_buffers += cache.buckets[i].free.size();
+      stats.cached_bytes += cache.buckets[i].free.size() * CapacityOf(i);
+    }
+    return stats;
+  }
+
+  // Frees every buffer cached by the calling thread and resets its usage
+  // tracking, so that the next trim interval starts from a clean state.
+  // Buffers acquired by this thread but released on other threads are never
+  // returned to this thread's count, so resetting here also discards that
+  // drift. Buffers still in use are no longer counted.
+  static void Trim() {
+    Cache& cache = GetCache();
+    for (Bucket& bucket : cache.buckets) {
+      bucket.free.clear();
+      bucket.in_use = 0;
+      bucket.high_water = 0;
+    }
+    cache.releases = 0;
+  }
+
+ private:
+  friend class PooledBuffer;
+
+  enum : std::size_t {
+    kMinShift = 8,
+    kSizeClassCount = 15,
+    kNoSizeClass = kSizeClassCount,
+  };
+  static_assert(kMinCapacity == std::size_t{1} << kMinShift,
+                "kMinShift does not match kMinCapacity.");
+  static_assert(kMaxCapacity == kMinCapacity << (kSizeClassCount - 1),
+                "kSizeClassCount does not match kMaxCapacity.");
+
+  struct Bucket {
+    std::vector<std::unique_ptr<std::uint8_t[]>> free;
+    std::size_t in_use{0};
+    std::size_t high_water{0};
+  };
+
+  struct Cache {
+    Cache() = default;
+    Cache(Cache&& other) noexcept { *this = std::move(other); }
+    ~Cache() {
+      if (active)
+        Destroyed() = true;
+    }
+
+    Cache& operator=(Cache&& other) noexcept {
+      buckets = std::move(other.buckets);
+      releases = other.releases;
+      hits = other.hits;
+      misses = other.misses;
+      active = other.active;
+      other.active = false;
+      return *this;
+    }
+
+    std::array<Bucket, kSizeClassCount> buckets;
+    std::size_t releases{0};
+    std::size_t hits{0};
+    std::size_t misses{0};
+    bool active{true};
+  };
+
+  // Set when the calling thread's cache has been destroyed at thread exit.
+  // Buffers released after that point are freed directly.
+  static bool& Destroyed() {
+    static thread_local bool destroyed = false;
+    return destroyed;
+  }
+
+  static Cache& GetCache() {
+    ThreadLocal<Cache, ThreadLocalTypeSlot<BufferPool>> cache{InPlace{}};
+    return cache.Get();
+  }
+
+  static std::size_t CapacityOf(std::size_t size_class) {
+    return std::size_t{kMinCapacity} << size_class;
+  }
+
+  static std::size_t SizeClassOf(std::size_t capacity) {
+    if (capacity > kMaxCapacity)
+      return kNoSizeClass;
+
+    std::size_t size_class = 0;
+    while (CapacityOf(size_class) < capacity)
+      size_class++;
+    return size_class;
+  }
+
+  static void Release(std::unique_ptr<std::uint8_t[]> data,
+                      std::size_t capacity) {
+    const std::size_t size_class = SizeClassOf(capacity);
+    if (size_class == kNoSizeClass || CapacityOf(size_class) != capacity ||
+        Destroyed()) {
+      return;
+    }
+
+    Cache& cache = GetCache();
+    Bucket& bucket = cache.buckets[size_class];
+
+    // Buffers acquired on another thread are not counted as in use here.
+    if (bucket.in_use > 0)
+      bucket.in_use--;
+
+    // Always keep at least one buffer so that a thread that only releases
+    // buffers from other threads can still serve its own requests.
+    const std::size_t limit = std::min<std::size_t>(
+        kMaxCachedPerClass, std::max<std::size_t>(bucket.high_water, 1));
+    if (bucket.free.size() + bucket.in_use < limit)
+      bucket.free.push_back(std::move(data));
+
+    if (++cache.releases % kTrimInterval == 0)
+      TrimToHighWater(&cache);
+  }
+
+  // Frees cached buffers beyond the high-water mark of the interval that just
+  // ended and starts a new interval.
+  static void TrimToHighWater(Cache* cache) {
+    for (Bucket& bucket : cache->buckets) {
+      const std::size_t limit =
+          bucket.high_water > bucket.in_use
+              ? bucket.high_water - bucket.in_use
+              : 0;
+      if (bucket.free.size() > limit)
+        bucket.free.resize(limit);
+      bucket.high_water = bucket.in_use;
+    }
+  }
+};
+
+void PooledBuffer::reset() {
+  if (data_)
+    BufferPool::Release(std::move(data_), capacity_);
+  capacity_ = 0;
+  size_ = 0;
+}
+
+// PooledBufferWriter is a writer that serializes into a growable buffer from
+// BufferPool. Serializers prepare the writer with the exact encoded size of
+// each value, so a single Write() usually needs a single buffer. Writing more
+// than the current capacity moves the data to a larger pooled buffer.
+//
+// Example:
+//
+//   nop::Serializer<nop::PooledBufferWriter> serializer;
+//   auto status = serializer.Write(message);
+//   nop::PooledBuffer buffer = serializer.writer().take();
+//   Send(buffer.data(), buffer.size());
+//
+class PooledBufferWriter {
+ public:
+  PooledBufferWriter() = default;
+  explicit PooledBufferWriter(std::size_t capacity)
+      : buffer_{BufferPool::Acquire(capacity)} {}
+  PooledBufferWriter(PooledBufferWriter&&) = default;
+  PooledBufferWriter& operator=(PooledBufferWriter&&) = default;
+
+  Status<void> Prepare(std::size_t size) {
+    if (buffer_.capacity() - index_ < size)
+      Grow(index_ + size);
+    return {};
+  }
+
+  Status<void> Write(std::uint8_t byte) { return Write(&byte, &byte + 1); }
+
+  template <typename T, typename Enable = EnableIfArithmetic<T>>
+  Status<void> Write(const T* begin, const T* end) {
+    const std::size_t length_bytes = (end - begin) * sizeof(T);
+    Prepare(length_bytes);
+
+    std::memcpy(buffer_.data() + index_, begin, length_bytes);
+    index_ += length_bytes;
+    return {};
+  }
+
+  Status<void> Skip(std::size_t padding_bytes,
+                    std::uint8_t padding_value = 0x00) {
+    Prepare(padding_bytes);
+
+    std::memset(buffer_.data() + index_, padding_value, padding_bytes);
+    index_ += padding_bytes;
+    return {};
+  }
+
+  const std::uint8_t* data() const { return buffer_.data(); }
+  std::size_t size() const { return index_; }
+  std::size_t capacity() const { return buffer_.capacity(); }
+
+  // Discards the written data, keeping the buffer.
+  void clear() { index_ = 0; }
+
+  // Returns the buffer holding the written data and leaves the writer empty.
+  PooledBuffer take() {
+    buffer_.set_size(index_);
+    index_ = 0;
+    return std::move(buffer_);
+  }
+
+ private:
+  void Grow(std::size_t size) {
+    PooledBuffer buffer =
+        BufferPool::Acquire(std::max(size, 2 * buffer_.capacity()));
+    if (index_ > 0)
+      std::memcpy(buffer.data(), buffer_.data(), index_);
+    buffer_ = std::move(buffer);
+  }
+
+  PooledBuffer buffer_;
+  std::size_t index_{0};
+
+  PooledBufferWriter(const PooledBufferWriter&) = delete;
+  PooledBufferWriter& operator=(const PooledBufferWriter&) = delete;
+};
+
+// Serializes |value| into a buffer from the calling thread's BufferPool.
+template <typename T>
+Status<PooledBuffer> SerializeToPooledBuffer(const T& value) {
+  Serializer<PooledBufferWriter> serializer;
+  auto status = serializer.Write(value);
+  if (!status)
+    return status.error();
+  else
+    return serializer.writer().take();
+}
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_BUFFER_POOL_H_
@@ -71,6 +71,11 @@ class BufferReader {
     return {};
   }
 
+  // Returns a pointer to the next unread byte in the buffer. Encodings that
+  // retain references to encoded data, such as Lazy<T>, use this to record
+  // byte ranges without copying them out of the buffer.
+  const std::uint8_t* cursor() const { return buffer_ + index_; }
+
   bool empty() const { return index_ == size_; }
 
   std::size_t remaining() const { return size_ - index_; }
@@ -72,6 +72,19 @@ class BufferWriter {
     return {};
   }
 
+  // Returns a pointer to the next |size| bytes of the buffer so that they may
+  // be filled in directly, possibly out of order or concurrently. The bytes
+  // are not considered written until Commit() is called.
+  Status<std::uint8_t*> Claim(std::size_t size) {
+    if (index_ + size > size_)
+      return ErrorStatus::WriteLimitReached;
+    else
+      return &buffer_[index_];
+  }
+
+  // Advances past |size| bytes that were filled in after a call to Claim().
+  void Commit(std::size_t size) { index_ += size; }
+
   std::size_t size() const { return index_; }
   std::size_t capacity() const { return size_; }
 
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_CAPTURE_READER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_CAPTURE_READER_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <nop/base/encoding.h>
+#include <nop/base/utility.h>
+
+namespace nop {
+
+// CaptureReader is a reader type that wraps another reader pointer and appends
+// every byte read or skipped to a vector. This is used to copy encoded values
+// out of readers that do not provide direct access to their underlying buffer.
+// Skipped bytes are read from the underlying reader in bounded chunks so that
+// the capture buffer only grows as data is actually received.
+template <typename Reader>
+class CaptureReader {
+ public:
+  CaptureReader(Reader* reader, std::vector<std::uint8_t>* capture)
+      : reader_{reader}, capture_{capture} {}
+
+  Status<void> Ensure(std::size_t size) { return reader_->Ensure(size); }
+
+  Status<void> Read(std::uint8_t* byte) {
+    auto status = reader_->Read(byte);
+    if (!status)
+      return status;
+
+    capture_->push_back(*byte);
+    return {};
+  }
+
+  template <typename T, typename Enable = EnableIfArithmetic<T>>
+  Status<void> Read(T* begin, T* end) {
+    auto status = reader_->Read(begin, end);
+    if (!status)
+      return status;
+
+    const std::uint8_t* begin_byte =
+        reinterpret_cast<const std::uint8_t*>(begin);
+    const std::uint8_t* end_byte = reinterpret_cast<const std::uint8_t*>(end);
+    capture_->insert(capture_->end(), begin_byte, end_byte);
+    return {};
+  }
+
+  Status<void> Skip(std::size_t padding_bytes) {
+    enum : std::size_t { kChunkSize = 4096 };
+    while (padding_bytes > 0) {
+      const std::size_t chunk_size =
+          std::min<std::size_t>(padding_bytes, kChunkSize);
+      const std::size_t offset = capture_->size();
+      capture_->resize(offset + chunk_size);
+
+      std::uint8_t* chunk = capture_->data() + offset;
+      auto status = reader_->Read(chunk, chunk + chunk_size);
+      if (!status) {
+        capture_->resize(offset);
+        return status;
+      }
+
+      padding_bytes -= chunk_size;
+    }
+    return {};
+  }
+
+ private:
+  Reader* reader_;
+  std::vector<std::uint8_t>* capture_;
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_CAPTURE_READER_H_
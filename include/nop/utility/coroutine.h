@@ -0,0 +1,213 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_COROUTINE_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_COROUTINE_H_
+
+//
+// C++20 coroutine front end for ResumableSerializer and ResumableDeserializer.
+// This header is empty unless the compiler supports coroutines.
+//
+
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <utility>
+
+#include <nop/status.h>
+#include <nop/utility/resumable_deserializer.h>
+#include <nop/utility/resumable_serializer.h>
+
+namespace nop {
+
+// Intrusive record passed to a scheduler to wait for a file descriptor to
+// become ready. The record lives in the awaiting coroutine frame, so waiting
+// does not allocate.
+//
+// Schedulers used with AsyncSerializer and AsyncDeserializer provide the
+// following methods, and call Notify() once on the given waiter when the file
+// descriptor becomes ready:
+//
+//   void WaitReadable(int fd, IoWaiter* waiter);
+//   void WaitWritable(int fd, IoWaiter* waiter);
+//
+struct IoWaiter {
+  explicit IoWaiter(void (*callback)(IoWaiter*)) : callback{callback} {}
+
+  void Notify() { callback(this); }
+
+  void (*callback)(IoWaiter*);
+};
+
+// AsyncDeserializer reads values from a non-blocking file descriptor. The
+// awaitable returned by Read() completes immediately when a value is already
+// available, and otherwise suspends the coroutine until the scheduler reports
+// that enough data has been received:
+//
+//   Message message;
+//   auto status = co_await deserializer.Read(&message);
+//
+// The file descriptor is not owned by the deserializer.
+template <typename Scheduler>
+class AsyncDeserializer {
+ public:
+  AsyncDeserializer(int fd, Scheduler* scheduler)
+      : fd_{fd}, scheduler_{scheduler} {}
+
+  template <typename T>
+  class ReadAwaitable : IoWaiter {
+   public:
+    ReadAwaitable(AsyncDeserializer* deserializer, T* value)
+        : IoWaiter{&ReadAwaitable::OnReady},
+          deserializer_{deserializer},
+          value_{value} {}
+
+    bool await_ready() { return TryRead(); }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+      handle_ = handle;
+      deserializer_->scheduler_->WaitReadable(deserializer_->fd_, this);
+    }
+
+    Status<void> await_resume() { return std::move(status_); }
+
+   private:
+    static void OnReady(IoWaiter* waiter) {
+      auto* self = static_cast<ReadAwaitable*>(waiter);
+      if (self->TryRead()) {
+        self->handle_.resume();
+      } else {
+        self->deserializer_->scheduler_->WaitReadable(self->deserializer_->fd_,
+                                                      self);
+      }
+    }
+
+    // Attempts to complete the read. Returns false if the read would block.
+    bool TryRead() {
+      ResumableDeserializer& deserializer = deserializer_->deserializer_;
+      if (!deserializer.ready()) {
+        auto status = deserializer.ReadFrom(deserializer_->fd_);
+        if (!status && status.error() == ErrorStatus::WouldBlock) {
+          return false;
+        } else if (!status) {
+          status_ = status;
+          return true;
+        }
+      }
+
+      status_ = deserializer.Read(value_);
+      return true;
+    }
+
+    AsyncDeserializer* deserializer_;
+    T* value_;
+    Status<void> status_;
+    std::coroutine_handle<> handle_;
+  };
+
+  // Returns an awaitable that reads the next value into |value|.
+  template <typename T>
+  ReadAwaitable<T> Read(T* value) {
+    return {this, value};
+  }
+
+  const ResumableDeserializer& deserializer() const { return deserializer_; }
+  ResumableDeserializer& deserializer() { return deserializer_; }
+
+ private:
+  int fd_;
+  Scheduler* scheduler_;
+  ResumableDeserializer deserializer_;
+};
+
+// AsyncSerializer writes values to a non-blocking file descriptor. The
+// awaitable returned by Write() completes immediately when the encoded value
+// is accepted by the file descriptor, and otherwise suspends the coroutine
+// until all of it has been written:
+//
+//   auto status = co_await serializer.Write(message);
+//
+// The file descriptor is not owned by the serializer.
+template <typename Scheduler>
+class AsyncSerializer {
+ public:
+  AsyncSerializer(int fd, Scheduler* scheduler)
+      : fd_{fd}, scheduler_{scheduler} {}
+
+  class WriteAwaitable : IoWaiter {
+   public:
+    WriteAwaitable(AsyncSerializer* serializer, Status<void> status)
+        : IoWaiter{&WriteAwaitable::OnReady},
+          serializer_{serializer},
+          status_{std::move(status)} {}
+
+    bool await_ready() { return !status_ || TryWrite(); }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+      handle_ = handle;
+      serializer_->scheduler_->WaitWritable(serializer_->fd_, this);
+    }
+
+    Status<void> await_resume() { return std::move(status_); }
+
+   private:
+    static void OnReady(IoWaiter* waiter) {
+      auto* self = static_cast<WriteAwaitable*>(waiter);
+      if (self->TryWrite()) {
+        self->handle_.resume();
+      } else {
+        self->serializer_->scheduler_->WaitWritable(self->serializer_->fd_,
+                                                    self);
+      }
+    }
+
+    // Attempts to write the pending data. Returns false if the write would
+    // block.
+    bool TryWrite() {
+      auto status = serializer_->serializer_.WriteTo(serializer_->fd_);
+      if (!status && status.error() == ErrorStatus::WouldBlock)
+        return false;
+
+      status_ = status;
+      return true;
+    }
+
+    AsyncSerializer* serializer_;
+    Status<void> status_;
+    std::coroutine_handle<> handle_;
+  };
+
+  // Encodes |value| and returns an awaitable that completes when the value,
+  // and any data queued before it, has been written.
+  template <typename T>
+  WriteAwaitable Write(const T& value) {
+    return {this, serializer_.Write(value)};
+  }
+
+  const ResumableSerializer& serializer() const { return serializer_; }
+  ResumableSerializer& serializer() { return serializer_; }
+
+ private:
+  int fd_;
+  Scheduler* scheduler_;
+  ResumableSerializer serializer_;
+};
+
+}  // namespace nop
+
+#endif  // __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_COROUTINE_H_
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_DATAGRAM_READER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_DATAGRAM_READER_H_
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <nop/status.h>
+#include <nop/utility/buffer_reader.h>
+
+namespace nop {
+
+// DatagramReader receives batches of datagrams with recvmmsg() into a ring of
+// fixed-size buffers, one per datagram, so that workloads with many small
+// messages make one system call per batch instead of one per message. Each
+// received datagram may be decoded with a BufferReader from reader().
+//
+// Receive() overwrites the previous batch, so decoded values that refer to the
+// received bytes, such as Lazy<T> and RawValue, are only valid until the next
+// call.
+//
+// Example:
+//
+//   nop::DatagramReader receiver{socket_fd};
+//   while (true) {
+//     auto status = receiver.Receive();
+//     if (!status)
+//       return status.error();
+//     for (std::size_t i = 0; i < status.get(); i++) {
+//       nop::Deserializer<nop::BufferReader> deserializer{receiver.reader(i)};
+//       Sample sample;
+//       if (deserializer.Read(&sample))
+//         Handle(sample);
+//     }
+//   }
+//
+class DatagramReader {
+ public:
+  struct Options {
+    // Maximum number of datagrams received by one recvmmsg() call. Values
+    // below one are treated as one.
+    std::size_t batch_size = 64;
+    // Size of each receive buffer. Longer datagrams are truncated; see
+    // truncated(). Values below one are treated as one.
+    std::size_t max_message_size = 64 * 1024;
+  };
+
+  struct Stats {
+    std::uint64_t messages;
+    std::uint64_t batches;
+    std::uint64_t bytes;
+    std::uint64_t truncated;
+  };
+
+  DatagramReader() : DatagramReader{-1, Options{}} {}
+  explicit DatagramReader(int socket_fd)
+      : DatagramReader{socket_fd, Options{}} {}
+  DatagramReader(int socket_fd, const Options& options)
+      : socket_fd_{socket_fd},
+        options_{Sanitize(options)},
+        buffers_{new std::uint8_t[options_.batch_size *
+                                  options_.max_message_size]},
+        vectors_(options_.batch_size),
+        headers_(options_.batch_size) {
+    for (std::size_t i = 0; i < options_.batch_size; i++)
+      vectors_[i] = {buffer(i), options_.max_message_size};
+  }
+  DatagramReader(DatagramReader&&) = default;
+  DatagramReader& operator=(DatagramReader&&) = default;
+
+  // Receives up to Options::batch_size datagrams, returning the number
+  // received. By default this blocks until at least one datagram is available
+  // and then takes whatever else is already queued (MSG_WAITFORONE). Returns
+  // ErrorStatus::WouldBlock if the socket is non-blocking and empty.
+  Status<std::size_t> Receive(int flags = MSG_WAITFORONE) {
+    for (std::size_t i = 0; i < options_.batch_size; i++) {
+      headers_[i] = {};
+      headers_[i].msg_hdr.msg_iov = &vectors_[i];
+      headers_[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int ret;
+    do {
+      ret = ::recvmmsg(socket_fd_, headers_.data(), options_.batch_size, flags,
+                       nullptr);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret < 0) {
+      count_ = 0;
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return ErrorStatus::WouldBlock;
+      else
+        return ErrorStatus::IOError;
+    }
+
+    count_ = ret;
+    stats_.batches++;
+    stats_.messages += count_;
+    for (std::size_t i = 0; i < count_; i++) {
+      stats_.bytes += size(i);
+      if (truncated(i))
+        stats_.truncated++;
+    }
+    return count_;
+  }
+
+  // Returns the number of datagrams in the current batch.
+  std::size_t count() const { return count_; }
+
+  // Returns the bytes of datagram |index| of the current batch.
+  const std::uint8_t* data(std::size_t index) const {
+    return buffers_.get() + index * options_.max_message_size;
+  }
+  std::size_t size(std::size_t index) const {
+    return std::min<std::size_t>(headers_[index].msg_len,
+                                 options_.max_message_size);
+  }
+
+  // Returns true if datagram |index| was longer than the receive buffer.
+  bool truncated(std::size_t index) const {
+    return headers_[index].msg_hdr.msg_flags & MSG_TRUNC;
+  }
+
+  // Returns a reader over datagram |index| of the current batch.
+  BufferReader reader(std::size_t index) const {
+    return {data(index), size(index)};
+  }
+
+  int socket_fd() const { return socket_fd_; }
+  const Options& options() const { return options_; }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  static Options Sanitize(Options options) {
+    options.batch_size = std::max<std::size_t>(options.batch_size, 1);
+    options.max_message_size =
+        std::max<std::size_t>(options.max_message_size, 1);
+    return options;
+  }
+
+  std::uint8_t* buffer(std::size_t index) {
+    return buffers_.get() + index * options_.max_message_size;
+  }
+
+  int socket_fd_;
+  Options options_;
+  Stats stats_{0, 0, 0, 0};
+  std::unique_ptr<std::uint8_t[]> buffers_;
+  std::vector<iovec> vectors_;
+  std::vector<mmsghdr> headers_;
+  std::size_t count_{0};
+
+  DatagramReader(const DatagramReader&) = delete;
+  DatagramReader& operator=(const DatagramReader&) = delete;
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_DATAGRAM_READER_H_
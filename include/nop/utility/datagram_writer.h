@@ -0,0 +1,256 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_DATAGRAM_WRITER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_DATAGRAM_WRITER_H_
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <nop/base/encoding.h>
+#include <nop/base/utility.h>
+#include <nop/status.h>
+
+namespace nop {
+
+// DatagramWriter is a writer that queues one message per datagram and sends
+// the queue in batches with sendmmsg(), so that workloads with many small
+// messages make one system call per batch instead of one per message. The
+// socket must be a connected datagram socket, such as AF_UNIX SOCK_DGRAM or a
+// connected UDP socket.
+//
+// Values written to the writer form the current message until Send() queues
+// it. The queue is flushed when it reaches Options::batch_size messages, or on
+// Send() or Poll() once the oldest queued message has waited for at least
+// Options::max_latency. Event loops should call Poll() periodically, or
+// Flush() when idle, so that queued messages are not held indefinitely.
+//
+// Example:
+//
+//   nop::Serializer<nop::DatagramWriter> serializer{socket_fd};
+//   for (const Sample& sample : samples) {
+//     auto status = serializer.Write(sample);
+//     if (status)
+//       status = serializer.writer().Send();
+//   }
+//   serializer.writer().Flush();
+//
+class DatagramWriter {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Options {
+    // Maximum number of messages sent by one sendmmsg() call. Values below one
+    // are treated as one.
+    std::size_t batch_size = 64;
+    // Maximum size of a single message. Writing more fails with
+    // ErrorStatus::WriteLimitReached. Values below one are treated as one.
+    std::size_t max_message_size = 64 * 1024;
+    // Maximum time a message waits in the queue before Send() or Poll()
+    // flushes it.
+    std::chrono::microseconds max_latency{1000};
+  };
+
+  struct Stats {
+    std::uint64_t messages;
+    std::uint64_t batches;
+    std::uint64_t bytes;
+    std::uint64_t errors;
+  };
+
+  DatagramWriter() = default;
+  explicit DatagramWriter(int socket_fd) : socket_fd_{socket_fd} {}
+  DatagramWriter(int socket_fd, const Options& options)
+      : socket_fd_{socket_fd}, options_{Sanitize(options)} {}
+  DatagramWriter(DatagramWriter&&) = default;
+  DatagramWriter& operator=(DatagramWriter&&) = default;
+
+  Status<void> Prepare(std::size_t size) {
+    if (buffer_.size() - message_offset_ + size > options_.max_message_size)
+      return ErrorStatus::WriteLimitReached;
+
+    // Grow geometrically so that queueing a message does not reallocate and
+    // copy every message already queued.
+    const std::size_t required = buffer_.size() + size;
+    if (required > buffer_.capacity())
+      buffer_.reserve(std::max(required, 2 * buffer_.capacity()));
+    return {};
+  }
+
+  Status<void> Write(std::uint8_t byte) {
+    buffer_.push_back(byte);
+    return {};
+  }
+
+  template <typename T, typename Enable = EnableIfArithmetic<T>>
+  Status<void> Write(const T* begin, const T* end) {
+    const std::uint8_t* begin_byte =
+        reinterpret_cast<const std::uint8_t*>(begin);
+    const std::uint8_t* end_byte = reinterpret_cast<const std::uint8_t*>(end);
+    buffer_.insert(buffer_.end(), begin_byte, end_byte);
+    return {};
+  }
+
+  Status<void> Skip(std::size_t padding_bytes,
+                    std::uint8_t padding_value = 0x00) {
+    buffer_.insert(buffer_.end(), padding_bytes, padding_value);
+    return {};
+  }
+
+  // Queues the current message and flushes the queue if it is full or the
+  // oldest message has waited for the maximum latency.
+  Status<void> Send() {
+    messages_.push_back(
+        {message_offset_, buffer_.size() - message_offset_, Clock::now()});
+    message_offset_ = buffer_.size();
+
+    if (messages_.size() >= options_.batch_size)
+      return Flush();
+    else
+      return Poll();
+  }
+
+  // Flushes the queue if the oldest message has waited for the maximum
+  // latency.
+  Status<void> Poll() {
+    if (!messages_.empty() &&
+        Clock::now() - messages_.front().queued >= options_.max_latency)
+      return Flush();
+    else
+      return {};
+  }
+
+  // Sends every queued message. Returns ErrorStatus::WouldBlock if the socket
+  // is non-blocking and full, keeping the unsent messages queued. Other errors
+  // discard the queue.
+  Status<void> Flush() {
+    std::size_t sent = 0;
+    Status<void> status;
+    while (sent < messages_.size()) {
+      const std::size_t count =
+          std::min(messages_.size() - sent, options_.batch_size);
+      PrepareBatch(sent, count);
+
+      const int ret =
+          ::sendmmsg(socket_fd_, headers_.data(), count, MSG_NOSIGNAL);
+      if (ret < 0 && errno == EINTR) {
+        continue;  // Interrupted by signal.
+      } else if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        status = ErrorStatus::WouldBlock;
+        break;
+      } else if (ret <= 0) {
+        // A socket that accepts no messages without reporting an error would
+        // otherwise be retried forever.
+        stats_.errors++;
+        sent = messages_.size();
+        status = ErrorStatus::IOError;
+        break;
+      }
+
+      stats_.batches++;
+      stats_.messages += ret;
+      for (int i = 0; i < ret; i++)
+        stats_.bytes += headers_[i].msg_len;
+      sent += ret;
+    }
+
+    Consume(sent);
+    return status;
+  }
+
+  // Discards the current message, keeping the queue.
+  void clear() { buffer_.resize(message_offset_); }
+
+  int socket_fd() const { return socket_fd_; }
+  const Options& options() const { return options_; }
+  const Stats& stats() const { return stats_; }
+
+  // Returns the number of messages waiting to be sent.
+  std::size_t queued() const { return messages_.size(); }
+
+  // Returns the size of the current message.
+  std::size_t size() const { return buffer_.size() - message_offset_; }
+
+ private:
+  struct Message {
+    std::size_t offset;
+    std::size_t size;
+    Clock::time_point queued;
+  };
+
+  static Options Sanitize(Options options) {
+    options.batch_size = std::max<std::size_t>(options.batch_size, 1);
+    options.max_message_size =
+        std::max<std::size_t>(options.max_message_size, 1);
+    return options;
+  }
+
+  void PrepareBatch(std::size_t first, std::size_t count) {
+    vectors_.resize(count);
+    headers_.resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+      const Message& message = messages_[first + i];
+      vectors_[i] = {buffer_.data() + message.offset, message.size};
+      headers_[i] = {};
+      headers_[i].msg_hdr.msg_iov = &vectors_[i];
+      headers_[i].msg_hdr.msg_iovlen = 1;
+    }
+  }
+
+  // Removes the first |count| messages from the queue, moving the remaining
+  // messages and the current message to the front of the buffer.
+  void Consume(std::size_t count) {
+    if (count == 0)
+      return;
+
+    const std::size_t consumed = count < messages_.size()
+                                     ? messages_[count].offset
+                                     : message_offset_;
+    buffer_.erase(buffer_.begin(), buffer_.begin() + consumed);
+    messages_.erase(messages_.begin(), messages_.begin() + count);
+    for (Message& message : messages_)
+      message.offset -= consumed;
+    message_offset_ -= consumed;
+  }
+
+  int socket_fd_{-1};
+  Options options_;
+  Stats stats_{0, 0, 0, 0};
+
+  // Queued messages followed by the current message.
+  std::vector<std::uint8_t> buffer_;
+  std::size_t message_offset_{0};
+  std::vector<Message> messages_;
+
+  std::vector<iovec> vectors_;
+  std::vector<mmsghdr> headers_;
+
+  DatagramWriter(const DatagramWriter&) = delete;
+  DatagramWriter& operator=(const DatagramWriter&) = delete;
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_DATAGRAM_WRITER_H_
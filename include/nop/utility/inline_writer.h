@@ -0,0 +1,144 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_INLINE_WRITER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_INLINE_WRITER_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#include <nop/base/encoding.h>
+#include <nop/base/utility.h>
+
+namespace nop {
+
+// InlineWriter is a writer with Capacity bytes of inline storage that moves to
+// a heap buffer only when Prepare() requests more space than is available.
+// Values that fit in the inline storage serialize without any heap allocation,
+// while larger values still succeed. The written bytes are always contiguous
+// at data().
+//
+// Like BufferWriter, bounds are only checked in Prepare(). This type is safe
+// for use with the library-provided Serializer types, which predicate
+// serialization on the result of Prepare().
+//
+// Example:
+//
+//   nop::Serializer<nop::InlineWriter<256>> serializer;
+//   auto status = serializer.Write(message);
+//   Send(serializer.writer().data(), serializer.writer().size());
+//
+template <std::size_t Capacity>
+class InlineWriter {
+  static_assert(Capacity > 0, "Capacity must be non-zero.");
+
+ public:
+  InlineWriter() = default;
+
+  InlineWriter(InlineWriter&& other) noexcept { *this = std::move(other); }
+
+  InlineWriter& operator=(InlineWriter&& other) noexcept {
+    if (this != &other) {
+      if (other.spilled()) {
+        heap_ = std::move(other.heap_);
+        buffer_ = heap_.get();
+      } else {
+        heap_.reset();
+        buffer_ = inline_;
+        std::memcpy(inline_, other.inline_, other.index_);
+      }
+      size_ = other.size_;
+      index_ = other.index_;
+      other.heap_.reset();
+      other.buffer_ = other.inline_;
+      other.size_ = Capacity;
+      other.index_ = 0;
+    }
+    return *this;
+  }
+
+  Status<void> Prepare(std::size_t size) {
+    if (size_ - index_ < size)
+      Spill(index_ + size);
+    return {};
+  }
+
+  Status<void> Write(std::uint8_t byte) { return Write(&byte, &byte + 1); }
+
+  template <typename T, typename Enable = EnableIfArithmetic<T>>
+  Status<void> Write(const T* begin, const T* end) {
+    const std::size_t length_bytes = (end - begin) * sizeof(T);
+    std::memcpy(&buffer_[index_], begin, length_bytes);
+    index_ += length_bytes;
+    return {};
+  }
+
+  Status<void> Skip(std::size_t padding_bytes,
+                    std::uint8_t padding_value = 0x00) {
+    std::memset(&buffer_[index_], padding_value, padding_bytes);
+    index_ += padding_bytes;
+    return {};
+  }
+
+  const std::uint8_t* data() const { return buffer_; }
+  std::size_t size() const { return index_; }
+  std::size_t capacity() const { return size_; }
+
+  // Returns true if the data has moved to the heap.
+  bool spilled() const { return buffer_ != inline_; }
+
+  // Discards the written data, keeping the current buffer.
+  void clear() { index_ = 0; }
+
+  // Returns to the inline storage if the written data fits in it.
+  void shrink_to_fit() {
+    if (spilled() && index_ <= Capacity) {
+      std::memcpy(inline_, buffer_, index_);
+      heap_.reset();
+      buffer_ = inline_;
+      size_ = Capacity;
+    }
+  }
+
+ private:
+  // Moves the data to a heap buffer of at least |size| bytes, growing
+  // geometrically so that repeated writes take amortized constant time.
+  void Spill(std::size_t size) {
+    const std::size_t new_size = std::max(size, 2 * size_);
+    std::unique_ptr<std::uint8_t[]> heap{new std::uint8_t[new_size]};
+    std::memcpy(heap.get(), buffer_, index_);
+    heap_ = std::move(heap);
+    buffer_ = heap_.get();
+    size_ = new_size;
+  }
+
+  std::uint8_t inline_[Capacity];
+  std::unique_ptr<std::uint8_t[]> heap_;
+  std::uint8_t* buffer_{inline_};
+  std::size_t size_{Capacity};
+  std::size_t index_{0};
+
+  InlineWriter(const InlineWriter&) = delete;
+  InlineWriter& operator=(const InlineWriter&) = delete;
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_INLINE_WRITER_H_
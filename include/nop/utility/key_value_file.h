@@ -0,0 +1,444 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_KEY_VALUE_FILE_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_KEY_VALUE_FILE_H_
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nop/base/encoding.h>
+#include <nop/base/serializer.h>
+#include <nop/status.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/buffer_writer.h>
+#include <nop/utility/endian.h>
+#include <nop/utility/sip_hash.h>
+
+namespace nop {
+
+//
+// Key/value file format:
+//
+// +--------+-----//-----+-----//-----+
+// | HEADER | ENTRIES    | INDEX      |
+// +--------+-----//-----+-----//-----+
+//
+// Header:
+// +-----------+-----------+------------------+
+// | U64:MAGIC | U64:COUNT | U64:INDEX OFFSET |
+// +-----------+-----------+------------------+
+//
+// ENTRIES is a sequence of COUNT encoded keys, each immediately followed by its
+// encoded value. INDEX is COUNT index entries sorted by hash and then offset:
+//
+// Index entry:
+// +----------+------------+
+// | U64:HASH | U64:OFFSET |
+// +----------+------------+
+//
+// HASH is the SipHash of the encoded key and OFFSET is the file offset of the
+// encoded key. All fields are little-endian.
+//
+struct KeyValueFileFormat {
+  enum : std::uint64_t {
+    kMagic = 0x313030564b504f4eULL,  // "NOPKV001"
+    kHashKey0 = 0x6b762d686173682dULL,
+    kHashKey1 = 0x6b657930316b6579ULL,
+  };
+
+  enum : std::size_t { kHeaderSize = 24, kIndexEntrySize = 16 };
+
+  struct IndexEntry {
+    std::uint64_t hash;
+    std::uint64_t offset;
+  };
+
+  static std::uint64_t Load64(const std::uint8_t* data) {
+    std::uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return HostEndian<std::uint64_t>::FromLittle(value);
+  }
+
+  static void Store64(std::uint64_t value, std::uint8_t* data) {
+    value = HostEndian<std::uint64_t>::ToLittle(value);
+    std::memcpy(data, &value, sizeof(value));
+  }
+
+  static std::uint64_t Hash(const std::uint8_t* data, std::size_t size) {
+    return SipHash::Compute(BlockReader<std::uint8_t>{data, size}, kHashKey0,
+                            kHashKey1);
+  }
+};
+
+// Builds a key/value file from entries added in any order. The entries are
+// written to the file as they are added; the index is held in memory, using 16
+// bytes per entry, until Finish() sorts it and appends it to the file.
+//
+// Keys are compared by their encodings, so keys that are equal must encode to
+// the same bytes. If a key is added more than once, lookups return the value
+// that was added first.
+//
+// Example:
+//
+//  nop::KeyValueFileBuilder<std::string, Record> builder;
+//  auto status = builder.Open("records.kv");
+//  for (const auto& record : records)
+//    status = builder.Add(record.name, record);
+//  status = builder.Finish();
+//
+template <typename Key, typename Value>
+class KeyValueFileBuilder {
+ public:
+  enum : std::size_t { kDefaultBufferSize = 64 * 1024 };
+
+  explicit KeyValueFileBuilder(std::size_t buffer_size = kDefaultBufferSize)
+      : buffer_size_{buffer_size} {}
+  ~KeyValueFileBuilder() { Reset(); }
+
+  KeyValueFileBuilder(const KeyValueFileBuilder&) = delete;
+  KeyValueFileBuilder& operator=(const KeyValueFileBuilder&) = delete;
+
+  // Creates the file at |path|, replacing any existing file.
+  Status<void> Open(const std::string& path) {
+    Reset();
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+      return ErrorStatus::IOError;
+
+    // The header is rewritten by Finish() once the index offset is known.
+    buffer_.resize(Format::kHeaderSize);
+    return {};
+  }
+
+  Status<void> Add(const Key& key, const Value& value) {
+    if (fd_ < 0)
+      return ErrorStatus::IOError;
+
+    const std::size_t key_size = Encoding<Key>::Size(key);
+    const std::size_t value_size = Encoding<Value>::Size(value);
+    const std::size_t offset = buffer_.size();
+    buffer_.resize(offset + key_size + value_size);
+
+    Serializer<BufferWriter> serializer{&buffer_[offset],
+                                        key_size + value_size};
+    auto status = serializer.Write(key);
+    if (status)
+      status = serializer.Write(value);
+    if (!status) {
+      buffer_.resize(offset);
+      return status;
+    }
+
+    index_.push_back({Format::Hash(&buffer_[offset], key_size),
+                      written_ + offset});
+
+    if (buffer_.size() >= buffer_size_)
+      return Flush();
+    else
+      return {};
+  }
+
+  // Writes the index and header and closes the file.
+  Status<void> Finish() {
+    if (fd_ < 0)
+      return ErrorStatus::IOError;
+
+    auto status = Flush();
+    if (!status)
+      return Fail(status.error());
+
+    const std::uint64_t index_offset = written_;
+    std::sort(index_.begin(), index_.end(),
+              [](const IndexEntry& a, const IndexEntry& b) {
+                return a.hash < b.hash ||
+                       (a.hash == b.hash && a.offset < b.offset);
+              });
+
+    for (const IndexEntry& entry : index_) {
+      const std::size_t offset = buffer_.size();
+      buffer_.resize(offset + Format::kIndexEntrySize);
+      Format::Store64(entry.hash, &buffer_[offset]);
+      Format::Store64(entry.offset, &buffer_[offset + 8]);
+      if (buffer_.size() >= buffer_size_) {
+        status = Flush();
+        if (!status)
+          return Fail(status.error());
+      }
+    }
+
+    status = Flush();
+    if (!status)
+      return Fail(status.error());
+
+    std::uint8_t header[Format::kHeaderSize];
+    Format::Store64(Format::kMagic, header);
+    Format::Store64(index_.size(), header + 8);
+    Format::Store64(index_offset, header + 16);
+    if (::pwrite(fd_, header, sizeof(header), 0) != sizeof(header) ||
+        ::fsync(fd_) < 0) {
+      return Fail(ErrorStatus::IOError);
+    }
+
+    Reset();
+    return {};
+  }
+
+  // Returns the number of entries added.
+  std::size_t size() const { return index_.size(); }
+
+ private:
+  using Format = KeyValueFileFormat;
+  using IndexEntry = Format::IndexEntry;
+
+  Status<void> Flush() {
+    const std::uint8_t* data = buffer_.data();
+    std::size_t size = buffer_.size();
+    while (size > 0) {
+      const ssize_t count = ::write(fd_, data, size);
+      if (count < 0 && errno == EINTR)
+        continue;
+      else if (count < 0)
+        return ErrorStatus::IOError;
+
+      data += count;
+      size -= count;
+      written_ += count;
+    }
+
+    buffer_.clear();
+    return {};
+  }
+
+  ErrorStatus Fail(ErrorStatus error) {
+    Reset();
+    return error;
+  }
+
+  void Reset() {
+    if (fd_ >= 0)
+      ::close(fd_);
+    fd_ = -1;
+    buffer_.clear();
+    written_ = 0;
+    index_.clear();
+  }
+
+  int fd_{-1};
+  std::size_t buffer_size_;
+  std::vector<std::uint8_t> buffer_;
+  std::uint64_t written_{0};
+  std::vector<IndexEntry> index_;
+};
+
+// Reads a key/value file mapped into memory. Opening a file only maps it and
+// checks its header, so startup time does not depend on the number of entries.
+// The mapping is shared, so processes that open the same file share its pages
+// through the page cache.
+//
+// Lookups binary search the index and decode only the requested value. Find()
+// does not modify the reader and may be called concurrently.
+//
+// Example:
+//
+//  nop::KeyValueFileReader<std::string, Record> reader;
+//  auto status = reader.Open("records.kv");
+//
+//  Record record;
+//  auto found = reader.Find("name", &record);
+//  if (found && found.get())
+//    Use(record);
+//
+template <typename Key, typename Value>
+class KeyValueFileReader {
+ public:
+  KeyValueFileReader() = default;
+  KeyValueFileReader(KeyValueFileReader&& other) { *this = std::move(other); }
+  ~KeyValueFileReader() { Close(); }
+
+  KeyValueFileReader& operator=(KeyValueFileReader&& other) {
+    if (this != &other) {
+      Close();
+      std::swap(mapping_, other.mapping_);
+      std::swap(data_, other.data_);
+      std::swap(size_, other.size_);
+      std::swap(count_, other.count_);
+      std::swap(index_offset_, other.index_offset_);
+    }
+    return *this;
+  }
+
+  // Maps the file at |path|.
+  Status<void> Open(const std::string& path) {
+    Close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      return ErrorStatus::IOError;
+
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) < 0) {
+      ::close(fd);
+      return ErrorStatus::IOError;
+    }
+
+    const std::size_t size = file_stat.st_size;
+    if (size > 0) {
+      void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+      if (mapping == MAP_FAILED) {
+        ::close(fd);
+        return ErrorStatus::IOError;
+      }
+      mapping_ = mapping;
+    }
+    ::close(fd);
+
+    auto status = Load(mapping_, size);
+    if (!status)
+      Close();
+    return status;
+  }
+
+  // Reads the file in the given buffer, which must outlive the reader.
+  Status<void> Open(const void* data, std::size_t size) {
+    Close();
+    return Load(data, size);
+  }
+
+  void Close() {
+    if (mapping_ != nullptr)
+      ::munmap(mapping_, size_);
+    mapping_ = nullptr;
+    data_ = nullptr;
+    size_ = 0;
+    count_ = 0;
+    index_offset_ = 0;
+  }
+
+  // Returns the number of entries in the file.
+  std::size_t size() const { return count_; }
+
+  // Looks up |key| and decodes its value into |value|. Returns true if the key
+  // was found, false if it was not, or an error if the file is malformed.
+  Status<bool> Find(const Key& key, Value* value) const {
+    // Encode the key on the stack when it is small enough.
+    enum : std::size_t { kKeyBufferSize = 64 };
+    std::array<std::uint8_t, kKeyBufferSize> key_array;
+    std::vector<std::uint8_t> key_vector;
+
+    const std::size_t key_size = Encoding<Key>::Size(key);
+    std::uint8_t* key_data = key_array.data();
+    if (key_size > kKeyBufferSize) {
+      key_vector.resize(key_size);
+      key_data = key_vector.data();
+    }
+
+    BufferWriter writer{key_data, key_size};
+    auto status = Encoding<Key>::Write(key, &writer);
+    if (!status)
+      return status.error();
+
+    const std::uint64_t hash = Format::Hash(key_data, key_size);
+    for (std::size_t i = LowerBound(hash);
+         i < count_ && IndexHash(i) == hash; i++) {
+      const std::uint64_t offset = IndexOffset(i);
+      if (offset < Format::kHeaderSize || offset > index_offset_)
+        return ErrorStatus::ProtocolError;
+      if (index_offset_ - offset < key_size ||
+          std::memcmp(data_ + offset, key_data, key_size) != 0) {
+        continue;
+      }
+
+      Deserializer<BufferReader> deserializer{
+          data_ + offset + key_size, index_offset_ - offset - key_size};
+      status = deserializer.Read(value);
+      if (!status)
+        return status.error();
+      return true;
+    }
+
+    return false;
+  }
+
+ private:
+  using Format = KeyValueFileFormat;
+
+  Status<void> Load(const void* data, std::size_t size) {
+    data_ = static_cast<const std::uint8_t*>(data);
+    size_ = size;
+    if (size_ < Format::kHeaderSize || Format::Load64(data_) != Format::kMagic)
+      return ErrorStatus::ProtocolError;
+
+    const std::uint64_t count = Format::Load64(data_ + 8);
+    const std::uint64_t index_offset = Format::Load64(data_ + 16);
+    if (index_offset < Format::kHeaderSize || index_offset > size_ ||
+        (size_ - index_offset) / Format::kIndexEntrySize != count ||
+        (size_ - index_offset) % Format::kIndexEntrySize != 0) {
+      return ErrorStatus::ProtocolError;
+    }
+
+    count_ = count;
+    index_offset_ = index_offset;
+    return {};
+  }
+
+  std::uint64_t IndexHash(std::size_t i) const {
+    return Format::Load64(data_ + index_offset_ + i * Format::kIndexEntrySize);
+  }
+
+  std::uint64_t IndexOffset(std::size_t i) const {
+    return Format::Load64(data_ + index_offset_ +
+                          i * Format::kIndexEntrySize + 8);
+  }
+
+  // Returns the first index entry with a hash not less than |hash|.
+  std::size_t LowerBound(std::uint64_t hash) const {
+    std::size_t begin = 0;
+    std::size_t count = count_;
+    while (count > 0) {
+      const std::size_t step = count / 2;
+      if (IndexHash(begin + step) < hash) {
+        begin += step + 1;
+        count -= step + 1;
+      } else {
+        count = step;
+      }
+    }
+    return begin;
+  }
+
+  void* mapping_{nullptr};
+  const std::uint8_t* data_{nullptr};
+  std::size_t size_{0};
+  std::size_t count_{0};
+  std::size_t index_offset_{0};
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_KEY_VALUE_FILE_H_
@@ -0,0 +1,289 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_MEMORY_ARENA_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_MEMORY_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if __cplusplus >= 201703L && __has_include(<memory_resource>)
+#include <memory_resource>
+#define NOP_HAS_MEMORY_RESOURCE 1
+#endif
+
+namespace nop {
+
+// MemoryArena is a monotonic allocator that carves allocations out of large
+// blocks. Individual deallocations are no-ops; all of the memory handed out by
+// the arena is released at once by Reset() or when the arena is destroyed.
+// This makes freeing a decoded message with many nested containers a single
+// operation instead of one free per container.
+//
+// Reset() keeps the current block for reuse, so an arena that
+// decodes similar messages in a loop settles into making no system allocations
+// at all.
+//
+// MemoryArena is not thread safe. Values allocated from an arena must not be
+// decoded with parallel readers (see IsParallelReader) or shared between
+// threads that allocate.
+class MemoryArena {
+ public:
+  enum : std::size_t { kDefaultBlockSize = 64 * 1024 };
+
+  explicit MemoryArena(std::size_t block_size = kDefaultBlockSize)
+      : block_size_{block_size} {}
+  ~MemoryArena() { Release(nullptr); }
+
+  MemoryArena(const MemoryArena&) = delete;
+  MemoryArena& operator=(const MemoryArena&) = delete;
+
+  // Returns |size| bytes aligned to |alignment|, which must be a power of two.
+  void* Allocate(std::size_t size, std::size_t alignment) {
+    // Allocations larger than the block size get a block of their own, which
+    // leaves the space remaining in the current block for later allocations.
+    if (size + alignment > block_size_) {
+      bytes_allocated_ += size;
+      return reinterpret_cast<void*>(
+          AlignUp(BlockBegin(NewLargeBlock(size + alignment)), alignment));
+    }
+
+    std::uintptr_t address = AlignUp(cursor_, alignment);
+    if (head_ == nullptr || address > end_ || end_ - address < size) {
+      NewBlock();
+      address = AlignUp(cursor_, alignment);
+    }
+
+    cursor_ = address + size;
+    bytes_allocated_ += size;
+    return reinterpret_cast<void*>(address);
+  }
+
+  // Releases every allocation made from the arena. Values holding memory from
+  // the arena must not be used after this call.
+  void Reset() {
+    if (head_ != nullptr) {
+      Release(head_);
+      head_->next = nullptr;
+      cursor_ = BlockBegin(head_);
+      end_ = BlockEnd(head_);
+    }
+    bytes_allocated_ = 0;
+  }
+
+  // Returns the number of bytes handed out since the last reset.
+  std::size_t bytes_allocated() const { return bytes_allocated_; }
+
+  // Returns the number of blocks currently held by the arena.
+  std::size_t block_count() const {
+    std::size_t count = 0;
+    for (const Block* block = head_; block != nullptr; block = block->next)
+      count++;
+    return count;
+  }
+
+  // Returns the arena installed on the calling thread by ArenaScope, or nullptr
+  // if there is none. Default-constructed ArenaAllocators allocate from this
+  // arena.
+  static MemoryArena* current() { return CurrentSlot(); }
+
+ private:
+  friend class ArenaScope;
+
+  struct alignas(std::max_align_t) Block {
+    Block* next;
+    std::size_t size;
+  };
+
+  static MemoryArena*& CurrentSlot() {
+    static thread_local MemoryArena* arena = nullptr;
+    return arena;
+  }
+
+  static std::uintptr_t AlignUp(std::uintptr_t address, std::size_t alignment) {
+    return (address + alignment - 1) & ~std::uintptr_t{alignment - 1};
+  }
+
+  static std::uintptr_t BlockBegin(Block* block) {
+    return reinterpret_cast<std::uintptr_t>(block + 1);
+  }
+  static std::uintptr_t BlockEnd(Block* block) {
+    return BlockBegin(block) + block->size;
+  }
+
+  void NewBlock() {
+    Block* block = AllocateBlock(block_size_);
+    block->next = head_;
+    head_ = block;
+    cursor_ = BlockBegin(block);
+    end_ = BlockEnd(block);
+  }
+
+  // Links a block for a single large allocation behind the current block.
+  Block* NewLargeBlock(std::size_t size) {
+    if (head_ == nullptr)
+      NewBlock();
+
+    Block* block = AllocateBlock(size);
+    block->next = head_->next;
+    head_->next = block;
+    return block;
+  }
+
+  static Block* AllocateBlock(std::size_t size) {
+    Block* block = static_cast<Block*>(::operator new(sizeof(Block) + size));
+    block->next = nullptr;
+    block->size = size;
+    return block;
+  }
+
+  // Frees every block after |keep|, or every block if |keep| is nullptr.
+  void Release(Block* keep) {
+    Block* block = keep != nullptr ? keep->next : head_;
+    while (block != nullptr) {
+      Block* next = block->next;
+      ::operator delete(block);
+      block = next;
+    }
+    if (keep == nullptr)
+      head_ = nullptr;
+  }
+
+  std::size_t block_size_;
+  Block* head_{nullptr};
+  std::uintptr_t cursor_{0};
+  std::uintptr_t end_{0};
+  std::size_t bytes_allocated_{0};
+};
+
+// ArenaScope installs an arena as the current arena of the calling thread for
+// the lifetime of the scope, restoring the previous arena when it ends. Scopes
+// may be nested.
+class ArenaScope {
+ public:
+  explicit ArenaScope(MemoryArena* arena) : previous_{MemoryArena::current()} {
+    MemoryArena::CurrentSlot() = arena;
+  }
+  ~ArenaScope() { MemoryArena::CurrentSlot() = previous_; }
+
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+
+ private:
+  MemoryArena* previous_;
+};
+
+// ArenaAllocator is a standard allocator that allocates from a MemoryArena, or
+// from the global heap when it has no arena. A default-constructed allocator
+// uses the current arena of the calling thread (see ArenaScope), which is how
+// an arena reaches containers nested inside structures, arrays, and other
+// values that are default-constructed during decoding.
+//
+// Copy-constructing a container selects a new default-constructed allocator,
+// so a copy made outside of an ArenaScope lives on the heap and may outlive the
+// arena. Move-construction and move-assignment keep the arena.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  ArenaAllocator() noexcept : arena_{MemoryArena::current()} {}
+  explicit ArenaAllocator(MemoryArena* arena) noexcept : arena_{arena} {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+      : arena_{other.arena()} {}
+
+  T* allocate(std::size_t count) {
+    if (arena_ != nullptr)
+      return static_cast<T*>(arena_->Allocate(count * sizeof(T), alignof(T)));
+    else
+      return static_cast<T*>(::operator new(count * sizeof(T)));
+  }
+
+  void deallocate(T* pointer, std::size_t /*count*/) noexcept {
+    if (arena_ == nullptr)
+      ::operator delete(pointer);
+  }
+
+  ArenaAllocator select_on_container_copy_construction() const {
+    return ArenaAllocator{};
+  }
+
+  MemoryArena* arena() const { return arena_; }
+
+ private:
+  MemoryArena* arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.arena() == b.arena();
+}
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.arena() != b.arena();
+}
+
+// Container aliases using ArenaAllocator.
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+using ArenaString =
+    std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+template <typename Key, typename T, typename Compare = std::less<Key>>
+using ArenaMap =
+    std::map<Key, T, Compare, ArenaAllocator<std::pair<const Key, T>>>;
+
+#ifdef NOP_HAS_MEMORY_RESOURCE
+
+// ArenaMemoryResource adapts a MemoryArena to std::pmr::memory_resource for use
+// with std::pmr containers. Nested pmr containers receive the resource of their
+// parent through uses-allocator construction, including the temporaries used
+// to decode container elements.
+class ArenaMemoryResource : public std::pmr::memory_resource {
+ public:
+  explicit ArenaMemoryResource(MemoryArena* arena) : arena_{arena} {}
+
+  MemoryArena* arena() const { return arena_; }
+
+ private:
+  void* do_allocate(std::size_t size, std::size_t alignment) override {
+    return arena_->Allocate(size, alignment);
+  }
+  void do_deallocate(void* /*pointer*/, std::size_t /*size*/,
+                     std::size_t /*alignment*/) override {}
+  bool do_is_equal(const std::pmr::memory_resource& other) const
+      noexcept override {
+    return this == &other;
+  }
+
+  MemoryArena* arena_;
+};
+
+#endif  // NOP_HAS_MEMORY_RESOURCE
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_MEMORY_ARENA_H_
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_PARALLEL_BUFFER_READER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_PARALLEL_BUFFER_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/thread_pool.h>
+
+namespace nop {
+
+// Buffer reader that decodes the elements of very large non-integral vectors
+// on multiple threads. The encoded elements are first scanned structurally to
+// find the offsets at which each task begins, then the tasks decode their
+// elements directly into a pre-sized vector. The result is identical to that
+// of BufferReader.
+//
+// Executor is any type that provides the interface described in
+// IsParallelWriter, defaulting to ThreadPool. The executor must outlive the
+// reader. Element types must not contain handles.
+//
+// Example:
+//
+//  nop::ThreadPool pool;
+//  nop::Deserializer<nop::ParallelBufferReader<>> deserializer{
+//      buffer.data(), buffer.size(), &pool};
+//  auto status = deserializer.Read(&large_value);
+//
+template <typename Executor = ThreadPool>
+class ParallelBufferReader : public BufferReader {
+ public:
+  ParallelBufferReader() = default;
+  ParallelBufferReader(const ParallelBufferReader&) = default;
+  ParallelBufferReader(const std::uint8_t* buffer, std::size_t size,
+                       Executor* executor)
+      : BufferReader{buffer, size}, executor_{executor} {}
+  ParallelBufferReader(const void* buffer, std::size_t size,
+                       Executor* executor)
+      : BufferReader{buffer, size}, executor_{executor} {}
+
+  ParallelBufferReader& operator=(const ParallelBufferReader&) = default;
+
+  Executor* executor() const { return executor_; }
+
+ private:
+  Executor* executor_{nullptr};
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_PARALLEL_BUFFER_READER_H_
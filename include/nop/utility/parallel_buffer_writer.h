@@ -0,0 +1,66 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_PARALLEL_BUFFER_WRITER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_PARALLEL_BUFFER_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <nop/utility/buffer_writer.h>
+#include <nop/utility/thread_pool.h>
+
+namespace nop {
+
+// Buffer writer that encodes the elements of very large vectors and maps on
+// multiple threads. Elements are divided into chunks, the encoded size of each
+// chunk is computed in parallel, and each chunk is then written to its own
+// region of the buffer. The output is identical to that of BufferWriter.
+//
+// Executor is any type that provides the interface described in
+// IsParallelWriter, defaulting to ThreadPool. The executor must outlive the
+// writer. Element types must not contain handles.
+//
+// Example:
+//
+//  nop::ThreadPool pool;
+//  std::vector<std::uint8_t> buffer(serializer_size);
+//  nop::Serializer<nop::ParallelBufferWriter<>> serializer{
+//      buffer.data(), buffer.size(), &pool};
+//  auto status = serializer.Write(large_value);
+//
+template <typename Executor = ThreadPool>
+class ParallelBufferWriter : public BufferWriter {
+ public:
+  ParallelBufferWriter() = default;
+  ParallelBufferWriter(const ParallelBufferWriter&) = default;
+  ParallelBufferWriter(std::uint8_t* buffer, std::size_t size,
+                       Executor* executor)
+      : BufferWriter{buffer, size}, executor_{executor} {}
+  ParallelBufferWriter(void* buffer, std::size_t size, Executor* executor)
+      : BufferWriter{buffer, size}, executor_{executor} {}
+
+  ParallelBufferWriter& operator=(const ParallelBufferWriter&) = default;
+
+  Executor* executor() const { return executor_; }
+
+ private:
+  Executor* executor_{nullptr};
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_PARALLEL_BUFFER_WRITER_H_
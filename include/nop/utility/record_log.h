@@ -0,0 +1,707 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_RECORD_LOG_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_RECORD_LOG_H_
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nop/base/encoding.h>
+#include <nop/status.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/buffer_writer.h>
+#include <nop/utility/endian.h>
+#include <nop/utility/sip_hash.h>
+
+namespace nop {
+
+//
+// Record log file format:
+//
+// +--------+-----//-----+--------//--------+
+// | HEADER | BODY       | FOOTER (OPTIONAL) |
+// +--------+-----//-----+--------//--------+
+//
+// HEADER is an 8 byte magic value. BODY is a sequence of records, each of
+// which is preceded by a sync block when its record number is a multiple of
+// the sync interval:
+//
+// Sync block:
+// +------------+------------+
+// | U64:MAGIC  | U64:RECORD |
+// +------------+------------+
+//
+// Record:
+// +--------------+------------+---------------+---------+
+// | U64:CHECKSUM | U32:LENGTH | U64:TIMESTAMP | PAYLOAD |
+// +--------------+------------+---------------+---------+
+//
+// PAYLOAD is LENGTH bytes holding exactly one encoded value. CHECKSUM is the
+// SipHash of LENGTH, TIMESTAMP, and PAYLOAD.
+//
+// FOOTER is written when a log is closed and holds the sparse index: one entry
+// for each sync block, followed by a fixed-size trailer:
+//
+// Index entry:
+// +------------+---------------+------------+
+// | U64:RECORD | U64:TIMESTAMP | U64:OFFSET |
+// +------------+---------------+------------+
+//
+// Trailer:
+// +------------+-----------+-------------+--------------+-----------+
+// | U64:OFFSET | U64:COUNT | U64:RECORDS | U64:CHECKSUM | U64:MAGIC |
+// +------------+-----------+-------------+--------------+-----------+
+//
+// OFFSET is the file offset of the first index entry, COUNT is the number of
+// index entries, RECORDS is the number of records in the body, and CHECKSUM is
+// the SipHash of the index entries and the first three trailer fields. Each
+// index entry gives the file offset of a sync block and the record number and
+// timestamp of the record that follows it.
+//
+// A log without a valid footer, because it was not closed or its last write
+// was torn, is indexed by scanning the body. The scan stops at the first sync
+// block or record that is incomplete or fails its checksum.
+//
+// All fields are little-endian.
+//
+struct RecordLogFormat {
+  enum : std::uint64_t {
+    kFileMagic = 0x3130474f4c504f4eULL,   // "NOPLOG01"
+    kSyncMagic = 0x434e5953474f4c4eULL,   // "NLOGSYNC"
+    kIndexMagic = 0x58444e49474f4c4eULL,  // "NLOGINDX"
+    kChecksumKey0 = 0x6c6f672d6b657930ULL,
+    kChecksumKey1 = 0x6c6f672d6b657931ULL,
+  };
+
+  enum : std::uint64_t { kSyncInterval = 64 };
+
+  enum : std::size_t {
+    kHeaderSize = 8,
+    kSyncSize = 16,
+    kRecordHeaderSize = 20,
+    kIndexEntrySize = 24,
+    kTrailerSize = 40,
+  };
+
+  struct IndexEntry {
+    std::uint64_t record;
+    std::uint64_t timestamp;
+    std::uint64_t offset;
+  };
+
+  static std::uint64_t Load64(const std::uint8_t* data) {
+    std::uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return HostEndian<std::uint64_t>::FromLittle(value);
+  }
+
+  static std::uint32_t Load32(const std::uint8_t* data) {
+    std::uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return HostEndian<std::uint32_t>::FromLittle(value);
+  }
+
+  static void Store64(std::uint64_t value, std::uint8_t* data) {
+    value = HostEndian<std::uint64_t>::ToLittle(value);
+    std::memcpy(data, &value, sizeof(value));
+  }
+
+  static void Store32(std::uint32_t value, std::uint8_t* data) {
+    value = HostEndian<std::uint32_t>::ToLittle(value);
+    std::memcpy(data, &value, sizeof(value));
+  }
+
+  static std::uint64_t Checksum(const std::uint8_t* data, std::size_t size) {
+    return SipHash::Compute(BlockReader<std::uint8_t>{data, size},
+                            kChecksumKey0, kChecksumKey1);
+  }
+};
+
+// A record read from a RecordLogReader. The payload points into the log
+// mapping and remains valid as long as the reader is open.
+struct LogRecord {
+  std::uint64_t index;
+  std::uint64_t timestamp;
+  const std::uint8_t* data;
+  std::size_t size;
+};
+
+// Reads a record log that is mapped into memory. Records may be read in order
+// from any starting point, located by record number or timestamp using the
+// sparse index in O(log n) plus a scan of at most one sync interval. Seeking by
+// timestamp assumes that timestamps are non-decreasing.
+//
+// Values are decoded directly from the mapping, so types that borrow from
+// contiguous readers, such as RawValue and Lazy<T>, do not copy the payload.
+//
+// Example of replaying a log:
+//
+//  nop::RecordLogReader reader;
+//  auto status = reader.Open("events.log");
+//  if (!status)
+//    return status;
+//
+//  Event event;
+//  while ((status = reader.Read(&event)))
+//    Apply(event);
+//  if (status.error() != nop::ErrorStatus::ReadLimitReached)
+//    return status;
+//
+class RecordLogReader {
+ public:
+  RecordLogReader() = default;
+  RecordLogReader(RecordLogReader&& other) { *this = std::move(other); }
+  ~RecordLogReader() { Close(); }
+
+  RecordLogReader& operator=(RecordLogReader&& other) {
+    if (this != &other) {
+      Close();
+      std::swap(mapping_, other.mapping_);
+      std::swap(data_, other.data_);
+      std::swap(size_, other.size_);
+      std::swap(body_end_, other.body_end_);
+      std::swap(torn_, other.torn_);
+      std::swap(record_count_, other.record_count_);
+      std::swap(index_, other.index_);
+      std::swap(cursor_, other.cursor_);
+      std::swap(next_record_, other.next_record_);
+    }
+    return *this;
+  }
+
+  // Maps the log file at |path| and loads or rebuilds its index.
+  Status<void> Open(const std::string& path) {
+    Close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      return ErrorStatus::IOError;
+
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) < 0) {
+      ::close(fd);
+      return ErrorStatus::IOError;
+    }
+
+    const std::size_t size = file_stat.st_size;
+    if (size > 0) {
+      void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+      if (mapping == MAP_FAILED) {
+        ::close(fd);
+        return ErrorStatus::IOError;
+      }
+      mapping_ = mapping;
+    }
+    ::close(fd);
+
+    auto status = Load(mapping_, size);
+    if (!status)
+      Close();
+    return status;
+  }
+
+  // Reads the log in the given buffer, which must outlive the reader.
+  Status<void> Open(const void* data, std::size_t size) {
+    Close();
+    return Load(data, size);
+  }
+
+  void Close() {
+    if (mapping_ != nullptr)
+      ::munmap(mapping_, size_);
+    mapping_ = nullptr;
+    data_ = nullptr;
+    size_ = 0;
+    body_end_ = 0;
+    torn_ = false;
+    record_count_ = 0;
+    index_.clear();
+    cursor_ = 0;
+    next_record_ = 0;
+  }
+
+  // Returns the number of complete, valid records in the log.
+  std::uint64_t record_count() const { return record_count_; }
+
+  // Returns the offset of the end of the last valid record.
+  std::size_t valid_size() const { return body_end_; }
+
+  // Returns true if the log ends with bytes that are not part of a valid
+  // record or footer, such as a record whose write was interrupted.
+  bool torn() const { return torn_; }
+
+  // Returns the number of the record that the next call to Next() returns.
+  std::uint64_t position() const { return next_record_; }
+
+  // Returns the next record in the log, or ErrorStatus::ReadLimitReached at the
+  // end of the log.
+  Status<LogRecord> Next() {
+    if (next_record_ >= record_count_)
+      return ErrorStatus::ReadLimitReached;
+
+    std::size_t offset = cursor_;
+    if (next_record_ % Format::kSyncInterval == 0) {
+      if (!IsSyncBlock(offset, next_record_))
+        return ErrorStatus::ProtocolError;
+      offset += Format::kSyncSize;
+    }
+
+    auto status = ParseRecord(offset);
+    if (!status)
+      return status;
+
+    LogRecord record = status.get();
+    record.index = next_record_;
+    cursor_ = (record.data - data_) + record.size;
+    next_record_++;
+    return record;
+  }
+
+  // Decodes the next record into |value|. The value must occupy the entire
+  // record payload.
+  template <typename T>
+  Status<void> Read(T* value, std::uint64_t* timestamp = nullptr) {
+    auto status = Next();
+    if (!status)
+      return status.error();
+
+    const LogRecord& record = status.get();
+    BufferReader reader{record.data, record.size};
+    auto read_status = Encoding<T>::Read(value, &reader);
+    if (!read_status)
+      return read_status;
+    else if (!reader.empty())
+      return ErrorStatus::InvalidContainerLength;
+
+    if (timestamp)
+      *timestamp = record.timestamp;
+    return {};
+  }
+
+  // Positions the reader so that the next record returned is record |index|.
+  // Seeking to record_count() positions the reader at the end of the log.
+  Status<void> Seek(std::uint64_t index) {
+    if (index > record_count_)
+      return ErrorStatus::ReadLimitReached;
+
+    SeekBefore(std::upper_bound(
+        index_.begin(), index_.end(), index,
+        [](std::uint64_t record, const IndexEntry& entry) {
+          return record < entry.record;
+        }));
+    while (next_record_ < index) {
+      auto status = Next();
+      if (!status)
+        return status.error();
+    }
+    return {};
+  }
+
+  // Positions the reader at the first record with a timestamp greater than or
+  // equal to |timestamp|, or at the end of the log if there is none.
+  Status<void> SeekTimestamp(std::uint64_t timestamp) {
+    SeekBefore(std::lower_bound(
+        index_.begin(), index_.end(), timestamp,
+        [](const IndexEntry& entry, std::uint64_t time) {
+          return entry.timestamp < time;
+        }));
+    while (true) {
+      const std::size_t cursor = cursor_;
+      const std::uint64_t next_record = next_record_;
+      auto status = Next();
+      if (!status && status.error() == ErrorStatus::ReadLimitReached)
+        return {};
+      else if (!status)
+        return status.error();
+
+      if (status.get().timestamp >= timestamp) {
+        cursor_ = cursor;
+        next_record_ = next_record;
+        return {};
+      }
+    }
+  }
+
+ private:
+  friend class RecordLogWriter;
+  using Format = RecordLogFormat;
+  using IndexEntry = Format::IndexEntry;
+
+  Status<void> Load(const void* data, std::size_t size) {
+    data_ = static_cast<const std::uint8_t*>(data);
+    size_ = size;
+    if (size_ < Format::kHeaderSize ||
+        Format::Load64(data_) != Format::kFileMagic) {
+      return ErrorStatus::ProtocolError;
+    }
+
+    if (!LoadFooter())
+      Scan();
+
+    cursor_ = Format::kHeaderSize;
+    next_record_ = 0;
+    return {};
+  }
+
+  // Positions the reader at the index entry preceding |upper|, or at the start
+  // of the log if there is none.
+  void SeekBefore(std::vector<IndexEntry>::const_iterator upper) {
+    if (upper == index_.cbegin()) {
+      cursor_ = Format::kHeaderSize;
+      next_record_ = 0;
+    } else {
+      cursor_ = std::prev(upper)->offset;
+      next_record_ = std::prev(upper)->record;
+    }
+  }
+
+  bool IsSyncBlock(std::size_t offset, std::uint64_t record) const {
+    return offset <= body_end_ && body_end_ - offset >= Format::kSyncSize &&
+           Format::Load64(data_ + offset) == Format::kSyncMagic &&
+           Format::Load64(data_ + offset + 8) == record;
+  }
+
+  // Parses and verifies the record at |offset|.
+  Status<LogRecord> ParseRecord(std::size_t offset) const {
+    if (offset > body_end_ || body_end_ - offset < Format::kRecordHeaderSize)
+      return ErrorStatus::ReadLimitReached;
+
+    const std::uint8_t* header = data_ + offset;
+    const std::size_t length = Format::Load32(header + 8);
+    if (body_end_ - offset - Format::kRecordHeaderSize < length)
+      return ErrorStatus::ReadLimitReached;
+
+    const std::uint64_t checksum = Format::Checksum(header + 8, 12 + length);
+    if (checksum != Format::Load64(header))
+      return ErrorStatus::ProtocolError;
+
+    return LogRecord{0, Format::Load64(header + 12),
+                     header + Format::kRecordHeaderSize, length};
+  }
+
+  // Loads the sparse index from the footer. Returns false if the log does not
+  // end with a valid footer.
+  bool LoadFooter() {
+    if (size_ < Format::kHeaderSize + Format::kTrailerSize)
+      return false;
+
+    const std::size_t trailer_offset = size_ - Format::kTrailerSize;
+    const std::uint8_t* trailer = data_ + trailer_offset;
+    if (Format::Load64(trailer + 32) != Format::kIndexMagic)
+      return false;
+
+    const std::uint64_t index_offset = Format::Load64(trailer);
+    const std::uint64_t index_count = Format::Load64(trailer + 8);
+    if (index_offset < Format::kHeaderSize || index_offset > trailer_offset)
+      return false;
+
+    const std::size_t index_size = trailer_offset - index_offset;
+    if (index_size % Format::kIndexEntrySize != 0 ||
+        index_size / Format::kIndexEntrySize != index_count) {
+      return false;
+    }
+
+    // The checksum covers the index entries and the first three trailer
+    // fields.
+    const std::uint64_t checksum =
+        Format::Checksum(data_ + index_offset, index_size + 24);
+    if (checksum != Format::Load64(trailer + 24))
+      return false;
+
+    body_end_ = index_offset;
+    torn_ = false;
+    record_count_ = Format::Load64(trailer + 16);
+    index_.clear();
+    for (const std::uint8_t* entry = data_ + index_offset; entry < trailer;
+         entry += Format::kIndexEntrySize) {
+      index_.push_back({Format::Load64(entry), Format::Load64(entry + 8),
+                        Format::Load64(entry + 16)});
+    }
+    return true;
+  }
+
+  // Rebuilds the sparse index by scanning the body, stopping at the first sync
+  // block or record that is incomplete or invalid.
+  void Scan() {
+    body_end_ = size_;
+    index_.clear();
+
+    std::size_t offset = Format::kHeaderSize;
+    std::uint64_t record = 0;
+    while (offset < size_) {
+      std::size_t record_offset = offset;
+      const bool sync = record % Format::kSyncInterval == 0;
+      if (sync) {
+        if (!IsSyncBlock(offset, record))
+          break;
+        record_offset += Format::kSyncSize;
+      }
+
+      auto status = ParseRecord(record_offset);
+      if (!status)
+        break;
+
+      if (sync)
+        index_.push_back({record, status.get().timestamp, offset});
+      offset = record_offset + Format::kRecordHeaderSize + status.get().size;
+      record++;
+    }
+
+    body_end_ = offset;
+    torn_ = offset != size_;
+    record_count_ = record;
+  }
+
+  void* mapping_{nullptr};
+  const std::uint8_t* data_{nullptr};
+  std::size_t size_{0};
+  std::size_t body_end_{0};
+  bool torn_{false};
+  std::uint64_t record_count_{0};
+  std::vector<IndexEntry> index_;
+  std::size_t cursor_{0};
+  std::uint64_t next_record_{0};
+};
+
+// Appends records to a log file through an internal buffer. The buffer is
+// written to the file when it fills, and on Flush(), Sync(), and Close().
+// Close() also writes the footer with the sparse index; a log that is not
+// closed remains readable and is indexed by scanning.
+//
+// Opening an existing log continues it: the footer, or any torn record left by
+// an interrupted write, is truncated before new records are appended.
+//
+// Example:
+//
+//  nop::RecordLogWriter writer;
+//  auto status = writer.Open("events.log");
+//  if (!status)
+//    return status;
+//
+//  status = writer.Append(event, event.time);
+//  ...
+//  status = writer.Close();
+//
+class RecordLogWriter {
+ public:
+  enum : std::size_t { kDefaultBufferSize = 64 * 1024 };
+
+  explicit RecordLogWriter(std::size_t buffer_size = kDefaultBufferSize)
+      : buffer_size_{buffer_size} {}
+  ~RecordLogWriter() { Close(); }
+
+  RecordLogWriter(const RecordLogWriter&) = delete;
+  RecordLogWriter& operator=(const RecordLogWriter&) = delete;
+
+  // Opens or creates the log file at |path| for appending.
+  Status<void> Open(const std::string& path) {
+    auto status = Close();
+    if (!status)
+      return status;
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+      return ErrorStatus::IOError;
+
+    struct stat file_stat;
+    if (::fstat(fd_, &file_stat) < 0)
+      return Fail(ErrorStatus::IOError);
+
+    // A log without a complete header holds no records and is started over.
+    if (file_stat.st_size < static_cast<off_t>(Format::kHeaderSize)) {
+      if (::ftruncate(fd_, 0) < 0)
+        return Fail(ErrorStatus::IOError);
+      buffer_.resize(Format::kHeaderSize);
+      Format::Store64(Format::kFileMagic, buffer_.data());
+      return {};
+    }
+
+    RecordLogReader reader;
+    status = reader.Open(path);
+    if (!status)
+      return Fail(status.error());
+
+    // Drop the footer or torn tail and continue after the last valid record.
+    written_ = reader.valid_size();
+    record_count_ = reader.record_count();
+    index_ = std::move(reader.index_);
+    reader.Close();
+
+    if (::ftruncate(fd_, written_) < 0 || ::lseek(fd_, written_, SEEK_SET) < 0)
+      return Fail(ErrorStatus::IOError);
+    return {};
+  }
+
+  // Appends |value| as a record with the given timestamp.
+  template <typename T>
+  Status<void> Append(const T& value, std::uint64_t timestamp) {
+    if (fd_ < 0)
+      return ErrorStatus::IOError;
+
+    const std::size_t length = Encoding<T>::Size(value);
+    if (length > std::numeric_limits<std::uint32_t>::max())
+      return ErrorStatus::WriteLimitReached;
+
+    const std::size_t begin = buffer_.size();
+    const bool sync = record_count_ % Format::kSyncInterval == 0;
+    std::size_t offset = begin;
+    if (sync) {
+      buffer_.resize(offset + Format::kSyncSize);
+      Format::Store64(Format::kSyncMagic, &buffer_[offset]);
+      Format::Store64(record_count_, &buffer_[offset + 8]);
+      offset += Format::kSyncSize;
+    }
+
+    buffer_.resize(offset + Format::kRecordHeaderSize + length);
+    std::uint8_t* header = &buffer_[offset];
+    BufferWriter writer{header + Format::kRecordHeaderSize, length};
+    auto status = Encoding<T>::Write(value, &writer);
+    if (!status) {
+      buffer_.resize(begin);
+      return status;
+    }
+
+    Format::Store32(length, header + 8);
+    Format::Store64(timestamp, header + 12);
+    Format::Store64(Format::Checksum(header + 8, 12 + length), header);
+
+    if (sync)
+      index_.push_back({record_count_, timestamp, written_ + begin});
+    record_count_++;
+
+    if (buffer_.size() >= buffer_size_)
+      return Flush();
+    else
+      return {};
+  }
+
+  // Writes buffered records to the file.
+  Status<void> Flush() {
+    const std::uint8_t* data = buffer_.data();
+    std::size_t size = buffer_.size();
+    while (size > 0) {
+      const ssize_t count = ::write(fd_, data, size);
+      if (count < 0 && errno == EINTR)
+        continue;
+      else if (count < 0)
+        return ErrorStatus::IOError;
+
+      data += count;
+      size -= count;
+      written_ += count;
+    }
+
+    buffer_.clear();
+    return {};
+  }
+
+  // Writes buffered records to the file and waits for them to reach storage.
+  Status<void> Sync() {
+    auto status = Flush();
+    if (!status)
+      return status;
+
+    if (::fdatasync(fd_) < 0)
+      return ErrorStatus::IOError;
+    return {};
+  }
+
+  // Writes buffered records and the footer, and closes the file. Has no
+  // effect if the log is not open.
+  Status<void> Close() {
+    if (fd_ < 0)
+      return {};
+
+    auto status = Flush();
+    if (!status)
+      return Fail(status.error());
+
+    const std::uint64_t index_offset = written_;
+    buffer_.resize(index_.size() * Format::kIndexEntrySize +
+                   Format::kTrailerSize);
+    std::uint8_t* entry = buffer_.data();
+    for (const IndexEntry& index_entry : index_) {
+      Format::Store64(index_entry.record, entry);
+      Format::Store64(index_entry.timestamp, entry + 8);
+      Format::Store64(index_entry.offset, entry + 16);
+      entry += Format::kIndexEntrySize;
+    }
+
+    std::uint8_t* trailer = entry;
+    Format::Store64(index_offset, trailer);
+    Format::Store64(index_.size(), trailer + 8);
+    Format::Store64(record_count_, trailer + 16);
+    const std::size_t checksum_size = trailer + 24 - buffer_.data();
+    Format::Store64(Format::Checksum(buffer_.data(), checksum_size),
+                    trailer + 24);
+    Format::Store64(Format::kIndexMagic, trailer + 32);
+
+    status = Sync();
+    if (!status)
+      return Fail(status.error());
+
+    ::close(fd_);
+    Reset();
+    return {};
+  }
+
+  // Returns the number of records in the log, including buffered records.
+  std::uint64_t record_count() const { return record_count_; }
+
+ private:
+  using Format = RecordLogFormat;
+  using IndexEntry = Format::IndexEntry;
+
+  // Closes the file without writing the footer and returns |error|.
+  ErrorStatus Fail(ErrorStatus error) {
+    ::close(fd_);
+    Reset();
+    return error;
+  }
+
+  void Reset() {
+    fd_ = -1;
+    buffer_.clear();
+    written_ = 0;
+    record_count_ = 0;
+    index_.clear();
+  }
+
+  int fd_{-1};
+  std::size_t buffer_size_;
+  std::vector<std::uint8_t> buffer_;
+  std::uint64_t written_{0};
+  std::uint64_t record_count_{0};
+  std::vector<IndexEntry> index_;
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_RECORD_LOG_H_
@@ -0,0 +1,209 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_RESUMABLE_DESERIALIZER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_RESUMABLE_DESERIALIZER_H_
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <nop/base/encoding.h>
+#include <nop/base/value_scanner.h>
+#include <nop/status.h>
+#include <nop/utility/buffer_reader.h>
+
+namespace nop {
+
+// ResumableDeserializer decodes values from a stream of bytes that arrives in
+// arbitrary pieces, such as the data received on a non-blocking socket. Bytes
+// are consumed as they arrive and the position within the value is kept by a
+// ValueScanner, so no work is repeated when more data arrives. Once a complete
+// value has been received it is decoded from the internal buffer in one pass.
+//
+// Read() returns ErrorStatus::WouldBlock until a complete value is available.
+// Bytes that follow a complete value are kept for the next value, so several
+// values may be received in a single piece.
+//
+// Example of decoding messages in an event loop:
+//
+//   // When |fd| is readable.
+//   auto status = deserializer.ReadFrom(fd);
+//   if (!status && status.error() != ErrorStatus::WouldBlock)
+//     return status;
+//
+//   Message message;
+//   while (deserializer.Read(&message))
+//     Handle(message);
+//
+// Errors in the structure of the stream are sticky, since the position of the
+// next value cannot be determined after such an error. Errors while decoding a
+// complete value only affect that value.
+//
+// Decoded values that refer to the encoded bytes, such as Lazy<T> and RawValue,
+// refer to the internal buffer and are only valid until the next call to a
+// non-const method of the deserializer.
+class ResumableDeserializer {
+ public:
+  ResumableDeserializer() = default;
+
+  // Constructs a deserializer that fails with ErrorStatus::ReadLimitReached
+  // when a single value exceeds |max_value_size| bytes.
+  explicit ResumableDeserializer(std::size_t max_value_size)
+      : max_value_size_{max_value_size} {}
+
+  ResumableDeserializer(ResumableDeserializer&&) = default;
+  ResumableDeserializer& operator=(ResumableDeserializer&&) = default;
+
+  // Appends received bytes to the stream.
+  Status<void> Feed(const void* data, std::size_t size) {
+    if (error_ != ErrorStatus::None)
+      return error_;
+
+    const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+    buffer_.insert(buffer_.end(), bytes, bytes + size);
+    return Scan();
+  }
+
+  // Reads all of the bytes that are available from the non-blocking file
+  // descriptor |fd|, until the read would block. Bytes that follow a complete
+  // value are buffered for the following values, so the descriptor is always
+  // drained, as required by edge-triggered notifications. Returns success when
+  // a complete value is available and ErrorStatus::WouldBlock otherwise.
+  // Returns ErrorStatus::ReadLimitReached at the end of the stream once every
+  // complete value has been read.
+  Status<void> ReadFrom(int fd) {
+    enum : std::size_t { kChunkSize = 4096 };
+    if (error_ != ErrorStatus::None)
+      return error_;
+
+    while (true) {
+      const std::size_t offset = buffer_.size();
+      buffer_.resize(offset + kChunkSize);
+      const ssize_t ret = ::read(fd, &buffer_[offset], kChunkSize);
+      buffer_.resize(offset + (ret > 0 ? ret : 0));
+
+      if (ret > 0) {
+        auto status = Scan();
+        if (!status)
+          return status;
+      } else if (ret == 0) {
+        if (ready())
+          return {};
+        else
+          return ErrorStatus::ReadLimitReached;
+      } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        if (ready())
+          return {};
+        else
+          return ErrorStatus::WouldBlock;
+      } else if (errno != EINTR) {
+        return ErrorStatus::IOError;
+      }
+    }
+  }
+
+  // Returns true if a complete value is available to Read().
+  bool ready() const { return scanner_.done(); }
+
+  // Returns the number of received bytes that have not been decoded.
+  std::size_t buffered() const { return buffer_.size() - begin_; }
+
+  // Decodes the next complete value. Returns ErrorStatus::WouldBlock if the
+  // value has not been completely received. The encoded value is consumed
+  // even if it does not decode as type T.
+  template <typename T>
+  Status<void> Read(T* value) {
+    if (error_ != ErrorStatus::None)
+      return error_;
+    else if (!ready())
+      return ErrorStatus::WouldBlock;
+
+    BufferReader reader{buffer_.data() + begin_, scanned_ - begin_};
+    auto status = Encoding<T>::Read(value, &reader);
+
+    begin_ = scanned_;
+    scanner_.Reset();
+    Compact();
+
+    auto scan_status = Scan();
+    if (!status)
+      return status;
+    else
+      return scan_status;
+  }
+
+  // Discards all received bytes and clears any error.
+  void Reset() {
+    buffer_.clear();
+    begin_ = 0;
+    scanned_ = 0;
+    scanner_.Reset();
+    error_ = ErrorStatus::None;
+  }
+
+ private:
+  // Scans received bytes that have not been scanned until the end of the
+  // current value.
+  Status<void> Scan() {
+    if (ready() || scanned_ == buffer_.size())
+      return {};
+
+    auto status =
+        scanner_.Scan(buffer_.data() + scanned_, buffer_.size() - scanned_);
+    if (!status) {
+      error_ = status.error();
+      return error_;
+    }
+
+    scanned_ += status.get();
+    if (scanned_ - begin_ > max_value_size_) {
+      error_ = ErrorStatus::ReadLimitReached;
+      return error_;
+    }
+
+    return {};
+  }
+
+  // Drops decoded bytes from the front of the buffer once they make up at
+  // least half of it, keeping the cost of moving pending bytes amortized.
+  void Compact() {
+    if (begin_ == buffer_.size()) {
+      buffer_.clear();
+      scanned_ -= begin_;
+      begin_ = 0;
+    } else if (begin_ >= buffer_.size() / 2) {
+      buffer_.erase(buffer_.begin(), buffer_.begin() + begin_);
+      scanned_ -= begin_;
+      begin_ = 0;
+    }
+  }
+
+  std::vector<std::uint8_t> buffer_;
+  std::size_t begin_{0};
+  std::size_t scanned_{0};
+  std::size_t max_value_size_{std::numeric_limits<std::size_t>::max()};
+  ValueScanner scanner_;
+  ErrorStatus error_{ErrorStatus::None};
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_RESUMABLE_DESERIALIZER_H_
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_RESUMABLE_SERIALIZER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_RESUMABLE_SERIALIZER_H_
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <nop/base/encoding.h>
+#include <nop/status.h>
+#include <nop/utility/buffer_writer.h>
+
+namespace nop {
+
+// ResumableSerializer writes values to a transport that may accept only part
+// of the data at a time, such as a non-blocking socket. Each value is encoded
+// into a pending buffer, exactly as large as the encoding, that is drained by
+// WriteTo() or by a custom transport using data(), size(), and Consume(). When
+// the transport would block, the serializer returns ErrorStatus::WouldBlock
+// and resumes from the same byte on the next call.
+//
+// Example of writing messages in an event loop:
+//
+//   auto status = serializer.Write(message);
+//   if (!status)
+//     return status;
+//
+//   // Now and whenever |fd| becomes writable.
+//   status = serializer.WriteTo(fd);
+//   if (!status && status.error() != ErrorStatus::WouldBlock)
+//     return status;
+//
+// Values may be queued while earlier values are still pending; they are
+// written in order. Storage is only held while there is pending data, so idle
+// connections do not retain a buffer sized for their largest value.
+class ResumableSerializer {
+ public:
+  ResumableSerializer() = default;
+  ResumableSerializer(ResumableSerializer&&) = default;
+  ResumableSerializer& operator=(ResumableSerializer&&) = default;
+
+  // Encodes |value| and queues it behind any pending data.
+  template <typename T>
+  Status<void> Write(const T& value) {
+    Compact();
+    const std::size_t offset = buffer_.size();
+    buffer_.resize(offset + Encoding<T>::Size(value));
+
+    BufferWriter writer{buffer_.data() + offset, buffer_.size() - offset};
+    auto status = Encoding<T>::Write(value, &writer);
+    if (!status) {
+      buffer_.resize(offset);
+      return status;
+    }
+
+    buffer_.resize(offset + writer.size());
+    return {};
+  }
+
+  // Writes pending data to the non-blocking file descriptor |fd|. Returns
+  // ErrorStatus::WouldBlock if the descriptor cannot accept all of the data.
+  Status<void> WriteTo(int fd) {
+    while (!empty()) {
+      const ssize_t ret = ::write(fd, data(), size());
+      if (ret > 0)
+        Consume(ret);
+      else if (ret == 0)
+        return ErrorStatus::WriteLimitReached;
+      else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return ErrorStatus::WouldBlock;
+      else if (errno != EINTR)
+        return ErrorStatus::IOError;
+    }
+
+    return {};
+  }
+
+  // Returns the pending data that has not been accepted by the transport.
+  const std::uint8_t* data() const { return buffer_.data() + begin_; }
+  std::size_t size() const { return buffer_.size() - begin_; }
+  bool empty() const { return size() == 0; }
+
+  // Marks |size| bytes of pending data as accepted by the transport.
+  void Consume(std::size_t size) {
+    begin_ += size;
+    if (begin_ == buffer_.size()) {
+      std::vector<std::uint8_t>{}.swap(buffer_);
+      begin_ = 0;
+    }
+  }
+
+  // Discards all pending data.
+  void Reset() { Consume(size()); }
+
+ private:
+  // Drops accepted bytes from the front of the buffer once they make up at
+  // least half of it.
+  void Compact() {
+    if (begin_ != 0 && begin_ >= buffer_.size() / 2) {
+      buffer_.erase(buffer_.begin(), buffer_.begin() + begin_);
+      begin_ = 0;
+    }
+  }
+
+  std::vector<std::uint8_t> buffer_;
+  std::size_t begin_{0};
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_RESUMABLE_SERIALIZER_H_
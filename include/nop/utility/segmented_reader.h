@@ -0,0 +1,197 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_SEGMENTED_READER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_SEGMENTED_READER_H_
+
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <nop/base/encoding.h>
+#include <nop/base/utility.h>
+#include <nop/utility/buffer_pool.h>
+
+namespace nop {
+
+// SegmentedReader is a reader over a sequence of non-contiguous segments, such
+// as the iovecs filled by readv() or the segments of a SegmentedWriter, that
+// avoids copying the input into a staging buffer first. Encoded values may
+// straddle segment boundaries. Reads that fall within the current segment take
+// a fast path equivalent to BufferReader; only reads that cross a boundary
+// walk the chain.
+//
+// Unlike BufferReader, every read is bounds checked against the end of the
+// chain, since crossing a boundary already requires a check.
+//
+// Segments referred to by iovecs must outlive the reader. Segments taken from
+// a SegmentedWriter are owned by the reader.
+//
+// This reader does not expose a contiguous cursor, so values such as RawValue
+// and Lazy<T> copy their bytes out of the segments.
+class SegmentedReader {
+ public:
+  SegmentedReader() = default;
+  SegmentedReader(const iovec* vectors, std::size_t count) {
+    segments_.reserve(count);
+    for (std::size_t i = 0; i < count; i++)
+      Append(static_cast<const std::uint8_t*>(vectors[i].iov_base),
+             vectors[i].iov_len);
+    Start();
+  }
+  explicit SegmentedReader(const std::vector<iovec>& vectors)
+      : SegmentedReader{vectors.data(), vectors.size()} {}
+
+  // Takes ownership of segments returned by SegmentedWriter::take().
+  explicit SegmentedReader(std::vector<PooledBuffer> segments)
+      : owned_{std::move(segments)} {
+    segments_.reserve(owned_.size());
+    for (const PooledBuffer& segment : owned_)
+      Append(segment.data(), segment.size());
+    Start();
+  }
+
+  SegmentedReader(SegmentedReader&&) = default;
+  SegmentedReader& operator=(SegmentedReader&&) = default;
+
+  Status<void> Ensure(std::size_t size) {
+    if (remaining() < size)
+      return ErrorStatus::ReadLimitReached;
+    else
+      return {};
+  }
+
+  Status<void> Read(std::uint8_t* byte) {
+    if (cursor_ != limit_) {
+      *byte = *cursor_++;
+      return {};
+    }
+    return Read(byte, byte + 1);
+  }
+
+  template <typename T, typename Enable = EnableIfArithmetic<T>>
+  Status<void> Read(T* begin, T* end) {
+    std::uint8_t* bytes = reinterpret_cast<std::uint8_t*>(begin);
+    std::size_t length_bytes = (end - begin) * sizeof(T);
+
+    // Fast path for reads within the current segment.
+    if (static_cast<std::size_t>(limit_ - cursor_) >= length_bytes) {
+      std::memcpy(bytes, cursor_, length_bytes);
+      cursor_ += length_bytes;
+      return {};
+    }
+
+    auto status = Ensure(length_bytes);
+    if (!status)
+      return status;
+
+    while (length_bytes > 0) {
+      const std::size_t chunk = Available(length_bytes);
+      std::memcpy(bytes, cursor_, chunk);
+      cursor_ += chunk;
+      bytes += chunk;
+      length_bytes -= chunk;
+    }
+    return {};
+  }
+
+  Status<void> Skip(std::size_t padding_bytes) {
+    if (static_cast<std::size_t>(limit_ - cursor_) >= padding_bytes) {
+      cursor_ += padding_bytes;
+      return {};
+    }
+
+    auto status = Ensure(padding_bytes);
+    if (!status)
+      return status;
+
+    while (padding_bytes > 0) {
+      const std::size_t chunk = Available(padding_bytes);
+      cursor_ += chunk;
+      padding_bytes -= chunk;
+    }
+    return {};
+  }
+
+  // Returns the number of unread bytes in the whole chain.
+  std::size_t remaining() const {
+    return (limit_ - cursor_) + (size_ - segment_end_);
+  }
+  bool empty() const { return remaining() == 0; }
+
+  // Returns the total number of bytes in the chain.
+  std::size_t size() const { return size_; }
+
+  std::size_t segment_count() const { return segments_.size(); }
+
+ private:
+  struct Segment {
+    const std::uint8_t* data;
+    std::size_t size;
+  };
+
+  void Append(const std::uint8_t* data, std::size_t size) {
+    if (size > 0) {
+      segments_.push_back({data, size});
+      size_ += size;
+    }
+  }
+
+  void Start() {
+    index_ = 0;
+    segment_end_ = 0;
+    if (!segments_.empty())
+      Enter(0);
+  }
+
+  void Enter(std::size_t index) {
+    index_ = index;
+    cursor_ = segments_[index].data;
+    limit_ = cursor_ + segments_[index].size;
+    segment_end_ += segments_[index].size;
+  }
+
+  // Returns the number of bytes, up to |size|, available at the cursor,
+  // moving to the next segment if the current one is exhausted. The caller
+  // must have checked that enough bytes remain in the chain.
+  std::size_t Available(std::size_t size) {
+    if (cursor_ == limit_)
+      Enter(index_ + 1);
+    return std::min<std::size_t>(size, limit_ - cursor_);
+  }
+
+  std::vector<PooledBuffer> owned_;
+  std::vector<Segment> segments_;
+  std::size_t size_{0};
+
+  // Current segment, and the offset of its end within the whole chain.
+  std::size_t index_{0};
+  std::size_t segment_end_{0};
+  const std::uint8_t* cursor_{nullptr};
+  const std::uint8_t* limit_{nullptr};
+
+  SegmentedReader(const SegmentedReader&) = delete;
+  SegmentedReader& operator=(const SegmentedReader&) = delete;
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_SEGMENTED_READER_H_
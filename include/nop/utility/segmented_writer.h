@@ -0,0 +1,191 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_SEGMENTED_WRITER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_SEGMENTED_WRITER_H_
+
+#include <errno.h>
+#include <limits.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <nop/base/encoding.h>
+#include <nop/base/utility.h>
+#include <nop/utility/buffer_pool.h>
+
+namespace nop {
+
+// SegmentedWriter is a writer that appends into a chain of fixed-size segments
+// from BufferPool instead of one contiguous buffer. Appending never moves data
+// that was already written, so very large outputs are built without large
+// reallocations or copies. Encoded values may straddle segments.
+//
+// The result is available as an iovec list for writev(), may be written to a
+// file descriptor directly with WriteTo(), or may be handed to a
+// SegmentedReader with take().
+//
+// Example:
+//
+//   nop::Serializer<nop::SegmentedWriter> serializer;
+//   for (const auto& record : records)
+//     serializer.Write(record);
+//   auto status = serializer.writer().WriteTo(fd);
+//
+class SegmentedWriter {
+ public:
+  enum : std::size_t { kDefaultSegmentSize = 64 * 1024 };
+
+  explicit SegmentedWriter(std::size_t segment_size = kDefaultSegmentSize)
+      : segment_size_{segment_size} {}
+  SegmentedWriter(SegmentedWriter&&) = default;
+  SegmentedWriter& operator=(SegmentedWriter&&) = default;
+
+  // Segments are added as data is written, so there is no limit to check.
+  Status<void> Prepare(std::size_t /*size*/) { return {}; }
+
+  Status<void> Write(std::uint8_t byte) { return Write(&byte, &byte + 1); }
+
+  template <typename T, typename Enable = EnableIfArithmetic<T>>
+  Status<void> Write(const T* begin, const T* end) {
+    const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(begin);
+    std::size_t length_bytes = (end - begin) * sizeof(T);
+    while (length_bytes > 0) {
+      const std::size_t chunk = Reserve(length_bytes);
+      std::memcpy(Cursor(), bytes, chunk);
+      Advance(chunk);
+      bytes += chunk;
+      length_bytes -= chunk;
+    }
+    return {};
+  }
+
+  Status<void> Skip(std::size_t padding_bytes,
+                    std::uint8_t padding_value = 0x00) {
+    while (padding_bytes > 0) {
+      const std::size_t chunk = Reserve(padding_bytes);
+      std::memset(Cursor(), padding_value, chunk);
+      Advance(chunk);
+      padding_bytes -= chunk;
+    }
+    return {};
+  }
+
+  // Returns the total number of bytes written.
+  std::size_t size() const { return size_; }
+
+  std::size_t segment_count() const { return segments_.size(); }
+  std::size_t segment_size() const { return segment_size_; }
+
+  // Returns the written data as a list of iovecs, one per segment, suitable
+  // for writev(). The iovecs are valid until the next non-const call.
+  std::vector<iovec> iovecs() const {
+    std::vector<iovec> vectors;
+    vectors.reserve(segments_.size());
+    for (const PooledBuffer& segment : segments_) {
+      vectors.push_back(
+          {const_cast<std::uint8_t*>(segment.data()), segment.size()});
+    }
+    return vectors;
+  }
+
+  // Writes all of the data to |fd| using writev(), retrying partial writes and
+  // interrupted calls. The writer is left unchanged.
+  Status<void> WriteTo(int fd) const {
+    std::vector<iovec> vectors = iovecs();
+    iovec* vector = vectors.data();
+    std::size_t count = vectors.size();
+    while (count > 0) {
+      const int batch = static_cast<int>(std::min<std::size_t>(count, IOV_MAX));
+      const ssize_t ret = ::writev(fd, vector, batch);
+      if (ret < 0 && errno == EINTR)
+        continue;  // Interrupted by signal.
+      else if (ret < 0)
+        return ErrorStatus::IOError;
+      else if (ret == 0)
+        return ErrorStatus::WriteLimitReached;
+
+      // Skip the iovecs that were completely written and adjust the first
+      // partially written iovec.
+      std::size_t written = ret;
+      while (count > 0 && written >= vector->iov_len) {
+        written -= vector->iov_len;
+        vector++;
+        count--;
+      }
+      if (count > 0) {
+        vector->iov_base =
+            static_cast<std::uint8_t*>(vector->iov_base) + written;
+        vector->iov_len -= written;
+      }
+    }
+    return {};
+  }
+
+  // Returns the segments holding the written data and leaves the writer
+  // empty. The size of each segment is the number of bytes written to it.
+  std::vector<PooledBuffer> take() {
+    std::vector<PooledBuffer> segments;
+    segments.swap(segments_);
+    size_ = 0;
+    return segments;
+  }
+
+  // Discards the written data, returning the segments to the pool.
+  void clear() {
+    segments_.clear();
+    size_ = 0;
+  }
+
+ private:
+  // Returns the number of bytes, up to |size|, that may be written at Cursor(),
+  // starting a new segment if the current one is full.
+  std::size_t Reserve(std::size_t size) {
+    if (segments_.empty() ||
+        segments_.back().size() == segments_.back().capacity()) {
+      segments_.push_back(BufferPool::Acquire(segment_size_));
+    }
+    const PooledBuffer& segment = segments_.back();
+    return std::min(size, segment.capacity() - segment.size());
+  }
+
+  std::uint8_t* Cursor() {
+    PooledBuffer& segment = segments_.back();
+    return segment.data() + segment.size();
+  }
+
+  void Advance(std::size_t size) {
+    PooledBuffer& segment = segments_.back();
+    segment.set_size(segment.size() + size);
+    size_ += size;
+  }
+
+  std::size_t segment_size_;
+  std::vector<PooledBuffer> segments_;
+  std::size_t size_{0};
+
+  SegmentedWriter(const SegmentedWriter&) = delete;
+  SegmentedWriter& operator=(const SegmentedWriter&) = delete;
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_SEGMENTED_WRITER_H_
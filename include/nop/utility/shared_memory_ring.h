@@ -0,0 +1,364 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_SHARED_MEMORY_RING_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_SHARED_MEMORY_RING_H_
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#include <nop/status.h>
+
+namespace nop {
+
+class SharedMemoryRingReader;
+class SharedMemoryRingWriter;
+
+// SharedMemoryRing is a single-producer/single-consumer message ring in a
+// memfd shared between two processes on the same host. Messages written with
+// SharedMemoryRingWriter are serialized directly into the ring and read back
+// by SharedMemoryRingReader directly from the ring, without intermediate
+// buffers or system calls on the data path. The producer and consumer
+// exchange positions through lock-free cursors and only enter the kernel, via
+// futex, to sleep when the ring is empty or full and to wake a sleeping peer.
+//
+// One process creates the ring and shares it with the other, either by
+// forking after Create() or by sending fd() over a Unix domain socket (see
+// UnixSocketWriter) and calling Map() in the receiving process. Each side then
+// constructs a writer or a reader over its SharedMemoryRing. There must be at
+// most one writer and one reader per ring at any time.
+//
+// Messages are stored contiguously, so a single message may be at most
+// max_message_size() bytes, which is slightly less than half the capacity.
+//
+// Example:
+//
+//   auto ring = nop::SharedMemoryRing::Create(1 << 20) || nop::Die(std::cerr);
+//   if (fork() == 0) {
+//     nop::Deserializer<nop::SharedMemoryRingReader> deserializer{&ring.get()};
+//     Request request;
+//     while (deserializer.reader().Receive() && deserializer.Read(&request))
+//       Handle(request);
+//   } else {
+//     nop::Serializer<nop::SharedMemoryRingWriter> serializer{&ring.get()};
+//     serializer.Write(request) || nop::Die(std::cerr);
+//     serializer.writer().Commit() || nop::Die(std::cerr);
+//     ring.get().Shutdown();
+//   }
+//
+class SharedMemoryRing {
+ public:
+  enum : std::size_t {
+    kMinCapacity = 4096,
+    kMaxCapacity = std::size_t{1} << 30,
+  };
+
+  SharedMemoryRing() = default;
+  SharedMemoryRing(SharedMemoryRing&& other) noexcept {
+    *this = std::move(other);
+  }
+  ~SharedMemoryRing() { Close(); }
+
+  SharedMemoryRing& operator=(SharedMemoryRing&& other) noexcept {
+    if (this != &other) {
+      Close();
+      std::swap(fd_, other.fd_);
+      std::swap(mapping_, other.mapping_);
+      std::swap(header_, other.header_);
+      std::swap(data_, other.data_);
+      std::swap(capacity_, other.capacity_);
+    }
+    return *this;
+  }
+
+  // Creates a ring with room for at least |capacity| bytes of messages. The
+  // capacity is rounded up to a power of two of at least kMinCapacity.
+  // Returns ErrorStatus::SystemError if the capacity exceeds kMaxCapacity or
+  // the shared memory could not be allocated.
+  static Status<SharedMemoryRing> Create(std::size_t capacity) {
+    if (capacity > kMaxCapacity)
+      return ErrorStatus::SystemError;
+
+    std::size_t size = kMinCapacity;
+    while (size < capacity)
+      size <<= 1;
+
+    const int fd = memfd_create("nop-ring", MFD_CLOEXEC);
+    if (fd < 0)
+      return ErrorStatus::SystemError;
+
+    SharedMemoryRing ring;
+    ring.fd_ = fd;
+    if (ftruncate(fd, kHeaderSize + size) < 0)
+      return ErrorStatus::SystemError;
+
+    auto status = ring.MapFile(kHeaderSize + size);
+    if (!status)
+      return status.error();
+
+    // The file is zero filled, so only the constant fields need to be set.
+    ring.header_ = new (ring.mapping_) Header;
+    ring.header_->magic = kMagic;
+    ring.header_->capacity = size;
+    ring.capacity_ = size;
+    return {std::move(ring)};
+  }
+
+  // Maps a ring created by another process. Takes ownership of |fd|, which is
+  // closed when the ring is destroyed, including on failure. Returns
+  // ErrorStatus::ProtocolError if the file does not contain a valid ring.
+  static Status<SharedMemoryRing> Map(int fd) {
+    SharedMemoryRing ring;
+    ring.fd_ = fd;
+
+    struct stat file_status;
+    if (fstat(fd, &file_status) < 0)
+      return ErrorStatus::SystemError;
+
+    const std::size_t size = file_status.st_size;
+    if (size < kHeaderSize + kMinCapacity ||
+        size > kHeaderSize + kMaxCapacity)
+      return ErrorStatus::ProtocolError;
+
+    auto status = ring.MapFile(size);
+    if (!status)
+      return status.error();
+
+    ring.header_ = static_cast<Header*>(ring.mapping_);
+    const std::uint64_t capacity = ring.header_->capacity;
+    if (ring.header_->magic != kMagic || capacity != size - kHeaderSize ||
+        (capacity & (capacity - 1)) != 0)
+      return ErrorStatus::ProtocolError;
+
+    ring.capacity_ = capacity;
+    return {std::move(ring)};
+  }
+
+  // Marks the ring as shut down and wakes both sides. The reader receives the
+  // messages already committed and then ErrorStatus::ReadLimitReached; the
+  // writer fails to commit or wait for space with ErrorStatus::IOError. Either
+  // side may shut down the ring.
+  void Shutdown() {
+    header_->shutdown.store(1, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    header_->data_futex.fetch_add(1, std::memory_order_release);
+    header_->space_futex.fetch_add(1, std::memory_order_release);
+    FutexWake(&header_->data_futex);
+    FutexWake(&header_->space_futex);
+  }
+
+  bool is_shutdown() const {
+    return header_->shutdown.load(std::memory_order_acquire) != 0;
+  }
+
+  bool is_valid() const { return header_ != nullptr; }
+  explicit operator bool() const { return is_valid(); }
+
+  int fd() const { return fd_; }
+  std::size_t capacity() const { return capacity_; }
+  std::size_t max_message_size() const {
+    return capacity_ / 2 - kRecordHeaderSize;
+  }
+
+  void Close() {
+    if (mapping_)
+      munmap(mapping_, kHeaderSize + capacity_);
+    if (fd_ >= 0)
+      close(fd_);
+
+    fd_ = -1;
+    mapping_ = nullptr;
+    header_ = nullptr;
+    data_ = nullptr;
+    capacity_ = 0;
+  }
+
+ private:
+  friend class SharedMemoryRingReader;
+  friend class SharedMemoryRingWriter;
+
+  enum : std::size_t {
+    kCacheLineSize = 64,
+    kHeaderSize = 4096,
+    kRecordHeaderSize = 8,
+    kSpinCount = 1024,
+  };
+
+  enum : std::uint32_t {
+    kMagic = 0x524f4e4e,  // "NNOR"
+    // Length of the record that pads the end of the ring when a message does
+    // not fit before the end. The message follows at the start of the ring.
+    kWrapMarker = 0xffffffff,
+  };
+
+  static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+                "Shared memory cursors must be lock-free.");
+
+  // Control block at the start of the shared mapping. The producer and
+  // consumer cursors live on separate cache lines to avoid false sharing. The
+  // data region is a sequence of records, each an eight byte header holding
+  // the message length followed by the message padded to eight bytes.
+  struct Header {
+    std::uint32_t magic;
+    std::uint64_t capacity;
+
+    // Written by the producer: total bytes committed.
+    alignas(kCacheLineSize) std::atomic<std::uint64_t> head;
+    std::atomic<std::uint32_t> data_futex;
+    std::atomic<std::uint32_t> consumer_waiting;
+
+    // Written by the consumer: total bytes released.
+    alignas(kCacheLineSize) std::atomic<std::uint64_t> tail;
+    std::atomic<std::uint32_t> space_futex;
+    std::atomic<std::uint32_t> producer_waiting;
+
+    alignas(kCacheLineSize) std::atomic<std::uint32_t> shutdown;
+  };
+  static_assert(sizeof(Header) <= kHeaderSize,
+                "Ring header does not fit in the reserved space.");
+
+  static std::size_t RecordSize(std::size_t message_size) {
+    return kRecordHeaderSize + ((message_size + 7) & ~std::size_t{7});
+  }
+
+  Status<void> MapFile(std::size_t size) {
+    void* mapping =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapping == MAP_FAILED)
+      return ErrorStatus::SystemError;
+
+    mapping_ = mapping;
+    data_ = static_cast<std::uint8_t*>(mapping) + kHeaderSize;
+    return {};
+  }
+
+  // Waits until the head differs from |tail| and returns the head. Spins
+  // briefly before sleeping on the futex.
+  Status<std::uint64_t> WaitForData(std::uint64_t tail, bool blocking) {
+    for (std::size_t i = 0;; i++) {
+      const bool shutdown = is_shutdown();
+      const std::uint64_t head =
+          header_->head.load(std::memory_order_acquire);
+      if (head != tail)
+        return head;
+      else if (shutdown)
+        return ErrorStatus::ReadLimitReached;
+      else if (!blocking)
+        return ErrorStatus::WouldBlock;
+      else if (i < kSpinCount)
+        continue;
+
+      const std::uint32_t sequence =
+          header_->data_futex.load(std::memory_order_acquire);
+      header_->consumer_waiting.store(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (header_->head.load(std::memory_order_relaxed) == tail &&
+          !header_->shutdown.load(std::memory_order_relaxed))
+        FutexWait(&header_->data_futex, sequence);
+      header_->consumer_waiting.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  // Waits until at least |size| bytes are free after |head| and returns the
+  // tail.
+  Status<std::uint64_t> WaitForSpace(std::uint64_t head, std::size_t size,
+                                     bool blocking) {
+    for (std::size_t i = 0;; i++) {
+      if (is_shutdown())
+        return ErrorStatus::IOError;
+
+      const std::uint64_t tail =
+          header_->tail.load(std::memory_order_acquire);
+      if (capacity_ - (head - tail) >= size)
+        return tail;
+      else if (!blocking)
+        return ErrorStatus::WouldBlock;
+      else if (i < kSpinCount)
+        continue;
+
+      const std::uint32_t sequence =
+          header_->space_futex.load(std::memory_order_acquire);
+      header_->producer_waiting.store(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (header_->tail.load(std::memory_order_relaxed) == tail &&
+          !header_->shutdown.load(std::memory_order_relaxed))
+        FutexWait(&header_->space_futex, sequence);
+      header_->producer_waiting.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  // Publishes committed records to the consumer.
+  void PublishHead(std::uint64_t head) {
+    header_->head.store(head, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header_->consumer_waiting.load(std::memory_order_relaxed)) {
+      header_->data_futex.fetch_add(1, std::memory_order_release);
+      FutexWake(&header_->data_futex);
+    }
+  }
+
+  // Returns released records to the producer.
+  void PublishTail(std::uint64_t tail) {
+    header_->tail.store(tail, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header_->producer_waiting.load(std::memory_order_relaxed)) {
+      header_->space_futex.fetch_add(1, std::memory_order_release);
+      FutexWake(&header_->space_futex);
+    }
+  }
+
+  // The futex words are shared between processes, so the private futex
+  // operations may not be used.
+  static void FutexWait(std::atomic<std::uint32_t>* word,
+                        std::uint32_t value) {
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(word), FUTEX_WAIT,
+            value, nullptr, nullptr, 0);
+  }
+
+  static void FutexWake(std::atomic<std::uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(word), FUTEX_WAKE,
+            1, nullptr, nullptr, 0);
+  }
+
+  std::uint64_t head() const {
+    return header_->head.load(std::memory_order_relaxed);
+  }
+  std::uint64_t tail() const {
+    return header_->tail.load(std::memory_order_relaxed);
+  }
+
+  int fd_{-1};
+  void* mapping_{nullptr};
+  Header* header_{nullptr};
+  std::uint8_t* data_{nullptr};
+  std::size_t capacity_{0};
+
+  SharedMemoryRing(const SharedMemoryRing&) = delete;
+  void operator=(const SharedMemoryRing&) = delete;
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_SHARED_MEMORY_RING_H_
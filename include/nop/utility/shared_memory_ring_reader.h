@@ -0,0 +1,177 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_SHARED_MEMORY_RING_READER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_SHARED_MEMORY_RING_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#include <nop/base/encoding.h>
+#include <nop/base/utility.h>
+#include <nop/status.h>
+#include <nop/utility/shared_memory_ring.h>
+
+namespace nop {
+
+// SharedMemoryRingReader is a reader that decodes messages committed by
+// SharedMemoryRingWriter directly from a SharedMemoryRing.
+//
+// Receive() waits for the next message and releases the space of the previous
+// one back to the writer. Values are then read from the message in place.
+// Reads past the end of the message fail with ErrorStatus::ReadLimitReached.
+// Once the ring is shut down and every committed message has been received,
+// Receive() fails with ErrorStatus::ReadLimitReached. A non-blocking reader
+// fails with ErrorStatus::WouldBlock instead of waiting when the ring is
+// empty.
+//
+// The message bytes are available through data() and size() until the next
+// call to Receive() or Release(), for callers that want to refer to them
+// without copying, for example through a BufferReader. Values decoded through
+// this reader never refer to the ring.
+//
+// The ring must outlive the reader.
+//
+class SharedMemoryRingReader {
+ public:
+  SharedMemoryRingReader() = default;
+  explicit SharedMemoryRingReader(SharedMemoryRing* ring, bool blocking = true)
+      : ring_{ring},
+        blocking_{blocking},
+        tail_{ring->tail()},
+        released_tail_{tail_},
+        cached_head_{tail_} {}
+  SharedMemoryRingReader(SharedMemoryRingReader&&) = default;
+  SharedMemoryRingReader& operator=(SharedMemoryRingReader&&) = default;
+
+  // Waits for the next message, releasing the current message first.
+  Status<void> Receive() {
+    Release();
+
+    const std::size_t capacity = ring_->capacity();
+    for (;;) {
+      // Only go to the shared head once the records known to be committed
+      // have been consumed.
+      if (cached_head_ == tail_) {
+        auto status = ring_->WaitForData(tail_, blocking_);
+        if (!status)
+          return status.error();
+        cached_head_ = status.get();
+      }
+
+      const std::size_t offset = tail_ & (capacity - 1);
+      const std::size_t contiguous = capacity - offset;
+      const std::uint8_t* record = ring_->data_ + offset;
+      std::uint32_t length;
+      std::memcpy(&length, record, sizeof(length));
+
+      if (length == SharedMemoryRing::kWrapMarker) {
+        if (cached_head_ - tail_ < contiguous)
+          return ErrorStatus::ProtocolError;
+        tail_ += contiguous;
+        continue;
+      }
+
+      // Validate the record against the ring, since the writer may be in
+      // another, less trusted process.
+      const std::size_t record_size = SharedMemoryRing::RecordSize(length);
+      if (length > ring_->max_message_size() || record_size > contiguous ||
+          record_size > cached_head_ - tail_)
+        return ErrorStatus::ProtocolError;
+
+      begin_ = record + SharedMemoryRing::kRecordHeaderSize;
+      cursor_ = begin_;
+      end_ = begin_ + length;
+      next_tail_ = tail_ + record_size;
+      return {};
+    }
+  }
+
+  // Returns the space of the current message, and any wrap padding before it,
+  // to the writer. Called implicitly by Receive().
+  void Release() {
+    if (begin_) {
+      tail_ = next_tail_;
+      begin_ = cursor_ = end_ = nullptr;
+    }
+    if (tail_ != released_tail_) {
+      released_tail_ = tail_;
+      ring_->PublishTail(tail_);
+    }
+  }
+
+  Status<void> Ensure(std::size_t size) {
+    if (remaining() < size)
+      return ErrorStatus::ReadLimitReached;
+    else
+      return {};
+  }
+
+  Status<void> Read(std::uint8_t* byte) {
+    if (cursor_ == end_)
+      return ErrorStatus::ReadLimitReached;
+
+    *byte = *cursor_++;
+    return {};
+  }
+
+  template <typename T, typename Enable = EnableIfArithmetic<T>>
+  Status<void> Read(T* begin, T* end) {
+    const std::size_t length_bytes = std::distance(begin, end) * sizeof(T);
+    if (remaining() < length_bytes)
+      return ErrorStatus::ReadLimitReached;
+
+    std::memcpy(begin, cursor_, length_bytes);
+    cursor_ += length_bytes;
+    return {};
+  }
+
+  Status<void> Skip(std::size_t padding_bytes) {
+    if (remaining() < padding_bytes)
+      return ErrorStatus::ReadLimitReached;
+
+    cursor_ += padding_bytes;
+    return {};
+  }
+
+  const std::uint8_t* data() const { return begin_; }
+  std::size_t size() const { return end_ - begin_; }
+  std::size_t remaining() const { return end_ - cursor_; }
+  bool empty() const { return cursor_ == end_; }
+
+  SharedMemoryRing* ring() const { return ring_; }
+
+ private:
+  SharedMemoryRing* ring_{nullptr};
+  bool blocking_{true};
+  std::uint64_t tail_{0};
+  std::uint64_t released_tail_{0};
+  std::uint64_t cached_head_{0};
+  std::uint64_t next_tail_{0};
+
+  const std::uint8_t* begin_{nullptr};
+  const std::uint8_t* cursor_{nullptr};
+  const std::uint8_t* end_{nullptr};
+
+  SharedMemoryRingReader(const SharedMemoryRingReader&) = delete;
+  void operator=(const SharedMemoryRingReader&) = delete;
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_SHARED_MEMORY_RING_READER_H_
@@ -0,0 +1,189 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_SHARED_MEMORY_RING_WRITER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_SHARED_MEMORY_RING_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#include <nop/base/encoding.h>
+#include <nop/base/utility.h>
+#include <nop/status.h>
+#include <nop/utility/shared_memory_ring.h>
+
+namespace nop {
+
+// SharedMemoryRingWriter is a writer that serializes messages directly into a
+// SharedMemoryRing. Values written to the writer form the current message,
+// which is stored in a slot reserved in the ring and becomes visible to the
+// reader when Commit() is called. Serializer::Write() prepares the exact size
+// of each value, so a message made of one value is reserved once and written
+// in place.
+//
+// When the ring is full a blocking writer waits for the reader to release
+// space, while a non-blocking writer fails with ErrorStatus::WouldBlock. The
+// partial message is kept in either case, so the caller may retry the write
+// later or call clear() to discard it. Messages larger than
+// SharedMemoryRing::max_message_size() fail with
+// ErrorStatus::WriteLimitReached.
+//
+// The ring must outlive the writer.
+//
+class SharedMemoryRingWriter {
+ public:
+  SharedMemoryRingWriter() = default;
+  explicit SharedMemoryRingWriter(SharedMemoryRing* ring, bool blocking = true)
+      : ring_{ring},
+        blocking_{blocking},
+        head_{ring->head()},
+        cached_tail_{ring->tail()} {}
+  SharedMemoryRingWriter(SharedMemoryRingWriter&&) = default;
+  SharedMemoryRingWriter& operator=(SharedMemoryRingWriter&&) = default;
+
+  Status<void> Prepare(std::size_t size) { return Reserve(size); }
+
+  Status<void> Write(std::uint8_t byte) {
+    auto status = Reserve(1);
+    if (!status)
+      return status;
+
+    slot_[size_++] = byte;
+    return {};
+  }
+
+  template <typename T, typename Enable = EnableIfArithmetic<T>>
+  Status<void> Write(const T* begin, const T* end) {
+    const std::size_t length_bytes = std::distance(begin, end) * sizeof(T);
+    auto status = Reserve(length_bytes);
+    if (!status)
+      return status;
+
+    std::memcpy(slot_ + size_, begin, length_bytes);
+    size_ += length_bytes;
+    return {};
+  }
+
+  Status<void> Skip(std::size_t padding_bytes,
+                    std::uint8_t padding_value = 0x00) {
+    auto status = Reserve(padding_bytes);
+    if (!status)
+      return status;
+
+    std::memset(slot_ + size_, padding_value, padding_bytes);
+    size_ += padding_bytes;
+    return {};
+  }
+
+  // Makes the current message visible to the reader and wakes the reader if
+  // it is waiting for data. Fails with ErrorStatus::IOError once the ring is
+  // shut down.
+  Status<void> Commit() {
+    if (ring_->is_shutdown())
+      return ErrorStatus::IOError;
+
+    auto status = Reserve(0);
+    if (!status)
+      return status;
+
+    const std::size_t offset = head_ & (ring_->capacity() - 1);
+    std::uint64_t head = head_;
+    if (wrapped_) {
+      StoreLength(ring_->data_ + offset, SharedMemoryRing::kWrapMarker);
+      head += ring_->capacity() - offset;
+    }
+
+    StoreLength(slot_ - SharedMemoryRing::kRecordHeaderSize,
+                static_cast<std::uint32_t>(size_));
+    head_ = head + SharedMemoryRing::RecordSize(size_);
+    ring_->PublishHead(head_);
+
+    clear();
+    return {};
+  }
+
+  // Discards the current message.
+  void clear() {
+    slot_ = nullptr;
+    reserved_ = 0;
+    size_ = 0;
+    wrapped_ = false;
+  }
+
+  // Returns the size of the current message.
+  std::size_t size() const { return size_; }
+
+  SharedMemoryRing* ring() const { return ring_; }
+
+ private:
+  // Ensures that the slot for the current message has room for |size| more
+  // bytes, moving the message to the start of the ring if it no longer fits
+  // before the end.
+  Status<void> Reserve(std::size_t size) {
+    if (slot_ && size_ + size <= reserved_)
+      return {};
+    else if (size_ + size > ring_->max_message_size())
+      return ErrorStatus::WriteLimitReached;
+
+    const std::size_t capacity = ring_->capacity();
+    const std::size_t offset = head_ & (capacity - 1);
+    const std::size_t contiguous = capacity - offset;
+    const std::size_t record = SharedMemoryRing::RecordSize(size_ + size);
+    const bool wrapped = record > contiguous;
+    const std::size_t required = wrapped ? contiguous + record : record;
+
+    // Only go to the shared tail when the cached tail shows too little room.
+    if (capacity - (head_ - cached_tail_) < required) {
+      auto status = ring_->WaitForSpace(head_, required, blocking_);
+      if (!status)
+        return status.error();
+      cached_tail_ = status.get();
+    }
+
+    std::uint8_t* slot = ring_->data_ + (wrapped ? 0 : offset) +
+                         SharedMemoryRing::kRecordHeaderSize;
+    if (slot_ && slot != slot_ && size_ > 0)
+      std::memcpy(slot, slot_, size_);
+
+    slot_ = slot;
+    reserved_ = record - SharedMemoryRing::kRecordHeaderSize;
+    wrapped_ = wrapped;
+    return {};
+  }
+
+  static void StoreLength(std::uint8_t* record, std::uint32_t length) {
+    std::memcpy(record, &length, sizeof(length));
+  }
+
+  SharedMemoryRing* ring_{nullptr};
+  bool blocking_{true};
+  std::uint64_t head_{0};
+  std::uint64_t cached_tail_{0};
+
+  std::uint8_t* slot_{nullptr};
+  std::size_t reserved_{0};
+  std::size_t size_{0};
+  bool wrapped_{false};
+
+  SharedMemoryRingWriter(const SharedMemoryRingWriter&) = delete;
+  void operator=(const SharedMemoryRingWriter&) = delete;
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_SHARED_MEMORY_RING_WRITER_H_
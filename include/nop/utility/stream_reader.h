@@ -17,8 +17,12 @@
 #ifndef LIBNOP_INLCUDE_NOP_UTILITY_STREAM_READER_H_
 #define LIBNOP_INLCUDE_NOP_UTILITY_STREAM_READER_H_
 
+#include <algorithm>
 #include <cstdint>
+#include <ios>
 #include <istream>
+#include <iterator>
+#include <utility>
 
 #include <nop/status.h>
 
@@ -28,6 +32,11 @@ namespace nop {
 // Reader template type that wraps STL input streams.
 //
 // Implements the basic reader interface on top of an STL input stream type.
+// Data is read directly from the stream buffer with sbumpc()/sgetn(), which
+// bypasses the per-call sentry and state checks of the formatted stream layer.
+// Skip() seeks the stream buffer when it is seekable and otherwise reads and
+// discards the bytes in batches. A short read sets eofbit and failbit on the
+// stream and returns ErrorStatus::StreamError.
 //
 
 template <typename IStream>
@@ -41,10 +50,13 @@ class StreamReader {
   Status<void> Ensure(std::size_t /*size*/) { return {}; }
 
   Status<void> Read(std::uint8_t* byte) {
-    using CharType = typename IStream::char_type;
-    stream_.read(reinterpret_cast<CharType*>(byte), sizeof(std::uint8_t));
+    using Traits = typename IStream::traits_type;
+    const auto result = stream_.rdbuf()->sbumpc();
+    if (Traits::eq_int_type(result, Traits::eof()))
+      return Fail();
 
-    return ReturnStatus();
+    *byte = static_cast<std::uint8_t>(Traits::to_char_type(result));
+    return {};
   }
 
   Status<void> Read(void* begin, void* end) {
@@ -52,15 +64,33 @@ class StreamReader {
     CharType* begin_char = static_cast<CharType*>(begin);
     CharType* end_char = static_cast<CharType*>(end);
 
-    const std::size_t length_bytes = std::distance(begin_char, end_char);
-    stream_.read(begin_char, length_bytes);
-
-    return ReturnStatus();
+    const std::streamsize length = std::distance(begin_char, end_char);
+    if (stream_.rdbuf()->sgetn(begin_char, length) != length)
+      return Fail();
+    else
+      return {};
   }
 
   Status<void> Skip(std::size_t padding_bytes) {
-    stream_.seekg(padding_bytes, std::ios_base::cur);
-    return ReturnStatus();
+    using CharType = typename IStream::char_type;
+    using PosType = typename IStream::pos_type;
+    const auto position = stream_.rdbuf()->pubseekoff(
+        padding_bytes, std::ios_base::cur, std::ios_base::in);
+    if (position != PosType(-1))
+      return {};
+
+    // The stream is not seekable, or the offset is out of range.
+    enum : std::size_t { kChunkSize = 256 };
+    CharType discard[kChunkSize];
+    while (padding_bytes > 0) {
+      const std::streamsize length =
+          std::min<std::size_t>(padding_bytes, kChunkSize);
+      if (stream_.rdbuf()->sgetn(discard, length) != length)
+        return Fail();
+      padding_bytes -= length;
+    }
+
+    return {};
   }
 
   const IStream& stream() const { return stream_; }
@@ -68,11 +98,9 @@ class StreamReader {
   IStream&& take() { return std::move(stream_); }
 
  private:
-  Status<void> ReturnStatus() {
-    if (stream_.bad() || stream_.eof())
-      return ErrorStatus::StreamError;
-    else
-      return {};
+  Status<void> Fail() {
+    stream_.setstate(std::ios_base::eofbit | std::ios_base::failbit);
+    return ErrorStatus::StreamError;
   }
 
   IStream stream_;
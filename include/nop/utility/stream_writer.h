@@ -17,8 +17,12 @@
 #ifndef LIBNOP_INLCUDE_NOP_UTILITY_STREAM_WRITER_H_
 #define LIBNOP_INLCUDE_NOP_UTILITY_STREAM_WRITER_H_
 
+#include <algorithm>
 #include <cstdint>
+#include <ios>
+#include <iterator>
 #include <ostream>
+#include <utility>
 
 #include <nop/status.h>
 
@@ -28,6 +32,10 @@ namespace nop {
 // Writer template type that wraps STL output streams.
 //
 // Implements the basic writer interface on top of an STL output stream type.
+// Data is written directly to the stream buffer with sputc()/sputn(), which
+// bypasses the per-call sentry and state checks of the formatted stream layer.
+// Padding is written in batches. A short write sets badbit on the stream and
+// returns ErrorStatus::StreamError.
 //
 
 template <typename OStream>
@@ -41,8 +49,13 @@ class StreamWriter {
   Status<void> Prepare(std::size_t /*size*/) { return {}; }
 
   Status<void> Write(std::uint8_t byte) {
-    stream_.put(static_cast<typename OStream::char_type>(byte));
-    return ReturnStatus();
+    using Traits = typename OStream::traits_type;
+    const auto result =
+        stream_.rdbuf()->sputc(static_cast<typename OStream::char_type>(byte));
+    if (Traits::eq_int_type(result, Traits::eof()))
+      return Fail();
+    else
+      return {};
   }
 
   Status<void> Write(const void* begin, const void* end) {
@@ -50,19 +63,27 @@ class StreamWriter {
     const CharType* begin_char = static_cast<const CharType*>(begin);
     const CharType* end_char = static_cast<const CharType*>(end);
 
-    const std::size_t length_bytes = std::distance(begin_char, end_char);
-    stream_.write(begin_char, length_bytes);
-
-    return ReturnStatus();
+    const std::streamsize length = std::distance(begin_char, end_char);
+    if (stream_.rdbuf()->sputn(begin_char, length) != length)
+      return Fail();
+    else
+      return {};
   }
 
   Status<void> Skip(std::size_t padding_bytes,
                     std::uint8_t padding_value = 0x00) {
-    for (std::size_t i = 0; i < padding_bytes; i++) {
-      stream_.put(padding_value);
-      auto status = ReturnStatus();
-      if (!status)
-        return status;
+    using CharType = typename OStream::char_type;
+    enum : std::size_t { kChunkSize = 256 };
+    CharType padding[kChunkSize];
+    std::fill_n(padding, std::min<std::size_t>(padding_bytes, kChunkSize),
+                static_cast<CharType>(padding_value));
+
+    while (padding_bytes > 0) {
+      const std::streamsize length =
+          std::min<std::size_t>(padding_bytes, kChunkSize);
+      if (stream_.rdbuf()->sputn(padding, length) != length)
+        return Fail();
+      padding_bytes -= length;
     }
 
     return {};
@@ -73,11 +94,9 @@ class StreamWriter {
   OStream&& take() { return std::move(stream_); }
 
  private:
-  Status<void> ReturnStatus() {
-    if (stream_.bad() || stream_.eof())
-      return ErrorStatus::StreamError;
-    else
-      return {};
+  Status<void> Fail() {
+    stream_.setstate(std::ios_base::badbit);
+    return ErrorStatus::StreamError;
   }
 
   OStream stream_;
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_THREAD_POOL_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nop {
+
+// Simple fixed-size pool of worker threads that implements the executor
+// interface used by parallel writers (see IsParallelWriter). The thread that
+// calls ParallelFor() participates in the work, so a pool constructed with N
+// worker threads has a concurrency of N + 1.
+//
+// Only one ParallelFor() runs at a time; concurrent calls are serialized. The
+// function passed to ParallelFor() must not call ParallelFor() on the same
+// pool.
+class ThreadPool {
+ public:
+  // Constructs a pool with one less worker thread than the number of hardware
+  // threads, accounting for the calling thread.
+  ThreadPool() : ThreadPool{DefaultThreadCount()} {}
+
+  explicit ThreadPool(std::size_t thread_count) {
+    for (std::size_t i = 0; i < thread_count; i++)
+      threads_.emplace_back([this] { WorkerLoop(); });
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      stop_ = true;
+    }
+    start_condition_.notify_all();
+    for (auto& thread : threads_)
+      thread.join();
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  std::size_t concurrency() const { return threads_.size() + 1; }
+
+  // Calls function(i) for each i in [0, count) on the pool threads and the
+  // calling thread. Returns when all of the calls have returned.
+  template <typename Function>
+  void ParallelFor(std::size_t count, Function&& function) {
+    if (count == 0)
+      return;
+
+    std::lock_guard<std::mutex> run_lock{run_mutex_};
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      // Wait for workers that woke up late for the previous job to leave it.
+      done_condition_.wait(lock, [this] { return active_ == 0; });
+
+      job_ = [&function](std::size_t index) { function(index); };
+      job_count_ = count;
+      next_ = 0;
+      completed_ = 0;
+      generation_++;
+    }
+    start_condition_.notify_all();
+
+    RunJob();
+
+    std::unique_lock<std::mutex> lock{mutex_};
+    done_condition_.wait(
+        lock, [this] { return completed_ == job_count_ && active_ == 0; });
+    job_ = nullptr;
+  }
+
+ private:
+  static std::size_t DefaultThreadCount() {
+    const std::size_t hardware_threads = std::thread::hardware_concurrency();
+    return hardware_threads > 1 ? hardware_threads - 1 : 0;
+  }
+
+  void WorkerLoop() {
+    std::size_t generation = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock{mutex_};
+        start_condition_.wait(
+            lock, [&] { return stop_ || generation_ != generation; });
+        if (stop_)
+          return;
+
+        generation = generation_;
+        active_++;
+      }
+
+      RunJob();
+
+      {
+        std::lock_guard<std::mutex> lock{mutex_};
+        active_--;
+      }
+      done_condition_.notify_all();
+    }
+  }
+
+  // Claims and runs indices of the current job until none are left.
+  void RunJob() {
+    while (true) {
+      const std::size_t index = next_.fetch_add(1);
+      if (index >= job_count_)
+        return;
+
+      job_(index);
+      if (completed_.fetch_add(1) + 1 == job_count_) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        done_condition_.notify_all();
+      }
+    }
+  }
+
+  std::vector<std::thread> threads_;
+  std::mutex run_mutex_;
+  std::mutex mutex_;
+  std::condition_variable start_condition_;
+  std::condition_variable done_condition_;
+  std::function<void(std::size_t)> job_;
+  std::atomic<std::size_t> job_count_{0};
+  std::atomic<std::size_t> next_{0};
+  std::atomic<std::size_t> completed_{0};
+  std::size_t generation_{0};
+  std::size_t active_{0};
+  bool stop_{false};
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_THREAD_POOL_H_
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_TRUSTED_BUFFER_READER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_TRUSTED_BUFFER_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <nop/base/encoding.h>
+#include <nop/base/utility.h>
+
+namespace nop {
+
+// A reader type for byte buffers that have already been checked with
+// Validate<T>(), such as messages that are validated once when they are
+// received and then decoded by one or more consumers. This reader performs no
+// bounds checks and is a trusted reader (see IsTrustedReader), which allows the
+// encodings to omit prefix and length checks while decoding.
+//
+// Reading a buffer that was not successfully validated for the same type
+// results in undefined behavior. Use BufferReader or PedanticBufferReader for
+// data that has not been validated.
+class TrustedBufferReader {
+ public:
+  using TrustedReaderTag = void;
+
+  TrustedBufferReader() = default;
+  TrustedBufferReader(const TrustedBufferReader&) = default;
+  template <std::size_t Size>
+  TrustedBufferReader(const std::uint8_t (&buffer)[Size])
+      : cursor_{buffer}, end_{buffer + Size} {}
+  TrustedBufferReader(const std::uint8_t* buffer, std::size_t size)
+      : cursor_{buffer}, end_{buffer + size} {}
+  TrustedBufferReader(const void* buffer, std::size_t size)
+      : TrustedBufferReader{static_cast<const std::uint8_t*>(buffer), size} {}
+
+  TrustedBufferReader& operator=(const TrustedBufferReader&) = default;
+
+  Status<void> Ensure(std::size_t /*size*/) { return {}; }
+
+  Status<void> Read(std::uint8_t* byte) {
+    *byte = *cursor_++;
+    return {};
+  }
+
+  template <typename T, typename Enable = EnableIfArithmetic<T>>
+  Status<void> Read(T* begin, T* end) {
+    const std::size_t length_bytes = (end - begin) * sizeof(T);
+    std::memcpy(begin, cursor_, length_bytes);
+    cursor_ += length_bytes;
+    return {};
+  }
+
+  Status<void> Skip(std::size_t padding_bytes) {
+    cursor_ += padding_bytes;
+    return {};
+  }
+
+  // Returns a pointer to the next unread byte in the buffer.
+  const std::uint8_t* cursor() const { return cursor_; }
+
+  bool empty() const { return cursor_ == end_; }
+
+  std::size_t remaining() const { return end_ - cursor_; }
+
+ private:
+  const std::uint8_t* cursor_{nullptr};
+  const std::uint8_t* end_{nullptr};
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_TRUSTED_BUFFER_READER_H_
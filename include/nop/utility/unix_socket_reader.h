@@ -0,0 +1,248 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_UNIX_SOCKET_READER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_UNIX_SOCKET_READER_H_
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <nop/base/encoding.h>
+#include <nop/base/utility.h>
+#include <nop/status.h>
+#include <nop/types/handle.h>
+#include <nop/utility/unix_socket_writer.h>
+
+namespace nop {
+
+// UnixSocketReader is a reader that receives messages sent by UnixSocketWriter
+// over an AF_UNIX SOCK_STREAM socket, including the file descriptors passed
+// with each message as SCM_RIGHTS ancillary data.
+//
+// Receive() reads the next complete message. Values are then read from the
+// message, and handles in the values resolve to the descriptors received with
+// it. Resolving a handle transfers ownership of the descriptor to the caller,
+// who should wrap it in a UniqueFileHandle or otherwise close it. Descriptors
+// of a message that are not resolved are closed by the next Receive() or when
+// the reader is destroyed. Received descriptors have FD_CLOEXEC set.
+//
+// The reader does not own the socket.
+//
+// Example:
+//
+//   nop::Deserializer<nop::UnixSocketReader> deserializer{socket_fd};
+//   auto status = deserializer.reader().Receive();
+//   Request request;
+//   if (status)
+//     status = deserializer.Read(&request);
+//   nop::UniqueFileHandle memfd{request.buffer.get()};
+//
+class UnixSocketReader {
+ public:
+  enum : std::size_t {
+    kMaxHandles = UnixSocketWriter::kMaxHandles,
+    kDefaultMaxMessageSize = 64 * 1024 * 1024,
+  };
+
+  UnixSocketReader() = default;
+  explicit UnixSocketReader(
+      int socket_fd, std::size_t max_message_size = kDefaultMaxMessageSize)
+      : socket_fd_{socket_fd}, max_message_size_{max_message_size} {}
+  UnixSocketReader(UnixSocketReader&& other) { *this = std::move(other); }
+  ~UnixSocketReader() { CloseHandles(); }
+
+  UnixSocketReader& operator=(UnixSocketReader&& other) {
+    if (this != &other) {
+      CloseHandles();
+      socket_fd_ = other.socket_fd_;
+      max_message_size_ = other.max_message_size_;
+      buffer_ = std::move(other.buffer_);
+      handles_ = std::move(other.handles_);
+      index_ = other.index_;
+      other.handles_.clear();
+      other.buffer_.clear();
+      other.index_ = 0;
+    }
+    return *this;
+  }
+
+  // Receives the next message, blocking until it has arrived completely.
+  // Returns ErrorStatus::ReadLimitReached if the peer closed the socket before
+  // the next message, and ErrorStatus::ProtocolError if the message exceeds
+  // the maximum message size or carries more descriptors than expected.
+  Status<void> Receive() {
+    CloseHandles();
+    buffer_.clear();
+    index_ = 0;
+
+    std::uint64_t length = 0;
+    auto status = ReceiveHeader(&length);
+    if (!status)
+      return status;
+    else if (length > max_message_size_)
+      return ErrorStatus::ProtocolError;
+
+    buffer_.resize(length);
+    std::size_t received = 0;
+    while (received < length) {
+      const ssize_t ret =
+          ::recv(socket_fd_, buffer_.data() + received, length - received, 0);
+      if (ret < 0 && errno == EINTR)
+        continue;  // Interrupted by signal.
+      else if (ret < 0)
+        return ErrorStatus::IOError;
+      else if (ret == 0)
+        return ErrorStatus::ReadLimitReached;
+      received += ret;
+    }
+
+    return {};
+  }
+
+  Status<void> Ensure(std::size_t size) {
+    if (buffer_.size() - index_ < size)
+      return ErrorStatus::ReadLimitReached;
+    else
+      return {};
+  }
+
+  Status<void> Read(std::uint8_t* byte) { return Read(byte, byte + 1); }
+
+  template <typename T, typename Enable = EnableIfArithmetic<T>>
+  Status<void> Read(T* begin, T* end) {
+    const std::size_t length_bytes = (end - begin) * sizeof(T);
+    auto status = Ensure(length_bytes);
+    if (!status)
+      return status;
+
+    std::memcpy(begin, buffer_.data() + index_, length_bytes);
+    index_ += length_bytes;
+    return {};
+  }
+
+  Status<void> Skip(std::size_t padding_bytes) {
+    auto status = Ensure(padding_bytes);
+    if (!status)
+      return status;
+
+    index_ += padding_bytes;
+    return {};
+  }
+
+  template <typename HandleType>
+  Status<HandleType> GetHandle(HandleReference handle_reference) {
+    static_assert(std::is_same<typename HandleType::Type, int>::value,
+                  "UnixSocketReader only supports file descriptor handles.");
+    if (handle_reference < 0)
+      return {HandleType{}};
+    else if (handle_reference >= static_cast<HandleReference>(handles_.size()))
+      return ErrorStatus::InvalidHandleReference;
+
+    // Each descriptor may only be claimed once.
+    int& handle = handles_[handle_reference];
+    if (handle < 0)
+      return ErrorStatus::InvalidHandleReference;
+
+    HandleType value{handle};
+    handle = -1;
+    return {std::move(value)};
+  }
+
+  int socket_fd() const { return socket_fd_; }
+
+  // Returns the number of unread bytes in the current message.
+  std::size_t remaining() const { return buffer_.size() - index_; }
+  bool empty() const { return remaining() == 0; }
+
+  // Returns the number of descriptors received with the current message.
+  std::size_t handle_count() const { return handles_.size(); }
+
+ private:
+  // Receives the message length along with the descriptors attached to the
+  // first bytes of the message.
+  Status<void> ReceiveHeader(std::uint64_t* length) {
+    std::uint8_t* header = reinterpret_cast<std::uint8_t*>(length);
+    std::size_t received = 0;
+    alignas(cmsghdr)
+        std::uint8_t control[CMSG_SPACE(kMaxHandles * sizeof(int))];
+
+    while (received < sizeof(*length)) {
+      iovec vector{header + received, sizeof(*length) - received};
+      msghdr message{};
+      message.msg_iov = &vector;
+      message.msg_iovlen = 1;
+      message.msg_control = control;
+      message.msg_controllen = sizeof(control);
+
+      const ssize_t ret = ::recvmsg(socket_fd_, &message, MSG_CMSG_CLOEXEC);
+      if (ret < 0 && errno == EINTR)
+        continue;  // Interrupted by signal.
+      else if (ret < 0)
+        return ErrorStatus::IOError;
+      else if (ret == 0)
+        return ErrorStatus::ReadLimitReached;
+
+      for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr;
+           cmsg = CMSG_NXTHDR(&message, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+          const std::size_t count =
+              (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+          const std::size_t offset = handles_.size();
+          handles_.resize(offset + count);
+          std::memcpy(&handles_[offset], CMSG_DATA(cmsg), count * sizeof(int));
+        }
+      }
+
+      if (message.msg_flags & MSG_CTRUNC)
+        return ErrorStatus::ProtocolError;
+
+      received += ret;
+    }
+
+    return {};
+  }
+
+  void CloseHandles() {
+    for (int handle : handles_) {
+      if (handle >= 0)
+        ::close(handle);
+    }
+    handles_.clear();
+  }
+
+  int socket_fd_{-1};
+  std::size_t max_message_size_{kDefaultMaxMessageSize};
+  std::vector<std::uint8_t> buffer_;
+  std::vector<int> handles_;
+  std::size_t index_{0};
+
+  UnixSocketReader(const UnixSocketReader&) = delete;
+  UnixSocketReader& operator=(const UnixSocketReader&) = delete;
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_UNIX_SOCKET_READER_H_
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_UTILITY_UNIX_SOCKET_WRITER_H_
+#define LIBNOP_INCLUDE_NOP_UTILITY_UNIX_SOCKET_WRITER_H_
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <nop/base/encoding.h>
+#include <nop/base/utility.h>
+#include <nop/status.h>
+#include <nop/types/handle.h>
+
+namespace nop {
+
+// UnixSocketWriter is a writer that sends messages over an AF_UNIX socket,
+// passing the file descriptors of any handles in the message to the receiver as
+// SCM_RIGHTS ancillary data. This allows memfds, sockets, and other files to be
+// sent with a message instead of copying bulk data through the socket. The
+// receiving end is UnixSocketReader.
+//
+// Values written to the writer are collected into a message, together with the
+// handles pushed while writing them. Send() transmits the message as:
+//
+// +----------+---//----+
+// | UINT64:L | L BYTES |
+// +----------+---//----+
+//
+// where L is in the native byte order, since both ends share a host. The
+// socket must be a SOCK_STREAM socket. The descriptors are attached to the
+// first bytes of the message, which the reader receives before any others.
+//
+// The writer does not own the socket or the pushed descriptors. The kernel
+// duplicates the descriptors into the receiver, so the sender may close them
+// as soon as Send() returns.
+//
+// Example:
+//
+//   nop::Serializer<nop::UnixSocketWriter> serializer{socket_fd};
+//   auto status = serializer.Write(Request{"buffer", FileHandle{memfd}});
+//   if (status)
+//     status = serializer.writer().Send();
+//
+class UnixSocketWriter {
+ public:
+  // The maximum number of descriptors that may be sent with one message, as
+  // limited by the kernel (SCM_MAX_FD).
+  enum : std::size_t { kMaxHandles = 253 };
+
+  UnixSocketWriter() = default;
+  explicit UnixSocketWriter(int socket_fd) : socket_fd_{socket_fd} {}
+  UnixSocketWriter(UnixSocketWriter&&) = default;
+  UnixSocketWriter& operator=(UnixSocketWriter&&) = default;
+
+  // Grows the buffer geometrically so that messages built from many writes
+  // are not reallocated and copied on every write.
+  Status<void> Prepare(std::size_t size) {
+    const std::size_t required = buffer_.size() + size;
+    if (required > buffer_.capacity())
+      buffer_.reserve(std::max(required, 2 * buffer_.capacity()));
+    return {};
+  }
+
+  Status<void> Write(std::uint8_t byte) {
+    buffer_.push_back(byte);
+    return {};
+  }
+
+  template <typename T, typename Enable = EnableIfArithmetic<T>>
+  Status<void> Write(const T* begin, const T* end) {
+    const std::uint8_t* begin_byte =
+        reinterpret_cast<const std::uint8_t*>(begin);
+    const std::uint8_t* end_byte = reinterpret_cast<const std::uint8_t*>(end);
+    buffer_.insert(buffer_.end(), begin_byte, end_byte);
+    return {};
+  }
+
+  Status<void> Skip(std::size_t padding_bytes,
+                    std::uint8_t padding_value = 0x00) {
+    buffer_.insert(buffer_.end(), padding_bytes, padding_value);
+    return {};
+  }
+
+  template <typename HandleType>
+  Status<HandleReference> PushHandle(const HandleType& handle) {
+    static_assert(std::is_same<typename HandleType::Type, int>::value,
+                  "UnixSocketWriter only supports file descriptor handles.");
+    if (!handle)
+      return {kEmptyHandleReference};
+    else if (handles_.size() == kMaxHandles)
+      return ErrorStatus::WriteLimitReached;
+
+    const HandleReference handle_reference = handles_.size();
+    handles_.push_back(handle.get());
+    return {handle_reference};
+  }
+
+  // Sends the message collected since the last call to Send() or clear(),
+  // retrying partial sends and interrupted calls. The message is cleared
+  // whether or not it was sent.
+  Status<void> Send() {
+    auto status = SendMessage();
+    clear();
+    return status;
+  }
+
+  // Discards the message collected since the last call to Send().
+  void clear() {
+    buffer_.clear();
+    handles_.clear();
+  }
+
+  int socket_fd() const { return socket_fd_; }
+  std::size_t size() const { return buffer_.size(); }
+  const std::vector<int>& handles() const { return handles_; }
+
+ private:
+  Status<void> SendMessage() {
+    std::uint64_t length = buffer_.size();
+    iovec vectors[2] = {{&length, sizeof(length)},
+                        {buffer_.data(), buffer_.size()}};
+    iovec* vector = vectors;
+    std::size_t count = 2;
+
+    std::vector<std::uint8_t> control;
+    msghdr message{};
+    if (!handles_.empty()) {
+      const std::size_t handles_size = handles_.size() * sizeof(int);
+      control.resize(CMSG_SPACE(handles_size));
+      message.msg_control = control.data();
+      message.msg_controllen = control.size();
+
+      cmsghdr* header = CMSG_FIRSTHDR(&message);
+      header->cmsg_level = SOL_SOCKET;
+      header->cmsg_type = SCM_RIGHTS;
+      header->cmsg_len = CMSG_LEN(handles_size);
+      std::memcpy(CMSG_DATA(header), handles_.data(), handles_size);
+    }
+
+    while (count > 0) {
+      message.msg_iov = vector;
+      message.msg_iovlen = count;
+      const ssize_t ret = ::sendmsg(socket_fd_, &message, MSG_NOSIGNAL);
+      if (ret < 0 && errno == EINTR)
+        continue;  // Interrupted by signal.
+      else if (ret < 0)
+        return ErrorStatus::IOError;
+
+      // The descriptors were sent with the first bytes of the message.
+      message.msg_control = nullptr;
+      message.msg_controllen = 0;
+
+      std::size_t sent = ret;
+      while (count > 0 && sent >= vector->iov_len) {
+        sent -= vector->iov_len;
+        vector++;
+        count--;
+      }
+      if (count > 0) {
+        vector->iov_base = static_cast<std::uint8_t*>(vector->iov_base) + sent;
+        vector->iov_len -= sent;
+      }
+    }
+
+    return {};
+  }
+
+  int socket_fd_{-1};
+  std::vector<std::uint8_t> buffer_;
+  std::vector<int> handles_;
+
+  UnixSocketWriter(const UnixSocketWriter&) = delete;
+  UnixSocketWriter& operator=(const UnixSocketWriter&) = delete;
+};
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_UTILITY_UNIX_SOCKET_WRITER_H_
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2019 The Native Object Protocols Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBNOP_INCLUDE_NOP_VALIDATE_H_
+#define LIBNOP_INCLUDE_NOP_VALIDATE_H_
+
+#include <cstddef>
+
+#include <nop/serializer.h>
+#include <nop/status.h>
+#include <nop/utility/pedantic_buffer_reader.h>
+
+namespace nop {
+
+//
+// Validate<T>() checks that a buffer begins with a well-formed encoding of type
+// T, applying the same checks as deserialization without constructing any
+// values. Containers and strings are skipped over instead of being allocated,
+// handles are checked without being resolved, and Lazy<T> members are checked
+// in full.
+//
+// Validation is intended to be paired with TrustedBufferReader when the same
+// data is decoded after it is checked, for example when a message in shared
+// memory is validated once on receipt and then decoded by its consumers:
+//
+//   auto status = nop::Validate<Message>(buffer, size);
+//   if (!status)
+//     return status;
+//
+//   nop::Deserializer<nop::TrustedBufferReader> deserializer{buffer, size};
+//   Message message;
+//   deserializer.Read(&message);
+//
+// Bytes following the encoded value are not examined.
+//
+
+template <typename T>
+Status<void> Validate(const void* buffer, std::size_t size) {
+  PedanticBufferReader reader{buffer, size};
+  return Encoding<T>::Validate(&reader);
+}
+
+}  // namespace nop
+
+#endif  // LIBNOP_INCLUDE_NOP_VALIDATE_H_
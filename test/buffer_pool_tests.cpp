@@ -0,0 +1,154 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/utility/buffer_pool.h>
+#include <nop/utility/buffer_reader.h>
+
+using nop::BufferPool;
+using nop::BufferReader;
+using nop::Deserializer;
+using nop::PooledBuffer;
+using nop::PooledBufferWriter;
+using nop::SerializeToPooledBuffer;
+using nop::Serializer;
+
+TEST(BufferPool, Reuse) {
+  BufferPool::Trim();
+
+  const std::uint8_t* data;
+  {
+    PooledBuffer buffer = BufferPool::Acquire(100);
+    EXPECT_EQ(std::size_t{BufferPool::kMinCapacity}, buffer.capacity());
+    EXPECT_EQ(0u, buffer.size());
+    data = buffer.data();
+  }
+  EXPECT_EQ(1u, BufferPool::stats().cached_buffers);
+
+  // The released buffer is handed out again for any size in its class.
+  const std::size_t hits = BufferPool::stats().hits;
+  PooledBuffer buffer = BufferPool::Acquire(BufferPool::kMinCapacity);
+  EXPECT_EQ(data, buffer.data());
+  EXPECT_EQ(hits + 1, BufferPool::stats().hits);
+  EXPECT_EQ(0u, BufferPool::stats().cached_buffers);
+
+  // Size classes are powers of two.
+  PooledBuffer larger = BufferPool::Acquire(BufferPool::kMinCapacity + 1);
+  EXPECT_EQ(2u * BufferPool::kMinCapacity, larger.capacity());
+
+  // Buffers beyond the largest size class are not cached.
+  PooledBuffer huge = BufferPool::Acquire(BufferPool::kMaxCapacity + 1);
+  EXPECT_EQ(BufferPool::kMaxCapacity + 1u, huge.capacity());
+  huge.reset();
+  EXPECT_EQ(nullptr, huge.data());
+  EXPECT_EQ(0u, BufferPool::stats().cached_buffers);
+
+  buffer.reset();
+  larger.reset();
+  EXPECT_EQ(2u, BufferPool::stats().cached_buffers);
+  EXPECT_EQ(3u * BufferPool::kMinCapacity, BufferPool::stats().cached_bytes);
+
+  BufferPool::Trim();
+  EXPECT_EQ(0u, BufferPool::stats().cached_buffers);
+}
+
+TEST(BufferPool, HighWaterTrim) {
+  BufferPool::Trim();
+
+  // A burst of buffers in use at once.
+  {
+    std::vector<PooledBuffer> burst;
+    for (int i = 0; i < 8; i++)
+      burst.push_back(BufferPool::Acquire(1000));
+  }
+  EXPECT_EQ(8u, BufferPool::stats().cached_buffers);
+
+  // After a full interval with one buffer in use at a time the cache is
+  // trimmed to that high-water mark.
+  for (std::size_t i = 0; i < BufferPool::kTrimInterval; i++)
+    BufferPool::Acquire(1000);
+  EXPECT_EQ(1u, BufferPool::stats().cached_buffers);
+
+  BufferPool::Trim();
+}
+
+TEST(BufferPool, Threads) {
+  BufferPool::Trim();
+  PooledBuffer buffer = BufferPool::Acquire(1000);
+
+  // Buffers return to the cache of the thread that releases them.
+  std::thread thread{[&buffer] {
+    buffer.reset();
+    EXPECT_EQ(1u, BufferPool::stats().cached_buffers);
+  }};
+  thread.join();
+  EXPECT_EQ(0u, BufferPool::stats().cached_buffers);
+}
+
+TEST(BufferPool, Writer) {
+  BufferPool::Trim();
+  const std::vector<std::string> value{"a", std::string(1000, 'b'), "c"};
+
+  Serializer<PooledBufferWriter> serializer;
+  ASSERT_TRUE(serializer.Write(value));
+  const std::size_t size = serializer.GetSize(value);
+  EXPECT_EQ(size, serializer.writer().size());
+
+  // Writing more than the capacity moves the data to a larger buffer.
+  ASSERT_TRUE(serializer.Write(value));
+  EXPECT_EQ(2 * size, serializer.writer().size());
+  EXPECT_LE(2 * size, serializer.writer().capacity());
+
+  PooledBuffer buffer = serializer.writer().take();
+  EXPECT_EQ(2 * size, buffer.size());
+  EXPECT_EQ(0u, serializer.writer().size());
+
+  Deserializer<BufferReader> deserializer{buffer.data(), buffer.size()};
+  std::vector<std::string> decoded;
+  ASSERT_TRUE(deserializer.Read(&decoded));
+  EXPECT_EQ(value, decoded);
+  ASSERT_TRUE(deserializer.Read(&decoded));
+  EXPECT_EQ(value, decoded);
+  EXPECT_TRUE(deserializer.reader().empty());
+}
+
+TEST(BufferPool, Serialize) {
+  BufferPool::Trim();
+  const std::vector<int> value{1, 2, 3, 1000, -1};
+
+  const std::uint8_t* data;
+  {
+    auto status = SerializeToPooledBuffer(value);
+    ASSERT_TRUE(status);
+    data = status.get().data();
+
+    Deserializer<BufferReader> deserializer{status.get().data(),
+                                            status.get().size()};
+    std::vector<int> decoded;
+    ASSERT_TRUE(deserializer.Read(&decoded));
+    EXPECT_EQ(value, decoded);
+  }
+
+  // Serializing again in steady state reuses the same buffer.
+  auto status = SerializeToPooledBuffer(value);
+  ASSERT_TRUE(status);
+  EXPECT_EQ(data, status.get().data());
+}
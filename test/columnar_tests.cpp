@@ -0,0 +1,164 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/types/columnar.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/buffer_writer.h>
+
+#include "test_reader.h"
+#include "test_utilities.h"
+#include "test_writer.h"
+
+using nop::BufferReader;
+using nop::BufferWriter;
+using nop::ColumnarVector;
+using nop::Compose;
+using nop::Deserializer;
+using nop::EncodingByte;
+using nop::ErrorStatus;
+using nop::Serializer;
+using nop::Status;
+using nop::TestReader;
+using nop::TestWriter;
+
+namespace {
+
+struct Point {
+  std::uint16_t id;
+  std::string label;
+
+  NOP_STRUCTURE(Point, id, label);
+};
+
+bool operator==(const Point& a, const Point& b) {
+  return a.id == b.id && a.label == b.label;
+}
+
+struct Sample {
+  std::uint64_t time;
+  float value;
+  bool valid;
+  std::array<std::int8_t, 4> tags;
+  std::size_t tag_count;
+
+  NOP_STRUCTURE(Sample, time, value, valid, (tags, tag_count));
+};
+
+bool operator==(const Sample& a, const Sample& b) {
+  return a.time == b.time && a.value == b.value && a.valid == b.valid &&
+         a.tag_count == b.tag_count &&
+         std::equal(a.tags.begin(), a.tags.begin() + a.tag_count,
+                    b.tags.begin());
+}
+
+}  // anonymous namespace
+
+TEST(Columnar, Write) {
+  TestWriter writer;
+  Serializer<TestWriter*> serializer{&writer};
+
+  ColumnarVector<Point> points{{1, "a"}, {2, "bc"}};
+  ASSERT_TRUE(serializer.Write(points));
+
+  const std::vector<std::uint8_t> expected =
+      Compose(EncodingByte::Structure, 3, 2, EncodingByte::Binary, 4, 1, 0, 2,
+              0, EncodingByte::Array, 2, EncodingByte::String, 1, "a",
+              EncodingByte::String, 2, "bc");
+  EXPECT_EQ(expected, writer.data());
+  EXPECT_EQ(expected.size(), serializer.GetSize(points));
+
+  writer.clear();
+  ASSERT_TRUE(serializer.Write(ColumnarVector<Point>{}));
+  EXPECT_EQ(Compose(EncodingByte::Structure, 3, 0, EncodingByte::Binary, 0,
+                    EncodingByte::Array, 0),
+            writer.data());
+}
+
+TEST(Columnar, Read) {
+  TestReader reader;
+  Deserializer<TestReader*> deserializer{&reader};
+
+  reader.Set(Compose(EncodingByte::Structure, 3, 2, EncodingByte::Binary, 4, 1,
+                     0, 2, 0, EncodingByte::Array, 2, EncodingByte::String, 1,
+                     "a", EncodingByte::String, 2, "bc"));
+  ColumnarVector<Point> points{{9, "stale"}};
+  ASSERT_TRUE(deserializer.Read(&points));
+  EXPECT_EQ((std::vector<Point>{{1, "a"}, {2, "bc"}}), points);
+}
+
+TEST(Columnar, RoundTrip) {
+  ColumnarVector<Sample> samples;
+  for (std::size_t i = 0; i < 1000; i++) {
+    Sample sample{i * 1000, i * 0.5f, i % 3 == 0, {{1, -2, 3, -4}}, i % 5};
+    samples.push_back(sample);
+  }
+
+  Serializer<BufferWriter> serializer;
+  std::vector<std::uint8_t> buffer(serializer.GetSize(samples));
+  serializer.writer() = BufferWriter{buffer.data(), buffer.size()};
+  ASSERT_TRUE(serializer.Write(samples));
+  EXPECT_EQ(buffer.size(), serializer.writer().size());
+
+  ColumnarVector<Sample> decoded;
+  Deserializer<BufferReader> deserializer{buffer.data(), buffer.size()};
+  ASSERT_TRUE(deserializer.Read(&decoded));
+  EXPECT_TRUE(deserializer.reader().empty());
+  EXPECT_EQ(samples, decoded);
+}
+
+TEST(Columnar, Errors) {
+  TestReader reader;
+  Deserializer<TestReader*> deserializer{&reader};
+  ColumnarVector<Point> points;
+  Status<void> status;
+
+  reader.Set(Compose(EncodingByte::Structure, 2, 0, EncodingByte::Binary, 0));
+  status = deserializer.Read(&points);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::InvalidMemberCount, status.error());
+
+  reader.Set(Compose(EncodingByte::Structure, 3, 2, EncodingByte::Binary, 2, 1,
+                     0));
+  status = deserializer.Read(&points);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::InvalidContainerLength, status.error());
+
+  reader.Set(Compose(EncodingByte::Structure, 3, 1, EncodingByte::Array, 1, 1));
+  status = deserializer.Read(&points);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::UnexpectedEncodingType, status.error());
+
+  reader.Set(Compose(EncodingByte::Structure, 3, 1, EncodingByte::Binary, 2, 1,
+                     0, EncodingByte::Array, 2, EncodingByte::String, 0));
+  status = deserializer.Read(&points);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::InvalidContainerLength, status.error());
+
+  // A huge element count is rejected before the vector is resized.
+  reader.Set(Compose(EncodingByte::Structure, 3, EncodingByte::U32, 0, 0, 0, 64,
+                     EncodingByte::Binary, EncodingByte::U32, 0, 0, 0, 128));
+  status = deserializer.Read(&points);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+}
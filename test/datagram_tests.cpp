@@ -0,0 +1,253 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/datagram_reader.h>
+#include <nop/utility/datagram_writer.h>
+
+#include "test_utilities.h"
+
+using nop::BufferReader;
+using nop::DatagramReader;
+using nop::DatagramWriter;
+using nop::Deserializer;
+using nop::ErrorStatus;
+using nop::Serializer;
+using nop::SocketPair;
+
+namespace {
+
+struct Sample {
+  std::uint32_t id;
+  std::string source;
+  double value;
+
+  NOP_STRUCTURE(Sample, id, source, value);
+};
+
+Sample MakeSample(std::uint32_t id) {
+  return {id, "sensor" + std::to_string(id % 3), id * 0.5};
+}
+
+}  // anonymous namespace
+
+TEST(Datagram, Batches) {
+  SocketPair sockets{SOCK_DGRAM | SOCK_NONBLOCK};
+
+  DatagramWriter::Options options;
+  options.batch_size = 4;
+  options.max_latency = std::chrono::hours{1};
+  Serializer<DatagramWriter> serializer{sockets.sender(), options};
+  DatagramWriter& writer = serializer.writer();
+
+  // Messages are queued until a batch is full.
+  for (std::uint32_t i = 0; i < 10; i++) {
+    ASSERT_TRUE(serializer.Write(MakeSample(i)));
+    ASSERT_TRUE(writer.Send());
+  }
+  EXPECT_EQ(2u, writer.stats().batches);
+  EXPECT_EQ(8u, writer.stats().messages);
+  EXPECT_EQ(2u, writer.queued());
+
+  ASSERT_TRUE(writer.Flush());
+  EXPECT_EQ(3u, writer.stats().batches);
+  EXPECT_EQ(10u, writer.stats().messages);
+  EXPECT_EQ(0u, writer.queued());
+
+  DatagramReader::Options reader_options;
+  reader_options.batch_size = 8;
+  reader_options.max_message_size = 256;
+  DatagramReader reader{sockets.receiver(), reader_options};
+
+  std::uint32_t next_id = 0;
+  for (std::size_t expected : {8u, 2u}) {
+    auto status = reader.Receive();
+    ASSERT_TRUE(status);
+    ASSERT_EQ(expected, status.get());
+    for (std::size_t i = 0; i < reader.count(); i++) {
+      EXPECT_FALSE(reader.truncated(i));
+      Deserializer<BufferReader> deserializer{reader.reader(i)};
+      Sample sample;
+      ASSERT_TRUE(deserializer.Read(&sample));
+      EXPECT_TRUE(deserializer.reader().empty());
+      EXPECT_EQ(next_id, sample.id);
+      EXPECT_EQ(MakeSample(next_id).source, sample.source);
+      next_id++;
+    }
+  }
+  EXPECT_EQ(2u, reader.stats().batches);
+  EXPECT_EQ(10u, reader.stats().messages);
+  EXPECT_EQ(writer.stats().bytes, reader.stats().bytes);
+
+  auto status = reader.Receive();
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::WouldBlock, status.error());
+}
+
+TEST(Datagram, Latency) {
+  SocketPair sockets{SOCK_DGRAM | SOCK_NONBLOCK};
+
+  // Messages stay queued until they have waited for the maximum latency.
+  DatagramWriter::Options options;
+  options.batch_size = 100;
+  options.max_latency = std::chrono::seconds{10};
+  Serializer<DatagramWriter> slow{sockets.sender(), options};
+  ASSERT_TRUE(slow.Write(MakeSample(1)));
+  ASSERT_TRUE(slow.writer().Send());
+  ASSERT_TRUE(slow.writer().Poll());
+  EXPECT_EQ(1u, slow.writer().queued());
+  EXPECT_EQ(0u, slow.writer().stats().messages);
+
+  // Once the oldest message has waited long enough it is flushed.
+  options.max_latency = std::chrono::milliseconds{5};
+  Serializer<DatagramWriter> fast{sockets.sender(), options};
+  ASSERT_TRUE(fast.Write(MakeSample(2)));
+  ASSERT_TRUE(fast.writer().Send());
+  std::this_thread::sleep_for(std::chrono::milliseconds{10});
+  ASSERT_TRUE(fast.writer().Poll());
+  EXPECT_EQ(0u, fast.writer().queued());
+  EXPECT_EQ(1u, fast.writer().stats().messages);
+
+  // With no latency every message is sent immediately.
+  options.max_latency = std::chrono::microseconds{0};
+  Serializer<DatagramWriter> immediate{sockets.sender(), options};
+  ASSERT_TRUE(immediate.Write(MakeSample(3)));
+  ASSERT_TRUE(immediate.writer().Send());
+  EXPECT_EQ(0u, immediate.writer().queued());
+
+  DatagramReader reader{sockets.receiver()};
+  auto status = reader.Receive();
+  ASSERT_TRUE(status);
+  EXPECT_EQ(2u, status.get());
+}
+
+TEST(Datagram, LatencyAfterPartialFlush) {
+  SocketPair sockets{SOCK_DGRAM | SOCK_NONBLOCK};
+  DatagramReader reader{sockets.receiver()};
+
+  DatagramWriter::Options options;
+  options.batch_size = 1000;
+  options.max_latency = std::chrono::milliseconds{20};
+  Serializer<DatagramWriter> serializer{sockets.sender(), options};
+  DatagramWriter& writer = serializer.writer();
+
+  // Queue more messages than the receiving socket can hold.
+  for (std::uint32_t i = 0; i < 1000; i++) {
+    ASSERT_TRUE(serializer.Write(MakeSample(i)));
+    auto status = writer.Send();
+    ASSERT_TRUE(status || status.error() == ErrorStatus::WouldBlock);
+  }
+  while (reader.Receive()) {
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds{30});
+  auto status = writer.Flush();
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::WouldBlock, status.error());
+  const std::size_t queued = writer.queued();
+  ASSERT_LT(0u, queued);
+  while (reader.Receive()) {
+  }
+
+  // The messages left behind have already waited for the maximum latency, so
+  // the partial flush must not restart their clock.
+  status = writer.Poll();
+  ASSERT_TRUE(status || status.error() == ErrorStatus::WouldBlock);
+  EXPECT_GT(queued, writer.queued());
+}
+
+TEST(Datagram, ZeroOptions) {
+  SocketPair sockets{SOCK_DGRAM | SOCK_NONBLOCK};
+
+  // Zero batch and message sizes are treated as one.
+  DatagramWriter::Options options;
+  options.batch_size = 0;
+  options.max_message_size = 0;
+  Serializer<DatagramWriter> serializer{sockets.sender(), options};
+  DatagramWriter& writer = serializer.writer();
+  EXPECT_EQ(1u, writer.options().batch_size);
+  EXPECT_EQ(1u, writer.options().max_message_size);
+
+  for (std::uint8_t i = 0; i < 3; i++) {
+    ASSERT_TRUE(serializer.Write(i));
+    ASSERT_TRUE(writer.Send());
+    EXPECT_EQ(0u, writer.queued());
+  }
+  EXPECT_EQ(3u, writer.stats().batches);
+
+  DatagramReader::Options reader_options;
+  reader_options.batch_size = 0;
+  reader_options.max_message_size = 0;
+  DatagramReader reader{sockets.receiver(), reader_options};
+  EXPECT_EQ(1u, reader.options().batch_size);
+  EXPECT_EQ(1u, reader.options().max_message_size);
+
+  for (std::uint8_t i = 0; i < 3; i++) {
+    auto status = reader.Receive();
+    ASSERT_TRUE(status);
+    ASSERT_EQ(1u, status.get());
+    ASSERT_EQ(1u, reader.size(0));
+    EXPECT_EQ(i, reader.data(0)[0]);
+  }
+}
+
+TEST(Datagram, Errors) {
+  SocketPair sockets{SOCK_DGRAM | SOCK_NONBLOCK};
+
+  DatagramWriter::Options options;
+  options.max_message_size = 16;
+  Serializer<DatagramWriter> serializer{sockets.sender(), options};
+  auto status = serializer.Write(std::string(100, 'x'));
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::WriteLimitReached, status.error());
+  serializer.writer().clear();
+  EXPECT_EQ(0u, serializer.writer().size());
+
+  // Datagrams longer than the receive buffers are truncated.
+  ASSERT_TRUE(serializer.Write(std::string(10, 'x')));
+  ASSERT_TRUE(serializer.writer().Send());
+  ASSERT_TRUE(serializer.writer().Flush());
+
+  DatagramReader::Options reader_options;
+  reader_options.max_message_size = 4;
+  DatagramReader reader{sockets.receiver(), reader_options};
+  auto receive_status = reader.Receive();
+  ASSERT_TRUE(receive_status);
+  ASSERT_EQ(1u, receive_status.get());
+  EXPECT_TRUE(reader.truncated(0));
+  EXPECT_EQ(4u, reader.size(0));
+  EXPECT_EQ(1u, reader.stats().truncated);
+
+  // Errors other than a full socket discard the queue.
+  DatagramWriter closed{-1};
+  ASSERT_TRUE(closed.Write(std::uint8_t{1}));
+  ASSERT_TRUE(closed.Send());
+  status = closed.Flush();
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::IOError, status.error());
+  EXPECT_EQ(0u, closed.queued());
+  EXPECT_EQ(1u, closed.stats().errors);
+}
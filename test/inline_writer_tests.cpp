@@ -0,0 +1,103 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/inline_writer.h>
+
+using nop::BufferReader;
+using nop::Deserializer;
+using nop::InlineWriter;
+using nop::Serializer;
+
+namespace {
+
+template <typename T, typename Writer>
+T Decode(const Writer& writer) {
+  Deserializer<BufferReader> deserializer{writer.data(), writer.size()};
+  T value;
+  EXPECT_TRUE(deserializer.Read(&value));
+  EXPECT_TRUE(deserializer.reader().empty());
+  return value;
+}
+
+}  // anonymous namespace
+
+TEST(InlineWriter, Inline) {
+  const std::vector<std::string> value{"small", "message"};
+
+  Serializer<InlineWriter<64>> serializer;
+  ASSERT_TRUE(serializer.Write(value));
+  EXPECT_FALSE(serializer.writer().spilled());
+  EXPECT_EQ(64u, serializer.writer().capacity());
+  EXPECT_EQ(serializer.GetSize(value), serializer.writer().size());
+  EXPECT_EQ(value, Decode<std::vector<std::string>>(serializer.writer()));
+}
+
+TEST(InlineWriter, Spill) {
+  const std::string small = "small";
+  const std::string large(1000, 'x');
+
+  Serializer<InlineWriter<64>> serializer;
+  ASSERT_TRUE(serializer.Write(small));
+  ASSERT_TRUE(serializer.Write(large));
+  EXPECT_TRUE(serializer.writer().spilled());
+  EXPECT_LE(serializer.writer().size(), serializer.writer().capacity());
+
+  // The data written before the spill is kept.
+  Deserializer<BufferReader> deserializer{serializer.writer().data(),
+                                          serializer.writer().size()};
+  std::string value;
+  ASSERT_TRUE(deserializer.Read(&value));
+  EXPECT_EQ(small, value);
+  ASSERT_TRUE(deserializer.Read(&value));
+  EXPECT_EQ(large, value);
+
+  // Clearing keeps the heap buffer; shrinking returns to inline storage.
+  serializer.writer().clear();
+  EXPECT_TRUE(serializer.writer().spilled());
+  ASSERT_TRUE(serializer.Write(small));
+  serializer.writer().shrink_to_fit();
+  EXPECT_FALSE(serializer.writer().spilled());
+  EXPECT_EQ(small, Decode<std::string>(serializer.writer()));
+}
+
+TEST(InlineWriter, Move) {
+  InlineWriter<32> inline_writer;
+  Serializer<InlineWriter<32>*> serializer{&inline_writer};
+  ASSERT_TRUE(serializer.Write(std::string{"inline"}));
+
+  InlineWriter<32> moved{std::move(inline_writer)};
+  EXPECT_FALSE(moved.spilled());
+  EXPECT_EQ(0u, inline_writer.size());
+  EXPECT_EQ("inline", Decode<std::string>(moved));
+
+  const std::string large(100, 'y');
+  ASSERT_TRUE(serializer.Write(large));
+  ASSERT_TRUE(inline_writer.spilled());
+  const std::uint8_t* data = inline_writer.data();
+
+  moved = std::move(inline_writer);
+  EXPECT_TRUE(moved.spilled());
+  EXPECT_EQ(data, moved.data());
+  EXPECT_FALSE(inline_writer.spilled());
+  EXPECT_EQ(large, Decode<std::string>(moved));
+}
@@ -0,0 +1,127 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/utility/key_value_file.h>
+
+#include "test_utilities.h"
+
+using nop::ErrorStatus;
+using nop::KeyValueFileBuilder;
+using nop::KeyValueFileReader;
+using nop::Status;
+using nop::TempFile;
+
+namespace {
+
+struct Record {
+  std::uint32_t id;
+  std::vector<std::string> tags;
+
+  NOP_STRUCTURE(Record, id, tags);
+};
+
+std::string MakeKey(std::uint32_t id) { return "key" + std::to_string(id); }
+
+Record MakeRecord(std::uint32_t id) {
+  return {id, std::vector<std::string>(id % 4, std::to_string(id))};
+}
+
+}  // anonymous namespace
+
+TEST(KeyValueFile, BuildFind) {
+  TempFile file{"key_value_file_tests"};
+  {
+    KeyValueFileBuilder<std::string, Record> builder{1024};
+    ASSERT_TRUE(builder.Open(file.path()));
+    for (std::uint32_t id = 0; id < 5000; id++)
+      ASSERT_TRUE(builder.Add(MakeKey(id), MakeRecord(id)));
+
+    // Duplicates resolve to the first value added.
+    ASSERT_TRUE(builder.Add(MakeKey(7), MakeRecord(8)));
+    // Keys longer than the inline lookup buffer.
+    ASSERT_TRUE(builder.Add(std::string(200, 'x'), MakeRecord(1)));
+    EXPECT_EQ(5002u, builder.size());
+    ASSERT_TRUE(builder.Finish());
+  }
+
+  KeyValueFileReader<std::string, Record> reader;
+  ASSERT_TRUE(reader.Open(file.path()));
+  EXPECT_EQ(5002u, reader.size());
+
+  for (std::uint32_t id = 0; id < 5000; id++) {
+    Record record;
+    auto status = reader.Find(MakeKey(id), &record);
+    ASSERT_TRUE(status) << "id=" << id;
+    ASSERT_TRUE(status.get()) << "id=" << id;
+    EXPECT_EQ(id, record.id);
+    EXPECT_EQ(MakeRecord(id).tags, record.tags);
+  }
+
+  Record record;
+  auto status = reader.Find(std::string(200, 'x'), &record);
+  ASSERT_TRUE(status);
+  EXPECT_TRUE(status.get());
+  EXPECT_EQ(1u, record.id);
+
+  status = reader.Find("missing", &record);
+  ASSERT_TRUE(status);
+  EXPECT_FALSE(status.get());
+}
+
+TEST(KeyValueFile, Errors) {
+  KeyValueFileReader<int, int> reader;
+  Status<void> status = reader.Open("/nonexistent/key_value_file");
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::IOError, status.error());
+
+  // An empty file has no header.
+  TempFile file{"key_value_file_tests"};
+  status = reader.Open(file.path());
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ProtocolError, status.error());
+
+  // A file missing part of its index is rejected.
+  {
+    KeyValueFileBuilder<int, int> builder;
+    ASSERT_TRUE(builder.Open(file.path()));
+    ASSERT_TRUE(builder.Add(1, 2));
+    ASSERT_TRUE(builder.Finish());
+  }
+  ASSERT_TRUE(reader.Open(file.path()));
+  int value = 0;
+  auto find_status = reader.Find(1, &value);
+  ASSERT_TRUE(find_status);
+  EXPECT_TRUE(find_status.get());
+  EXPECT_EQ(2, value);
+  reader.Close();
+
+  struct stat file_stat;
+  ASSERT_EQ(0, ::stat(file.path().c_str(), &file_stat));
+  ASSERT_EQ(0, ::truncate(file.path().c_str(), file_stat.st_size - 1));
+  status = reader.Open(file.path());
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ProtocolError, status.error());
+}
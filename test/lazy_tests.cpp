@@ -0,0 +1,267 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/table.h>
+#include <nop/types/lazy.h>
+#include <nop/utility/bounded_reader.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/pedantic_buffer_reader.h>
+
+#include "test_reader.h"
+#include "test_utilities.h"
+#include "test_writer.h"
+
+using nop::BufferReader;
+using nop::Compose;
+using nop::Deserializer;
+using nop::Encode;
+using nop::EncodingByte;
+using nop::Entry;
+using nop::ErrorStatus;
+using nop::IsContiguousReader;
+using nop::Lazy;
+using nop::PedanticBufferReader;
+using nop::SkipValue;
+using nop::TestReader;
+
+namespace {
+
+struct Message {
+  std::uint32_t id;
+  Lazy<std::vector<std::string>> names;
+  std::string label;
+
+  NOP_STRUCTURE(Message, id, names, label);
+};
+
+struct EagerMessage {
+  std::uint32_t id;
+  std::vector<std::string> names;
+  std::string label;
+
+  NOP_STRUCTURE(EagerMessage, id, names, label);
+};
+
+struct TableMessage {
+  Entry<int, 0> a;
+  Entry<Lazy<std::vector<std::string>>, 1> b;
+
+  NOP_TABLE_NS("TableMessage", TableMessage, a, b);
+};
+
+}  // anonymous namespace
+
+TEST(Lazy, Traits) {
+  EXPECT_TRUE(IsContiguousReader<BufferReader>::value);
+  EXPECT_TRUE(IsContiguousReader<PedanticBufferReader>::value);
+  EXPECT_TRUE(IsContiguousReader<nop::BoundedReader<BufferReader>>::value);
+  EXPECT_FALSE(IsContiguousReader<TestReader>::value);
+  EXPECT_FALSE(IsContiguousReader<nop::BoundedReader<TestReader>>::value);
+}
+
+TEST(Lazy, Basic) {
+  {
+    Lazy<std::string> value;
+    EXPECT_FALSE(value.is_encoded());
+    EXPECT_TRUE(value.is_decoded());
+
+    auto status = value.get();
+    ASSERT_TRUE(status);
+    EXPECT_EQ("", *status.get());
+  }
+
+  {
+    Lazy<std::string> value{"foo"};
+    auto status = value.get();
+    ASSERT_TRUE(status);
+    EXPECT_EQ("foo", *status.get());
+
+    value = std::string{"bar"};
+    status = value.get();
+    ASSERT_TRUE(status);
+    EXPECT_EQ("bar", *status.get());
+
+    auto take_status = value.take();
+    ASSERT_TRUE(take_status);
+    EXPECT_EQ("bar", take_status.get());
+  }
+}
+
+TEST(Lazy, DeferredRead) {
+  const EagerMessage eager{10, {"foo", "bar", "baz"}, "label"};
+  const std::vector<std::uint8_t> buffer = Encode(eager);
+
+  Message message;
+  Deserializer<BufferReader> deserializer{buffer.data(), buffer.size()};
+  ASSERT_TRUE(deserializer.Read(&message));
+  EXPECT_TRUE(deserializer.reader().empty());
+
+  EXPECT_EQ(10u, message.id);
+  EXPECT_EQ("label", message.label);
+  EXPECT_TRUE(message.names.is_encoded());
+  EXPECT_FALSE(message.names.is_decoded());
+
+  // The recorded payload points into the original buffer.
+  EXPECT_GT(message.names.encoded_data(), buffer.data());
+  EXPECT_LT(message.names.encoded_data(), buffer.data() + buffer.size());
+
+  auto status = message.names.get();
+  ASSERT_TRUE(status);
+  EXPECT_EQ(eager.names, *status.get());
+  EXPECT_TRUE(message.names.is_encoded());
+  EXPECT_TRUE(message.names.is_decoded());
+}
+
+TEST(Lazy, WriteVerbatim) {
+  const EagerMessage eager{10, {"foo", "bar", "baz"}, "label"};
+  const std::vector<std::uint8_t> buffer = Encode(eager);
+
+  Message message;
+  Deserializer<BufferReader> deserializer{buffer.data(), buffer.size()};
+  ASSERT_TRUE(deserializer.Read(&message));
+
+  // Unmodified values are written from the recorded bytes, before and after
+  // decoding.
+  EXPECT_EQ(buffer, Encode(message));
+  ASSERT_TRUE(message.names.get());
+  EXPECT_EQ(buffer, Encode(message));
+
+  // Modified values are encoded from the value of type T.
+  auto status = message.names.get_mutable();
+  ASSERT_TRUE(status);
+  EXPECT_FALSE(message.names.is_encoded());
+  status.get()->push_back("qux");
+
+  EagerMessage expected = eager;
+  expected.names.push_back("qux");
+  EXPECT_EQ(Encode(expected), Encode(message));
+}
+
+TEST(Lazy, EagerRead) {
+  const EagerMessage eager{10, {"foo", "bar"}, "label"};
+
+  TestReader reader;
+  reader.Set(Encode(eager));
+
+  Message message;
+  Deserializer<TestReader*> deserializer{&reader};
+  ASSERT_TRUE(deserializer.Read(&message));
+
+  EXPECT_FALSE(message.names.is_encoded());
+  EXPECT_TRUE(message.names.is_decoded());
+
+  auto status = message.names.get();
+  ASSERT_TRUE(status);
+  EXPECT_EQ(eager.names, *status.get());
+}
+
+TEST(Lazy, TableEntry) {
+  TableMessage table;
+  table.a = 20;
+  table.b = Lazy<std::vector<std::string>>{{"foo", "bar"}};
+  const std::vector<std::uint8_t> buffer = Encode(table);
+
+  TableMessage result;
+  Deserializer<BufferReader> deserializer{buffer.data(), buffer.size()};
+  ASSERT_TRUE(deserializer.Read(&result));
+
+  ASSERT_TRUE(result.a);
+  EXPECT_EQ(20, result.a.get());
+  ASSERT_TRUE(result.b);
+  EXPECT_TRUE(result.b.get().is_encoded());
+
+  auto status = result.b.get().get();
+  ASSERT_TRUE(status);
+  EXPECT_EQ((std::vector<std::string>{"foo", "bar"}), *status.get());
+
+  EXPECT_EQ(buffer, Encode(result));
+}
+
+TEST(Lazy, DeferredError) {
+  // The structure of the array is valid, but the elements are not strings.
+  const std::vector<std::uint8_t> buffer =
+      Compose(EncodingByte::Array, 2, 1, 2);
+
+  Lazy<std::vector<std::string>> value;
+  Deserializer<BufferReader> deserializer{buffer.data(), buffer.size()};
+  ASSERT_TRUE(deserializer.Read(&value));
+  EXPECT_TRUE(value.is_encoded());
+
+  auto status = value.get();
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::UnexpectedEncodingType, status.error());
+
+  // A mismatched prefix is detected during the read.
+  const std::vector<std::uint8_t> string = Compose(EncodingByte::String, 0);
+  Deserializer<BufferReader> string_deserializer{string.data(), string.size()};
+  auto read_status = string_deserializer.Read(&value);
+  ASSERT_FALSE(read_status);
+  EXPECT_EQ(ErrorStatus::UnexpectedEncodingType, read_status.error());
+}
+
+TEST(SkipValue, Structure) {
+  {
+    const std::vector<std::uint8_t> buffer = Compose(
+        EncodingByte::Map, 1, EncodingByte::String, 3, "foo",
+        EncodingByte::Variant, 1, EncodingByte::Array, 2, EncodingByte::Nil,
+        EncodingByte::Table, 0, 1, 5, 3, 1, 2, 3, EncodingByte::Binary, 2, 1, 2,
+        EncodingByte::U16, 1, 2, 7);
+
+    PedanticBufferReader reader{buffer.data(), buffer.size()};
+    ASSERT_TRUE(SkipValue(&reader));
+    ASSERT_TRUE(SkipValue(&reader));
+    ASSERT_TRUE(SkipValue(&reader));
+    ASSERT_TRUE(SkipValue(&reader));
+    EXPECT_TRUE(reader.empty());
+  }
+
+  {
+    const std::vector<std::uint8_t> buffer =
+        Compose(EncodingByte::String, 10, "foo");
+
+    BufferReader reader{buffer.data(), buffer.size()};
+    auto status = SkipValue(&reader);
+    ASSERT_FALSE(status);
+    EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+  }
+
+  {
+    const std::vector<std::uint8_t> buffer = Compose(EncodingByte::Extension);
+
+    BufferReader reader{buffer.data(), buffer.size()};
+    auto status = SkipValue(&reader);
+    ASSERT_FALSE(status);
+    EXPECT_EQ(ErrorStatus::UnexpectedEncodingType, status.error());
+  }
+
+  {
+    std::vector<std::uint8_t> buffer;
+    for (std::size_t i = 0; i < nop::kMaxSkipDepth + 1; i++)
+      nop::Append(&buffer, EncodingByte::Array, 1);
+    nop::Append(&buffer, EncodingByte::Nil);
+
+    BufferReader reader{buffer.data(), buffer.size()};
+    auto status = SkipValue(&reader);
+    ASSERT_FALSE(status);
+    EXPECT_EQ(ErrorStatus::InvalidContainerLength, status.error());
+  }
+}
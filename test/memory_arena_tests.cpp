@@ -0,0 +1,212 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/utility/arena_deserializer.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/memory_arena.h>
+
+#include "test_writer.h"
+
+using nop::ArenaAllocator;
+using nop::ArenaDeserializer;
+using nop::ArenaMap;
+using nop::ArenaScope;
+using nop::ArenaString;
+using nop::ArenaVector;
+using nop::BufferReader;
+using nop::Encode;
+using nop::MemoryArena;
+
+namespace {
+
+struct Item {
+  std::uint32_t id;
+  std::string name;
+  std::vector<std::string> tags;
+
+  NOP_STRUCTURE(Item, id, name, tags);
+};
+
+struct ArenaItem {
+  std::uint32_t id;
+  ArenaString name;
+  ArenaVector<ArenaString> tags;
+
+  NOP_STRUCTURE(ArenaItem, id, name, tags);
+};
+
+struct ArenaRequest {
+  ArenaString method;
+  ArenaVector<ArenaItem> items;
+  ArenaMap<ArenaString, ArenaString> headers;
+  std::array<ArenaString, 2> path;
+
+  NOP_STRUCTURE(ArenaRequest, method, items, headers, path);
+};
+
+struct PlainRequest {
+  std::string method;
+  std::vector<Item> items;
+  std::map<std::string, std::string> headers;
+  std::array<std::string, 2> path;
+
+  NOP_STRUCTURE(PlainRequest, method, items, headers, path);
+};
+
+PlainRequest MakeRequest() {
+  const std::string kLong = "a string long enough to need an allocation";
+  return {"GET " + kLong,
+          {{1, "first " + kLong, {"tag " + kLong, "b"}},
+           {2, "second " + kLong, {}}},
+          {{"host " + kLong, "example " + kLong}},
+          {{"root " + kLong, "leaf " + kLong}}};
+}
+
+}  // anonymous namespace
+
+TEST(MemoryArena, Allocate) {
+  MemoryArena arena{256};
+  EXPECT_EQ(0u, arena.block_count());
+
+  void* a = arena.Allocate(3, 1);
+  void* b = arena.Allocate(8, 8);
+  EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(b) % 8);
+  EXPECT_LT(a, b);
+  EXPECT_EQ(11u, arena.bytes_allocated());
+  EXPECT_EQ(1u, arena.block_count());
+
+  // Allocations larger than the block size get a block of their own.
+  void* c = arena.Allocate(1000, 64);
+  EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(c) % 64);
+  EXPECT_EQ(2u, arena.block_count());
+
+  arena.Allocate(200, 1);
+  arena.Allocate(200, 1);
+  EXPECT_EQ(3u, arena.block_count());
+
+  // Reset keeps one block for reuse.
+  arena.Reset();
+  EXPECT_EQ(0u, arena.bytes_allocated());
+  EXPECT_EQ(1u, arena.block_count());
+  arena.Allocate(100, 1);
+  EXPECT_EQ(1u, arena.block_count());
+}
+
+TEST(MemoryArena, Allocator) {
+  MemoryArena arena;
+
+  // Without an arena the allocator uses the heap.
+  ArenaVector<int> heap{1, 2, 3};
+  EXPECT_EQ(nullptr, heap.get_allocator().arena());
+  EXPECT_EQ(0u, arena.bytes_allocated());
+
+  {
+    ArenaScope scope{&arena};
+    ArenaVector<int> values{1, 2, 3};
+    EXPECT_EQ(&arena, values.get_allocator().arena());
+    EXPECT_EQ(3 * sizeof(int), arena.bytes_allocated());
+
+    // Scopes nest.
+    {
+      ArenaScope inner{nullptr};
+      EXPECT_EQ(nullptr, MemoryArena::current());
+    }
+    EXPECT_EQ(&arena, MemoryArena::current());
+
+    // Copies made outside of a scope live on the heap.
+    ArenaScope outer{nullptr};
+    ArenaVector<int> copy = values;
+    EXPECT_EQ(nullptr, copy.get_allocator().arena());
+    EXPECT_EQ(values, copy);
+
+    // Moves keep the arena.
+    ArenaVector<int> moved = std::move(values);
+    EXPECT_EQ(&arena, moved.get_allocator().arena());
+  }
+  EXPECT_EQ(nullptr, MemoryArena::current());
+}
+
+TEST(MemoryArena, Deserialize) {
+  const PlainRequest expected = MakeRequest();
+  const std::vector<std::uint8_t> buffer = Encode(expected);
+
+  MemoryArena arena;
+  ArenaDeserializer<BufferReader> deserializer{&arena, buffer.data(),
+                                               buffer.size()};
+  auto status = deserializer.Read<ArenaRequest>();
+  ASSERT_TRUE(status);
+  EXPECT_TRUE(deserializer.reader().empty());
+  EXPECT_EQ(nullptr, MemoryArena::current());
+
+  // Every container at every depth allocates from the arena.
+  const ArenaRequest& request = status.get();
+  EXPECT_EQ(&arena, request.method.get_allocator().arena());
+  EXPECT_EQ(&arena, request.items.get_allocator().arena());
+  EXPECT_EQ(&arena, request.headers.get_allocator().arena());
+  EXPECT_EQ(&arena, request.path[1].get_allocator().arena());
+  ASSERT_EQ(2u, request.items.size());
+  EXPECT_EQ(&arena, request.items[0].name.get_allocator().arena());
+  EXPECT_EQ(&arena, request.items[0].tags.get_allocator().arena());
+  ASSERT_EQ(2u, request.items[0].tags.size());
+  EXPECT_EQ(&arena, request.items[0].tags[0].get_allocator().arena());
+
+  EXPECT_EQ(expected.method, request.method.c_str());
+  EXPECT_EQ(expected.items[1].id, request.items[1].id);
+  EXPECT_EQ(expected.items[0].tags[0], request.items[0].tags[0].c_str());
+  EXPECT_EQ(expected.path[0], request.path[0].c_str());
+  ASSERT_EQ(1u, request.headers.size());
+  EXPECT_EQ(expected.headers.begin()->second,
+            request.headers.begin()->second.c_str());
+
+  // The arena values encode to the same bytes.
+  EXPECT_EQ(buffer, Encode(request));
+
+  const std::size_t allocated = arena.bytes_allocated();
+  EXPECT_GT(allocated, 0u);
+
+  // Decoding into an existing value reuses its allocators.
+  ArenaRequest existing;
+  existing.items = ArenaVector<ArenaItem>{ArenaAllocator<ArenaItem>{&arena}};
+  deserializer.reader() = BufferReader{buffer.data(), buffer.size()};
+  ASSERT_TRUE(deserializer.Read(&existing));
+  EXPECT_EQ(&arena, existing.items[1].name.get_allocator().arena());
+  EXPECT_GT(arena.bytes_allocated(), allocated);
+}
+
+TEST(MemoryArena, NestedAllocatorConstruction) {
+  const std::vector<std::uint8_t> buffer =
+      Encode(std::vector<std::vector<std::string>>{{"a", "b"}, {"c"}});
+
+  // Elements of containers decoded outside of an ArenaDeserializer allocate
+  // from their container's allocator.
+  MemoryArena arena;
+  ArenaVector<ArenaVector<ArenaString>> values{
+      ArenaAllocator<ArenaVector<ArenaString>>{&arena}};
+  BufferReader reader{buffer.data(), buffer.size()};
+  ASSERT_TRUE(nop::Encoding<decltype(values)>::Read(&values, &reader));
+  ASSERT_EQ(2u, values.size());
+  EXPECT_EQ(&arena, values[0].get_allocator().arena());
+  EXPECT_EQ(&arena, values[0][1].get_allocator().arena());
+  EXPECT_EQ("c", std::string{values[1][0].c_str()});
+}
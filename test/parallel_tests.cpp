@@ -0,0 +1,283 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/traits/is_parallel_reader.h>
+#include <nop/traits/is_parallel_writer.h>
+#include <nop/utility/batch_decoder.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/buffer_writer.h>
+#include <nop/utility/parallel_buffer_reader.h>
+#include <nop/utility/parallel_buffer_writer.h>
+#include <nop/utility/thread_pool.h>
+
+#include "test_writer.h"
+
+using nop::BatchDecoder;
+using nop::BufferReader;
+using nop::BufferWriter;
+using nop::Deserializer;
+using nop::Encode;
+using nop::ErrorStatus;
+using nop::IsParallelReader;
+using nop::IsParallelWriter;
+using nop::ParallelBufferReader;
+using nop::ParallelBufferWriter;
+using nop::Serializer;
+using nop::Status;
+using nop::ThreadPool;
+
+namespace {
+
+struct Point {
+  int x;
+  std::string label;
+
+  NOP_STRUCTURE(Point, x, label);
+};
+
+bool operator==(const Point& a, const Point& b) {
+  return a.x == b.x && a.label == b.label;
+}
+
+struct Document {
+  std::vector<Point> points;
+  std::map<int, std::string> names;
+  std::unordered_map<std::string, std::vector<int>> groups;
+
+  NOP_STRUCTURE(Document, points, names, groups);
+};
+
+template <typename T>
+std::vector<std::uint8_t> EncodeParallel(const T& value, ThreadPool* pool) {
+  Serializer<ParallelBufferWriter<>> serializer;
+  std::vector<std::uint8_t> buffer(serializer.GetSize(value));
+  serializer.writer() =
+      ParallelBufferWriter<>{buffer.data(), buffer.size(), pool};
+  EXPECT_TRUE(serializer.Write(value));
+  buffer.resize(serializer.writer().size());
+  return buffer;
+}
+
+Document MakeDocument(std::size_t count) {
+  Document document;
+  for (std::size_t i = 0; i < count; i++) {
+    const int value = static_cast<int>(i);
+    // Vary the element sizes so that the task regions differ in size.
+    document.points.push_back({value * 1000, std::string(i % 7, 'a')});
+    document.names[value] = std::to_string(i);
+    document.groups[std::to_string(i)] = std::vector<int>(i % 3, value);
+  }
+  return document;
+}
+
+}  // anonymous namespace
+
+TEST(Parallel, Traits) {
+  EXPECT_TRUE(IsParallelWriter<ParallelBufferWriter<>>::value);
+  EXPECT_FALSE(IsParallelWriter<BufferWriter>::value);
+  EXPECT_TRUE(IsParallelReader<ParallelBufferReader<>>::value);
+  EXPECT_FALSE(IsParallelReader<BufferReader>::value);
+}
+
+TEST(Parallel, ThreadPool) {
+  ThreadPool pool{3};
+  EXPECT_EQ(4u, pool.concurrency());
+
+  for (std::size_t count : {0u, 1u, 5u, 1000u}) {
+    std::vector<std::atomic<int>> calls(count);
+    for (auto& call : calls)
+      call = 0;
+
+    pool.ParallelFor(count, [&](std::size_t i) { calls[i]++; });
+    for (std::size_t i = 0; i < count; i++)
+      EXPECT_EQ(1, calls[i]) << "count=" << count << " i=" << i;
+  }
+
+  // A pool without worker threads runs everything on the calling thread.
+  ThreadPool inline_pool{0};
+  EXPECT_EQ(1u, inline_pool.concurrency());
+  std::size_t sum = 0;
+  inline_pool.ParallelFor(100, [&](std::size_t i) { sum += i; });
+  EXPECT_EQ(4950u, sum);
+}
+
+TEST(Parallel, Identical) {
+  ThreadPool pool{3};
+
+  // Small containers take the sequential path; large ones are divided into
+  // tasks. Both must produce the same bytes as BufferWriter.
+  for (std::size_t count : {0u, 10u, 5000u, 50000u}) {
+    const Document document = MakeDocument(count);
+    EXPECT_EQ(Encode(document), EncodeParallel(document, &pool))
+        << "count=" << count;
+  }
+
+  // Parallel writers without an executor write sequentially.
+  const Document document = MakeDocument(5000);
+  Serializer<ParallelBufferWriter<>> serializer;
+  std::vector<std::uint8_t> buffer(serializer.GetSize(document));
+  serializer.writer() =
+      ParallelBufferWriter<>{buffer.data(), buffer.size(), nullptr};
+  EXPECT_TRUE(serializer.Write(document));
+  EXPECT_EQ(Encode(document), buffer);
+}
+
+TEST(Parallel, WriteLimit) {
+  ThreadPool pool{3};
+  const std::vector<Point> points = MakeDocument(50000).points;
+
+  std::vector<std::uint8_t> buffer(Encode(points).size() - 1);
+  ParallelBufferWriter<> writer{buffer.data(), buffer.size(), &pool};
+  Status<void> status =
+      nop::Encoding<std::vector<Point>>::Write(points, &writer);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::WriteLimitReached, status.error());
+}
+
+TEST(Parallel, Read) {
+  ThreadPool pool{3};
+
+  for (std::size_t count : {0u, 10u, 5000u, 50000u}) {
+    const std::vector<Point> expected = MakeDocument(count).points;
+    const std::vector<std::uint8_t> buffer = Encode(expected);
+
+    // Existing contents are replaced.
+    std::vector<Point> points{{1, "stale"}};
+    Deserializer<ParallelBufferReader<>> deserializer{buffer.data(),
+                                                      buffer.size(), &pool};
+    ASSERT_TRUE(deserializer.Read(&points)) << "count=" << count;
+    EXPECT_TRUE(deserializer.reader().empty());
+    EXPECT_EQ(expected, points) << "count=" << count;
+  }
+}
+
+TEST(Parallel, ReadErrors) {
+  ThreadPool pool{3};
+  const std::vector<Point> expected = MakeDocument(50000).points;
+  std::vector<std::uint8_t> buffer = Encode(expected);
+  std::vector<Point> points;
+  Status<void> status;
+
+  // Truncation is detected by the scan before the vector is resized.
+  {
+    Deserializer<ParallelBufferReader<>> deserializer{
+        buffer.data(), buffer.size() - 1, &pool};
+    status = deserializer.Read(&points);
+    ASSERT_FALSE(status);
+    EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+    EXPECT_TRUE(points.empty());
+  }
+
+  // Elements that are structurally valid but of the wrong type are detected by
+  // the task that decodes them.
+  {
+    std::vector<std::string> strings(50000, "string");
+    buffer = Encode(strings);
+    Deserializer<ParallelBufferReader<>> deserializer{buffer.data(),
+                                                      buffer.size(), &pool};
+    status = deserializer.Read(&points);
+    ASSERT_FALSE(status);
+    EXPECT_EQ(ErrorStatus::UnexpectedEncodingType, status.error());
+  }
+}
+
+TEST(Parallel, BatchDecoder) {
+  ThreadPool pool{3};
+  BatchDecoder<> decoder{&pool};
+
+  const std::vector<Point> expected = MakeDocument(1000).points;
+  std::size_t size = 0;
+  for (const Point& point : expected)
+    size += nop::FrameSize(point);
+
+  std::vector<std::uint8_t> buffer(size);
+  BufferWriter writer{buffer.data(), buffer.size()};
+  for (const Point& point : expected)
+    ASSERT_TRUE(nop::WriteFrame(point, &writer));
+  ASSERT_EQ(size, writer.size());
+
+  // Decode in batches limited by the number of slots, leaving a partial frame
+  // at the end of the available data for the next call.
+  std::vector<Point> points;
+  std::vector<Point> slots(300);
+  std::size_t offset = 0;
+  std::size_t available = size - 1;
+  while (points.size() < expected.size()) {
+    auto status = decoder.Decode(buffer.data() + offset, available - offset,
+                                 slots.data(), slots.size());
+    ASSERT_TRUE(status);
+    if (status.get().records == 0) {
+      ASSERT_EQ(size - 1, available);
+      available = size;
+      continue;
+    }
+
+    points.insert(points.end(), slots.begin(),
+                  slots.begin() + status.get().records);
+    offset += status.get().bytes;
+  }
+  EXPECT_EQ(size, offset);
+  EXPECT_EQ(expected, points);
+
+  auto stats = decoder.stats();
+  EXPECT_EQ(1000u, stats.records);
+  EXPECT_EQ(size, stats.bytes);
+  // Three full batches, one ending at the partial frame, one empty batch, and
+  // the final frame.
+  EXPECT_EQ(6u, stats.batches);
+  EXPECT_EQ(0u, stats.errors);
+  EXPECT_EQ(0u, stats.queue_depth);
+
+  // A frame whose contents do not match the record type fails the batch.
+  buffer.resize(nop::FrameSize(expected[0]) + nop::FrameSize(1));
+  writer = BufferWriter{buffer.data(), buffer.size()};
+  ASSERT_TRUE(nop::WriteFrame(expected[0], &writer));
+  ASSERT_TRUE(nop::WriteFrame(1, &writer));
+  auto status = decoder.Decode(buffer.data(), buffer.size(), slots.data(),
+                               slots.size());
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::UnexpectedEncodingType, status.error());
+  EXPECT_EQ(1u, decoder.stats().errors);
+
+  // Padding after a record fills out its frame, as written for encodings that
+  // overestimate their size.
+  const std::size_t kPadding = 3;
+  buffer.clear();
+  for (std::size_t i = 0; i < 2; i++) {
+    const std::vector<std::uint8_t> record = Encode(expected[i]);
+    ASSERT_GT(128u, record.size() + kPadding);
+    buffer.push_back(static_cast<std::uint8_t>(record.size() + kPadding));
+    buffer.insert(buffer.end(), record.begin(), record.end());
+    buffer.insert(buffer.end(), kPadding, 0);
+  }
+  status =
+      decoder.Decode(buffer.data(), buffer.size(), slots.data(), slots.size());
+  ASSERT_TRUE(status);
+  EXPECT_EQ(2u, status.get().records);
+  EXPECT_EQ(buffer.size(), status.get().bytes);
+  EXPECT_EQ(expected[0], slots[0]);
+  EXPECT_EQ(expected[1], slots[1]);
+}
@@ -0,0 +1,216 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/types/raw_value.h>
+#include <nop/types/variant.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/buffer_writer.h>
+
+#include "test_reader.h"
+#include "test_utilities.h"
+#include "test_writer.h"
+
+using nop::BufferReader;
+using nop::BufferWriter;
+using nop::Compose;
+using nop::Deserializer;
+using nop::Encode;
+using nop::EncodingByte;
+using nop::ErrorStatus;
+using nop::RawValue;
+using nop::TestReader;
+using nop::Variant;
+
+namespace {
+
+struct Payload {
+  std::string name;
+  std::vector<std::uint32_t> values;
+
+  NOP_STRUCTURE(Payload, name, values);
+};
+
+struct Envelope {
+  std::string destination;
+  RawValue payload;
+  std::uint32_t ttl;
+
+  NOP_STRUCTURE(Envelope, destination, payload, ttl);
+};
+
+struct TypedEnvelope {
+  std::string destination;
+  Payload payload;
+  std::uint32_t ttl;
+
+  NOP_STRUCTURE(TypedEnvelope, destination, payload, ttl);
+};
+
+}  // anonymous namespace
+
+TEST(RawValue, Basic) {
+  RawValue empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_TRUE(empty.owned());
+
+  const std::vector<std::uint8_t> bytes =
+      Compose(EncodingByte::String, 3, "foo");
+  RawValue borrowed = RawValue::Borrow(bytes.data(), bytes.size());
+  EXPECT_FALSE(borrowed.empty());
+  EXPECT_FALSE(borrowed.owned());
+  EXPECT_EQ(bytes.data(), borrowed.data());
+
+  RawValue copy = borrowed;
+  EXPECT_FALSE(copy.owned());
+  EXPECT_EQ(bytes.data(), copy.data());
+
+  copy.own();
+  EXPECT_TRUE(copy.owned());
+  EXPECT_NE(bytes.data(), copy.data());
+  EXPECT_EQ(bytes, std::vector<std::uint8_t>(copy.data(),
+                                             copy.data() + copy.size()));
+
+  RawValue owned_copy = copy;
+  EXPECT_TRUE(owned_copy.owned());
+  EXPECT_NE(copy.data(), owned_copy.data());
+
+  RawValue moved = std::move(owned_copy);
+  EXPECT_TRUE(moved.owned());
+  EXPECT_TRUE(owned_copy.empty());
+  EXPECT_EQ(bytes.size(), moved.size());
+}
+
+TEST(RawValue, Forward) {
+  const TypedEnvelope typed{"dest", {"foo", {1, 2, 3}}, 10};
+  const std::vector<std::uint8_t> buffer = Encode(typed);
+  const std::vector<std::uint8_t> payload_bytes = Encode(typed.payload);
+
+  // Contiguous readers borrow the encoded bytes.
+  {
+    Envelope envelope;
+    Deserializer<BufferReader> deserializer{buffer.data(), buffer.size()};
+    ASSERT_TRUE(deserializer.Read(&envelope));
+    EXPECT_TRUE(deserializer.reader().empty());
+
+    EXPECT_EQ("dest", envelope.destination);
+    EXPECT_EQ(10u, envelope.ttl);
+    EXPECT_FALSE(envelope.payload.owned());
+    EXPECT_EQ(payload_bytes,
+              std::vector<std::uint8_t>(
+                  envelope.payload.data(),
+                  envelope.payload.data() + envelope.payload.size()));
+
+    EXPECT_EQ(buffer, Encode(envelope));
+  }
+
+  // Other readers copy the encoded bytes.
+  {
+    TestReader reader;
+    reader.Set(buffer);
+
+    Envelope envelope;
+    Deserializer<TestReader*> deserializer{&reader};
+    ASSERT_TRUE(deserializer.Read(&envelope));
+
+    EXPECT_TRUE(envelope.payload.owned());
+    EXPECT_EQ(buffer, Encode(envelope));
+  }
+
+  // The forwarded bytes decode as the original type.
+  {
+    Envelope envelope;
+    Deserializer<BufferReader> deserializer{buffer.data(), buffer.size()};
+    ASSERT_TRUE(deserializer.Read(&envelope));
+
+    Payload payload;
+    Deserializer<BufferReader> payload_deserializer{envelope.payload.data(),
+                                                    envelope.payload.size()};
+    ASSERT_TRUE(payload_deserializer.Read(&payload));
+    EXPECT_EQ(typed.payload.name, payload.name);
+    EXPECT_EQ(typed.payload.values, payload.values);
+  }
+}
+
+TEST(RawValue, Containers) {
+  {
+    const std::tuple<int, std::string> value{10, "foo"};
+    const std::vector<std::uint8_t> buffer = Encode(value);
+
+    std::tuple<RawValue, RawValue> raw;
+    Deserializer<BufferReader> deserializer{buffer.data(), buffer.size()};
+    ASSERT_TRUE(deserializer.Read(&raw));
+    EXPECT_EQ(1u, std::get<0>(raw).size());
+    EXPECT_EQ(Encode(std::string{"foo"}).size(), std::get<1>(raw).size());
+    EXPECT_EQ(buffer, Encode(raw));
+  }
+
+  {
+    const Variant<int, std::vector<std::string>> value{
+        std::vector<std::string>{"foo", "bar"}};
+    const std::vector<std::uint8_t> buffer = Encode(value);
+
+    Variant<int, RawValue> raw;
+    Deserializer<BufferReader> deserializer{buffer.data(), buffer.size()};
+    ASSERT_TRUE(deserializer.Read(&raw));
+    ASSERT_TRUE(raw.is<RawValue>());
+    EXPECT_EQ(buffer, Encode(raw));
+  }
+
+  {
+    const std::vector<std::uint8_t> expected = Compose(
+        EncodingByte::Array, 2, EncodingByte::Nil, EncodingByte::String, 3,
+        "foo");
+    const std::vector<std::uint8_t> foo =
+        Compose(EncodingByte::String, 3, "foo");
+    const std::vector<RawValue> value{RawValue{},
+                                      RawValue{foo.data(), foo.size()}};
+    EXPECT_EQ(expected, Encode(value));
+  }
+}
+
+TEST(RawValue, Errors) {
+  {
+    const std::vector<std::uint8_t> buffer =
+        Compose(EncodingByte::Extension, 0);
+
+    RawValue value;
+    Deserializer<BufferReader> deserializer{buffer.data(), buffer.size()};
+    auto status = deserializer.Read(&value);
+    ASSERT_FALSE(status);
+    EXPECT_EQ(ErrorStatus::UnexpectedEncodingType, status.error());
+  }
+
+  {
+    const std::vector<std::uint8_t> buffer =
+        Compose(EncodingByte::Array, 2, EncodingByte::Nil);
+
+    TestReader reader;
+    reader.Set(buffer);
+
+    RawValue value;
+    Deserializer<TestReader*> deserializer{&reader};
+    auto status = deserializer.Read(&value);
+    ASSERT_FALSE(status);
+    EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+  }
+}
@@ -0,0 +1,272 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/types/raw_value.h>
+#include <nop/utility/record_log.h>
+
+#include "test_utilities.h"
+
+using nop::ErrorStatus;
+using nop::LogRecord;
+using nop::RawValue;
+using nop::RecordLogReader;
+using nop::RecordLogWriter;
+using nop::Status;
+using nop::TempFile;
+
+namespace {
+
+struct Event {
+  std::uint64_t id;
+  std::string name;
+
+  NOP_STRUCTURE(Event, id, name);
+};
+
+Event MakeEvent(std::uint64_t id) {
+  return {id, "event" + std::to_string(id)};
+}
+
+// Writes events with ids [begin, end) and timestamps 10 * id.
+void AppendEvents(RecordLogWriter* writer, std::uint64_t begin,
+                  std::uint64_t end) {
+  for (std::uint64_t id = begin; id < end; id++)
+    ASSERT_TRUE(writer->Append(MakeEvent(id), id * 10));
+}
+
+void ExpectEvents(RecordLogReader* reader, std::uint64_t begin,
+                  std::uint64_t end) {
+  for (std::uint64_t id = begin; id < end; id++) {
+    Event event;
+    std::uint64_t timestamp;
+    ASSERT_TRUE(reader->Read(&event, &timestamp)) << "id=" << id;
+    EXPECT_EQ(id, event.id);
+    EXPECT_EQ("event" + std::to_string(id), event.name);
+    EXPECT_EQ(id * 10, timestamp);
+  }
+}
+
+std::vector<std::uint8_t> ReadBytes(const std::string& path) {
+  std::vector<std::uint8_t> bytes;
+  FILE* f = std::fopen(path.c_str(), "rb");
+  EXPECT_NE(nullptr, f);
+  if (f == nullptr)
+    return bytes;
+  std::uint8_t byte;
+  while (std::fread(&byte, 1, 1, f) == 1)
+    bytes.push_back(byte);
+  std::fclose(f);
+  return bytes;
+}
+
+}  // anonymous namespace
+
+TEST(RecordLog, WriteRead) {
+  TempFile file{"record_log_tests"};
+  {
+    RecordLogWriter writer{256};
+    ASSERT_TRUE(writer.Open(file.path()));
+    AppendEvents(&writer, 0, 1000);
+    EXPECT_EQ(1000u, writer.record_count());
+    ASSERT_TRUE(writer.Close());
+  }
+
+  RecordLogReader reader;
+  ASSERT_TRUE(reader.Open(file.path()));
+  EXPECT_EQ(1000u, reader.record_count());
+  EXPECT_FALSE(reader.torn());
+  ExpectEvents(&reader, 0, 1000);
+
+  Event event;
+  Status<void> status = reader.Read(&event);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+
+  // Payloads are read in place from the mapping.
+  ASSERT_TRUE(reader.Seek(0));
+  auto record_status = reader.Next();
+  ASSERT_TRUE(record_status);
+  RawValue raw;
+  ASSERT_TRUE(reader.Seek(0));
+  ASSERT_TRUE(reader.Read(&raw));
+  EXPECT_FALSE(raw.owned());
+  EXPECT_EQ(record_status.get().data, raw.data());
+}
+
+TEST(RecordLog, Seek) {
+  TempFile file{"record_log_tests"};
+  {
+    RecordLogWriter writer;
+    ASSERT_TRUE(writer.Open(file.path()));
+    AppendEvents(&writer, 0, 1000);
+    ASSERT_TRUE(writer.Close());
+  }
+
+  RecordLogReader reader;
+  ASSERT_TRUE(reader.Open(file.path()));
+
+  for (std::uint64_t index : {0u, 1u, 63u, 64u, 65u, 500u, 999u}) {
+    ASSERT_TRUE(reader.Seek(index));
+    EXPECT_EQ(index, reader.position());
+    ExpectEvents(&reader, index, index + 1);
+  }
+
+  ASSERT_TRUE(reader.Seek(1000));
+  EXPECT_FALSE(reader.Next());
+  EXPECT_FALSE(reader.Seek(1001));
+
+  // Timestamps are 10 * id.
+  ASSERT_TRUE(reader.SeekTimestamp(0));
+  EXPECT_EQ(0u, reader.position());
+  ASSERT_TRUE(reader.SeekTimestamp(640));
+  EXPECT_EQ(64u, reader.position());
+  ASSERT_TRUE(reader.SeekTimestamp(641));
+  EXPECT_EQ(65u, reader.position());
+  ASSERT_TRUE(reader.SeekTimestamp(6395));
+  EXPECT_EQ(640u, reader.position());
+  ExpectEvents(&reader, 640, 1000);
+  ASSERT_TRUE(reader.SeekTimestamp(100000));
+  EXPECT_EQ(1000u, reader.position());
+}
+
+TEST(RecordLog, TornTail) {
+  TempFile file{"record_log_tests"};
+  {
+    RecordLogWriter writer;
+    ASSERT_TRUE(writer.Open(file.path()));
+    AppendEvents(&writer, 0, 100);
+    ASSERT_TRUE(writer.Close());
+  }
+
+  // Simulate a crash during the last write by removing the footer and cutting
+  // the last record short.
+  {
+    RecordLogReader reader;
+    ASSERT_TRUE(reader.Open(file.path()));
+    EXPECT_EQ(100u, reader.record_count());
+    ASSERT_EQ(0, ::truncate(file.path().c_str(), reader.valid_size() - 3));
+  }
+
+  RecordLogReader reader;
+  ASSERT_TRUE(reader.Open(file.path()));
+  EXPECT_TRUE(reader.torn());
+  EXPECT_EQ(99u, reader.record_count());
+  ExpectEvents(&reader, 0, 99);
+  ASSERT_TRUE(reader.Seek(80));
+  ExpectEvents(&reader, 80, 99);
+
+  // Reopening the log drops the torn record and continues after the last
+  // valid one.
+  {
+    RecordLogWriter writer;
+    ASSERT_TRUE(writer.Open(file.path()));
+    EXPECT_EQ(99u, writer.record_count());
+    AppendEvents(&writer, 99, 200);
+    ASSERT_TRUE(writer.Close());
+  }
+
+  ASSERT_TRUE(reader.Open(file.path()));
+  EXPECT_FALSE(reader.torn());
+  EXPECT_EQ(200u, reader.record_count());
+  ExpectEvents(&reader, 0, 200);
+
+  // Reopening a closed log replaces the footer.
+  {
+    RecordLogWriter writer;
+    ASSERT_TRUE(writer.Open(file.path()));
+    AppendEvents(&writer, 200, 300);
+    ASSERT_TRUE(writer.Close());
+  }
+
+  ASSERT_TRUE(reader.Open(file.path()));
+  EXPECT_EQ(300u, reader.record_count());
+  ASSERT_TRUE(reader.Seek(250));
+  ExpectEvents(&reader, 250, 300);
+}
+
+TEST(RecordLog, Errors) {
+  RecordLogReader reader;
+  Status<void> status = reader.Open("/nonexistent/record_log");
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::IOError, status.error());
+
+  const std::uint8_t garbage[16] = {1, 2, 3};
+  status = reader.Open(garbage, sizeof(garbage));
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ProtocolError, status.error());
+
+  // A corrupted record is detected by its checksum when the index comes from
+  // the footer.
+  TempFile file{"record_log_tests"};
+  {
+    RecordLogWriter writer;
+    ASSERT_TRUE(writer.Open(file.path()));
+    AppendEvents(&writer, 0, 10);
+    ASSERT_TRUE(writer.Close());
+  }
+
+  // Flip the last payload byte of the last record.
+  ASSERT_TRUE(reader.Open(file.path()));
+  const std::size_t offset = reader.valid_size() - 1;
+  reader.Close();
+
+  std::vector<std::uint8_t> bytes = ReadBytes(file.path());
+  ASSERT_LT(offset, bytes.size());
+  bytes[offset] ^= 0xff;
+
+  ASSERT_TRUE(reader.Open(bytes.data(), bytes.size()));
+  EXPECT_EQ(10u, reader.record_count());
+  ExpectEvents(&reader, 0, 9);
+  Event event;
+  status = reader.Read(&event);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ProtocolError, status.error());
+}
+
+TEST(RecordLog, ByteOrder) {
+  TempFile file{"record_log_tests"};
+  {
+    RecordLogWriter writer;
+    ASSERT_TRUE(writer.Open(file.path()));
+    ASSERT_TRUE(writer.Append(MakeEvent(1), 0x0102030405060708ULL));
+    ASSERT_TRUE(writer.Close());
+  }
+
+  // Fields are little-endian regardless of the host byte order: the magic
+  // numbers spell out their names and the record timestamp starts with its
+  // least significant byte.
+  const std::vector<std::uint8_t> bytes = ReadBytes(file.path());
+  ASSERT_LE(44u, bytes.size());
+  EXPECT_EQ("NOPLOG01", std::string(bytes.begin(), bytes.begin() + 8));
+  EXPECT_EQ("NLOGSYNC", std::string(bytes.begin() + 8, bytes.begin() + 16));
+  EXPECT_EQ("NLOGINDX", std::string(bytes.end() - 8, bytes.end()));
+
+  // The record header follows the file header and the first sync block.
+  const std::vector<std::uint8_t> timestamp{0x08, 0x07, 0x06, 0x05,
+                                            0x04, 0x03, 0x02, 0x01};
+  EXPECT_EQ(timestamp,
+            std::vector<std::uint8_t>(bytes.begin() + 36, bytes.begin() + 44));
+}
@@ -0,0 +1,385 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <nop/base/value_scanner.h>
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/table.h>
+#include <nop/types/variant.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/resumable_deserializer.h>
+#include <nop/utility/resumable_serializer.h>
+
+#include "test_utilities.h"
+#include "test_writer.h"
+
+using nop::BufferReader;
+using nop::Compose;
+using nop::Encode;
+using nop::EncodingByte;
+using nop::Entry;
+using nop::ErrorStatus;
+using nop::ResumableDeserializer;
+using nop::ResumableSerializer;
+using nop::SkipValue;
+using nop::ValueScanner;
+using nop::Variant;
+
+namespace {
+
+struct Record {
+  Entry<std::string, 0> name;
+  Entry<std::vector<int>, 1> values;
+
+  NOP_TABLE_NS("Record", Record, name, values);
+};
+
+struct Message {
+  std::uint32_t id;
+  std::string label;
+  std::vector<std::vector<int>> values;
+  std::map<std::string, Variant<int, std::string>> attributes;
+  Record record;
+
+  NOP_STRUCTURE(Message, id, label, values, attributes, record);
+};
+
+Message MakeMessage(std::uint32_t id) {
+  Message message;
+  message.id = id;
+  message.label = "message " + std::to_string(id);
+  message.values = {{1, 2, 3}, {}, {100000, -1}};
+  message.attributes["foo"] = 10;
+  message.attributes["bar"] = std::string{"baz"};
+  message.record.name = "record";
+  message.record.values = std::vector<int>{4, 5, 6};
+  return message;
+}
+
+}  // anonymous namespace
+
+TEST(ValueScanner, MatchesSkipValue) {
+  const std::vector<std::vector<std::uint8_t>> values = {
+      Encode(MakeMessage(1)),
+      Compose(EncodingByte::Map, 1, EncodingByte::String, 3, "foo",
+              EncodingByte::Variant, 1, EncodingByte::Array, 2,
+              EncodingByte::Nil, EncodingByte::U16, 1, 2),
+      Compose(EncodingByte::Table, 0, 1, 5, 3, 1, 2, 3),
+      Compose(EncodingByte::Handle, 1, EncodingByte::I64, 1, 2, 3, 4, 5, 6, 7,
+              8),
+      Compose(EncodingByte::Error, EncodingByte::Array, 0),
+      Compose(EncodingByte::F64, 1, 2, 3, 4, 5, 6, 7, 8),
+      Compose(EncodingByte::Binary, 0),
+      Compose(10),
+  };
+
+  for (const auto& value : values) {
+    std::vector<std::uint8_t> stream = value;
+    stream.push_back(0xff);
+
+    BufferReader reader{stream.data(), stream.size()};
+    ASSERT_TRUE(SkipValue(&reader));
+    const std::size_t expected = stream.size() - reader.remaining();
+    EXPECT_EQ(value.size(), expected);
+
+    // Scan in one piece.
+    ValueScanner scanner;
+    auto status = scanner.Scan(stream.data(), stream.size());
+    ASSERT_TRUE(status);
+    EXPECT_TRUE(scanner.done());
+    EXPECT_EQ(expected, status.get());
+
+    // Scan one byte at a time.
+    scanner.Reset();
+    std::size_t consumed = 0;
+    while (!scanner.done()) {
+      ASSERT_LT(consumed, stream.size());
+      status = scanner.Scan(&stream[consumed], 1);
+      ASSERT_TRUE(status);
+      consumed += status.get();
+    }
+    EXPECT_EQ(expected, consumed);
+  }
+}
+
+TEST(ValueScanner, Errors) {
+  ValueScanner scanner;
+  std::vector<std::uint8_t> buffer = Compose(EncodingByte::Extension);
+  auto status = scanner.Scan(buffer.data(), buffer.size());
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::UnexpectedEncodingType, status.error());
+
+  // Container lengths must be unsigned.
+  scanner.Reset();
+  buffer = Compose(EncodingByte::Array, EncodingByte::I8, 1);
+  status = scanner.Scan(buffer.data(), buffer.size());
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::UnexpectedEncodingType, status.error());
+
+  scanner.Reset();
+  buffer.clear();
+  for (std::size_t i = 0; i < nop::kMaxSkipDepth + 1; i++)
+    nop::Append(&buffer, EncodingByte::Array, 1);
+  status = scanner.Scan(buffer.data(), buffer.size());
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::InvalidContainerLength, status.error());
+}
+
+TEST(ResumableDeserializer, Pieces) {
+  const Message expected = MakeMessage(1);
+  const std::vector<std::uint8_t> buffer = Encode(expected);
+
+  ResumableDeserializer deserializer;
+  Message message;
+  for (std::size_t i = 0; i < buffer.size(); i++) {
+    auto status = deserializer.Read(&message);
+    ASSERT_FALSE(status);
+    EXPECT_EQ(ErrorStatus::WouldBlock, status.error());
+    EXPECT_FALSE(deserializer.ready());
+
+    ASSERT_TRUE(deserializer.Feed(&buffer[i], 1));
+  }
+
+  EXPECT_TRUE(deserializer.ready());
+  ASSERT_TRUE(deserializer.Read(&message));
+  EXPECT_EQ(Encode(expected), Encode(message));
+  EXPECT_EQ(0u, deserializer.buffered());
+}
+
+TEST(ResumableDeserializer, MultipleValues) {
+  std::vector<std::uint8_t> stream;
+  for (std::uint32_t id = 0; id < 3; id++) {
+    const std::vector<std::uint8_t> buffer = Encode(MakeMessage(id));
+    stream.insert(stream.end(), buffer.begin(), buffer.end());
+  }
+
+  // Deliver the stream in pieces that do not line up with value boundaries.
+  ResumableDeserializer deserializer;
+  std::vector<Message> messages;
+  const std::size_t kPieceSize = 7;
+  for (std::size_t offset = 0; offset < stream.size(); offset += kPieceSize) {
+    const std::size_t size = std::min(kPieceSize, stream.size() - offset);
+    ASSERT_TRUE(deserializer.Feed(&stream[offset], size));
+
+    Message message;
+    while (deserializer.Read(&message))
+      messages.push_back(message);
+  }
+
+  ASSERT_EQ(3u, messages.size());
+  for (std::uint32_t id = 0; id < 3; id++)
+    EXPECT_EQ(Encode(MakeMessage(id)), Encode(messages[id]));
+}
+
+TEST(ResumableDeserializer, Errors) {
+  {
+    // A type error only affects the value it occurs in.
+    ResumableDeserializer deserializer;
+    const std::vector<std::uint8_t> buffer =
+        Compose(EncodingByte::String, 3, "foo", 10);
+    ASSERT_TRUE(deserializer.Feed(buffer.data(), buffer.size()));
+
+    int value = 0;
+    auto status = deserializer.Read(&value);
+    ASSERT_FALSE(status);
+    EXPECT_EQ(ErrorStatus::UnexpectedEncodingType, status.error());
+
+    ASSERT_TRUE(deserializer.Read(&value));
+    EXPECT_EQ(10, value);
+  }
+
+  {
+    // Structural errors are sticky.
+    ResumableDeserializer deserializer;
+    const std::vector<std::uint8_t> buffer = Compose(EncodingByte::Extension);
+    auto status = deserializer.Feed(buffer.data(), buffer.size());
+    ASSERT_FALSE(status);
+    EXPECT_EQ(ErrorStatus::UnexpectedEncodingType, status.error());
+
+    const std::vector<std::uint8_t> value = Compose(10);
+    status = deserializer.Feed(value.data(), value.size());
+    ASSERT_FALSE(status);
+    EXPECT_EQ(ErrorStatus::UnexpectedEncodingType, status.error());
+
+    deserializer.Reset();
+    ASSERT_TRUE(deserializer.Feed(value.data(), value.size()));
+    EXPECT_TRUE(deserializer.ready());
+  }
+
+  {
+    ResumableDeserializer deserializer{8};
+    const std::vector<std::uint8_t> buffer =
+        Compose(EncodingByte::String, 10, "0123456789");
+    auto status = deserializer.Feed(buffer.data(), buffer.size());
+    ASSERT_FALSE(status);
+    EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+  }
+}
+
+TEST(ResumableDeserializer, ReadFrom) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  ASSERT_EQ(0, fcntl(fds[0], F_SETFL, O_NONBLOCK));
+
+  const Message expected = MakeMessage(5);
+  const std::vector<std::uint8_t> buffer = Encode(expected);
+  const std::size_t half = buffer.size() / 2;
+
+  ResumableDeserializer deserializer;
+  auto status = deserializer.ReadFrom(fds[0]);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::WouldBlock, status.error());
+
+  ASSERT_EQ(static_cast<ssize_t>(half), write(fds[1], buffer.data(), half));
+  status = deserializer.ReadFrom(fds[0]);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::WouldBlock, status.error());
+  EXPECT_EQ(half, deserializer.buffered());
+
+  ASSERT_EQ(static_cast<ssize_t>(buffer.size() - half),
+            write(fds[1], buffer.data() + half, buffer.size() - half));
+  ASSERT_TRUE(deserializer.ReadFrom(fds[0]));
+
+  Message message;
+  ASSERT_TRUE(deserializer.Read(&message));
+  EXPECT_EQ(Encode(expected), Encode(message));
+
+  close(fds[1]);
+  status = deserializer.ReadFrom(fds[0]);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+  close(fds[0]);
+}
+
+TEST(ResumableDeserializer, ReadFromDrains) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  ASSERT_EQ(0, fcntl(fds[0], F_SETFL, O_NONBLOCK));
+
+  // Two values and part of a third arrive together. A single ReadFrom() must
+  // consume all of them so that edge-triggered readers are not left with
+  // unread data and no further notification.
+  const Message first = MakeMessage(1);
+  const Message second = MakeMessage(2);
+  std::vector<std::uint8_t> buffer = Encode(first);
+  const std::vector<std::uint8_t> encoded_second = Encode(second);
+  const std::vector<std::uint8_t> encoded_third = Encode(MakeMessage(3));
+  buffer.insert(buffer.end(), encoded_second.begin(), encoded_second.end());
+  buffer.insert(buffer.end(), encoded_third.begin(),
+                encoded_third.begin() + encoded_third.size() / 2);
+  ASSERT_EQ(static_cast<ssize_t>(buffer.size()),
+            write(fds[1], buffer.data(), buffer.size()));
+
+  ResumableDeserializer deserializer;
+  ASSERT_TRUE(deserializer.ReadFrom(fds[0]));
+  EXPECT_EQ(buffer.size(), deserializer.buffered());
+
+  std::uint8_t byte;
+  EXPECT_EQ(-1, read(fds[0], &byte, 1));
+  EXPECT_EQ(EAGAIN, errno);
+
+  Message message;
+  ASSERT_TRUE(deserializer.Read(&message));
+  EXPECT_EQ(Encode(first), Encode(message));
+  ASSERT_TRUE(deserializer.Read(&message));
+  EXPECT_EQ(Encode(second), Encode(message));
+  auto status = deserializer.Read(&message);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::WouldBlock, status.error());
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(ResumableSerializer, Consume) {
+  const Message expected = MakeMessage(3);
+
+  ResumableSerializer serializer;
+  EXPECT_TRUE(serializer.empty());
+  ASSERT_TRUE(serializer.Write(expected));
+  ASSERT_TRUE(serializer.Write(std::string{"foo"}));
+  EXPECT_FALSE(serializer.empty());
+
+  std::vector<std::uint8_t> expected_stream = Encode(expected);
+  const std::vector<std::uint8_t> string = Encode(std::string{"foo"});
+  expected_stream.insert(expected_stream.end(), string.begin(), string.end());
+  ASSERT_EQ(expected_stream.size(), serializer.size());
+
+  // Accept the data a few bytes at a time, queueing another value midway.
+  std::vector<std::uint8_t> stream;
+  const std::size_t kPieceSize = 5;
+  while (!serializer.empty()) {
+    const std::size_t size = std::min(kPieceSize, serializer.size());
+    stream.insert(stream.end(), serializer.data(), serializer.data() + size);
+    serializer.Consume(size);
+
+    if (stream.size() == kPieceSize) {
+      ASSERT_TRUE(serializer.Write(10));
+      nop::Append(&expected_stream, 10);
+    }
+  }
+
+  EXPECT_EQ(expected_stream, stream);
+}
+
+TEST(ResumableSerializer, WriteTo) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  ASSERT_EQ(0, fcntl(fds[0], F_SETFL, O_NONBLOCK));
+  ASSERT_EQ(0, fcntl(fds[1], F_SETFL, O_NONBLOCK));
+
+  // Make the value larger than the capacity of the pipe.
+  Message expected = MakeMessage(7);
+  expected.label = std::string(1 << 20, 'x');
+
+  ResumableSerializer serializer;
+  ASSERT_TRUE(serializer.Write(expected));
+
+  ResumableDeserializer deserializer;
+  std::size_t would_block_count = 0;
+  while (true) {
+    auto status = serializer.WriteTo(fds[1]);
+    if (!status) {
+      ASSERT_EQ(ErrorStatus::WouldBlock, status.error());
+      would_block_count++;
+    }
+
+    status = deserializer.ReadFrom(fds[0]);
+    if (status)
+      break;
+    ASSERT_EQ(ErrorStatus::WouldBlock, status.error());
+  }
+
+  EXPECT_GT(would_block_count, 0u);
+  EXPECT_TRUE(serializer.empty());
+
+  Message message;
+  ASSERT_TRUE(deserializer.Read(&message));
+  EXPECT_EQ(Encode(expected), Encode(message));
+
+  close(fds[0]);
+  close(fds[1]);
+}
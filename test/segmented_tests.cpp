@@ -0,0 +1,271 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/types/raw_value.h>
+#include <nop/utility/segmented_reader.h>
+#include <nop/utility/segmented_writer.h>
+
+#include "test_writer.h"
+
+using nop::Deserializer;
+using nop::Encode;
+using nop::ErrorStatus;
+using nop::PooledBuffer;
+using nop::RawValue;
+using nop::SegmentedReader;
+using nop::SegmentedWriter;
+using nop::Serializer;
+
+namespace {
+
+struct Record {
+  std::uint32_t id;
+  std::string name;
+  std::vector<std::uint64_t> values;
+
+  NOP_STRUCTURE(Record, id, name, values);
+};
+
+std::vector<Record> MakeRecords(std::size_t count) {
+  std::vector<Record> records;
+  for (std::size_t i = 0; i < count; i++) {
+    records.push_back({static_cast<std::uint32_t>(i),
+                       std::string(i % 300, 'a' + i % 26),
+                       std::vector<std::uint64_t>(i % 50, i)});
+  }
+  return records;
+}
+
+std::vector<std::uint8_t> Concatenate(const std::vector<iovec>& vectors) {
+  std::vector<std::uint8_t> bytes;
+  for (const iovec& vector : vectors) {
+    const std::uint8_t* data =
+        static_cast<const std::uint8_t*>(vector.iov_base);
+    bytes.insert(bytes.end(), data, data + vector.iov_len);
+  }
+  return bytes;
+}
+
+// Splits |bytes| into segments with the given repeating pattern of sizes.
+std::vector<iovec> Split(std::vector<std::uint8_t>* bytes,
+                         const std::vector<std::size_t>& sizes) {
+  std::vector<iovec> vectors;
+  std::size_t offset = 0;
+  for (std::size_t i = 0; offset < bytes->size(); i++) {
+    const std::size_t size =
+        std::min(sizes[i % sizes.size()], bytes->size() - offset);
+    vectors.push_back({bytes->data() + offset, size});
+    offset += size;
+  }
+  return vectors;
+}
+
+}  // anonymous namespace
+
+TEST(SegmentedWriter, Write) {
+  const std::vector<Record> records = MakeRecords(100);
+  const std::vector<std::uint8_t> expected = Encode(records);
+
+  // Small segments make most values straddle segment boundaries.
+  Serializer<SegmentedWriter> serializer{256u};
+  ASSERT_TRUE(serializer.Write(records));
+  const SegmentedWriter& writer = serializer.writer();
+  EXPECT_EQ(expected.size(), writer.size());
+  EXPECT_EQ((expected.size() + 255) / 256, writer.segment_count());
+
+  const std::vector<iovec> vectors = writer.iovecs();
+  ASSERT_EQ(writer.segment_count(), vectors.size());
+  for (std::size_t i = 0; i + 1 < vectors.size(); i++)
+    EXPECT_EQ(256u, vectors[i].iov_len);
+  EXPECT_EQ(expected, Concatenate(vectors));
+
+  // Skipped bytes may straddle segments too.
+  SegmentedWriter padding{256u};
+  ASSERT_TRUE(padding.Write(std::uint8_t{1}));
+  ASSERT_TRUE(padding.Skip(600, 0xaa));
+  EXPECT_EQ(3u, padding.segment_count());
+  std::vector<std::uint8_t> padded(601, 0xaa);
+  padded[0] = 1;
+  EXPECT_EQ(padded, Concatenate(padding.iovecs()));
+
+  padding.clear();
+  EXPECT_EQ(0u, padding.size());
+  EXPECT_EQ(0u, padding.segment_count());
+}
+
+TEST(SegmentedWriter, WriteTo) {
+  const std::vector<Record> records = MakeRecords(200);
+  const std::vector<std::uint8_t> expected = Encode(records);
+
+  Serializer<SegmentedWriter> serializer{256u};
+  ASSERT_TRUE(serializer.Write(records));
+
+  char path[] = "/tmp/segmented_tests.XXXXXX";
+  const int fd = ::mkstemp(path);
+  ASSERT_LE(0, fd);
+  ::unlink(path);
+
+  ASSERT_TRUE(serializer.writer().WriteTo(fd));
+  std::vector<std::uint8_t> bytes(expected.size() + 1);
+  const ssize_t size = ::pread(fd, bytes.data(), bytes.size(), 0);
+  ::close(fd);
+  ASSERT_EQ(static_cast<ssize_t>(expected.size()), size);
+  bytes.resize(size);
+  EXPECT_EQ(expected, bytes);
+
+  EXPECT_FALSE(serializer.writer().WriteTo(-1));
+}
+
+TEST(SegmentedWriter, Take) {
+  const std::vector<Record> records = MakeRecords(20);
+  const std::vector<std::uint8_t> expected = Encode(records);
+
+  Serializer<SegmentedWriter> serializer{256u};
+  ASSERT_TRUE(serializer.Write(records));
+  const std::size_t segment_count = serializer.writer().segment_count();
+
+  std::vector<PooledBuffer> segments = serializer.writer().take();
+  EXPECT_EQ(segment_count, segments.size());
+  EXPECT_EQ(0u, serializer.writer().size());
+  EXPECT_EQ(0u, serializer.writer().segment_count());
+
+  std::vector<std::uint8_t> bytes;
+  for (const PooledBuffer& segment : segments)
+    bytes.insert(bytes.end(), segment.data(), segment.data() + segment.size());
+  EXPECT_EQ(expected, bytes);
+
+  // The writer may be reused after its segments are taken.
+  ASSERT_TRUE(serializer.Write(records));
+  EXPECT_EQ(expected.size(), serializer.writer().size());
+  segments = serializer.writer().take();
+  EXPECT_EQ(segment_count, segments.size());
+
+  bytes.clear();
+  for (const PooledBuffer& segment : segments)
+    bytes.insert(bytes.end(), segment.data(), segment.data() + segment.size());
+  EXPECT_EQ(expected, bytes);
+}
+
+TEST(SegmentedReader, Read) {
+  const std::vector<Record> records = MakeRecords(100);
+  std::vector<std::uint8_t> bytes = Encode(records);
+
+  // Segments of assorted sizes, including empty and single byte segments.
+  for (const auto& sizes : std::vector<std::vector<std::size_t>>{
+           {1}, {3, 0, 7}, {64, 1, 0, 255}, {bytes.size()}}) {
+    const std::vector<iovec> vectors = Split(&bytes, sizes);
+    Deserializer<SegmentedReader> deserializer{vectors};
+    EXPECT_EQ(bytes.size(), deserializer.reader().size());
+
+    std::vector<Record> decoded;
+    ASSERT_TRUE(deserializer.Read(&decoded));
+    EXPECT_TRUE(deserializer.reader().empty());
+    ASSERT_EQ(records.size(), decoded.size());
+    for (std::size_t i = 0; i < records.size(); i++) {
+      EXPECT_EQ(records[i].id, decoded[i].id);
+      EXPECT_EQ(records[i].name, decoded[i].name);
+      EXPECT_EQ(records[i].values, decoded[i].values);
+    }
+  }
+}
+
+TEST(SegmentedReader, FromWriter) {
+  const std::vector<Record> records = MakeRecords(50);
+
+  Serializer<SegmentedWriter> serializer{256u};
+  for (const Record& record : records)
+    ASSERT_TRUE(serializer.Write(record));
+
+  Deserializer<SegmentedReader> deserializer{serializer.writer().take()};
+  EXPECT_LT(1u, deserializer.reader().segment_count());
+  for (const Record& record : records) {
+    Record decoded;
+    ASSERT_TRUE(deserializer.Read(&decoded));
+    EXPECT_EQ(record.id, decoded.id);
+    EXPECT_EQ(record.values, decoded.values);
+  }
+  EXPECT_TRUE(deserializer.reader().empty());
+}
+
+TEST(SegmentedReader, SkipEnsure) {
+  std::vector<std::uint8_t> bytes(100);
+  for (std::size_t i = 0; i < bytes.size(); i++)
+    bytes[i] = i;
+  const std::vector<iovec> vectors = Split(&bytes, {10, 0, 25});
+
+  SegmentedReader reader{vectors};
+  EXPECT_TRUE(reader.Ensure(100));
+  EXPECT_FALSE(reader.Ensure(101));
+
+  ASSERT_TRUE(reader.Skip(5));
+  ASSERT_TRUE(reader.Skip(40));
+  EXPECT_EQ(55u, reader.remaining());
+
+  std::uint8_t byte;
+  ASSERT_TRUE(reader.Read(&byte));
+  EXPECT_EQ(45u, byte);
+
+  std::uint8_t chunk[30];
+  ASSERT_TRUE(reader.Read(chunk, chunk + 30));
+  EXPECT_EQ(46u, chunk[0]);
+  EXPECT_EQ(75u, chunk[29]);
+
+  // Reads and skips past the end fail without consuming anything.
+  auto status = reader.Skip(25);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+  status = reader.Read(chunk, chunk + 25);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+  EXPECT_EQ(24u, reader.remaining());
+
+  ASSERT_TRUE(reader.Skip(24));
+  EXPECT_TRUE(reader.empty());
+  status = reader.Read(&byte);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+}
+
+TEST(SegmentedReader, Errors) {
+  std::vector<std::uint8_t> bytes = Encode(MakeRecords(10));
+  bytes.resize(bytes.size() - 1);
+  const std::vector<iovec> vectors = Split(&bytes, {7});
+
+  Deserializer<SegmentedReader> deserializer{vectors};
+  std::vector<Record> decoded;
+  auto status = deserializer.Read(&decoded);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+
+  // Values that refer to encoded bytes are copied out of the segments.
+  const std::string value = "a raw value that straddles segments";
+  bytes = Encode(value);
+  SegmentedReader reader{Split(&bytes, {4})};
+  RawValue raw;
+  ASSERT_TRUE(nop::Encoding<RawValue>::Read(&raw, &reader));
+  EXPECT_TRUE(raw.owned());
+  EXPECT_EQ(bytes, std::vector<std::uint8_t>(raw.data(),
+                                             raw.data() + raw.size()));
+}
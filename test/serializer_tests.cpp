@@ -28,6 +28,7 @@
 #include <nop/serializer.h>
 #include <nop/structure.h>
 #include <nop/table.h>
+#include <nop/utility/buffer_reader.h>
 #include <nop/value.h>
 
 #include "mock_reader.h"
@@ -37,6 +38,7 @@
 #include "test_writer.h"
 
 using nop::Append;
+using nop::BufferReader;
 using nop::Compose;
 using nop::DefaultHandlePolicy;
 using nop::DeletedEntry;
@@ -49,10 +51,12 @@ using nop::ErrorStatus;
 using nop::Float;
 using nop::Handle;
 using nop::Integer;
+using nop::RawValue;
 using nop::Serializer;
 using nop::Status;
 using nop::TestReader;
 using nop::TestWriter;
+using nop::UnknownEntries;
 using nop::Variant;
 
 using nop::testing::MockReader;
@@ -242,6 +246,13 @@ struct TableA2 {
   NOP_TABLE_HASH(15, TableA2, name, attributes, address);
 };
 
+struct TableA3 {
+  Entry<std::string, 0> name;
+  UnknownEntries unknown;
+
+  NOP_TABLE_HASH(15, TableA3, name, unknown);
+};
+
 template <typename T>
 struct ValueWrapper {
   T value;
@@ -7072,6 +7083,109 @@ TEST(Deserializer, Table) {
   }
 }
 
+TEST(Deserializer, TableUnknownEntries) {
+  const std::vector<std::uint8_t> encoded = Compose(
+      EncodingByte::Table, 15, 2, 0, 13, EncodingByte::String, 11,
+      "Ron Swanson", 1, 26, EncodingByte::Array, 3, EncodingByte::String, 6,
+      "snarky", EncodingByte::String, 4, "male", EncodingByte::String, 8,
+      "attitude");
+  const std::vector<std::uint8_t> unknown_bytes = Compose(
+      EncodingByte::Array, 3, EncodingByte::String, 6, "snarky",
+      EncodingByte::String, 4, "male", EncodingByte::String, 8, "attitude");
+
+  // Non-contiguous readers copy the unknown entry bytes.
+  {
+    TestReader reader;
+    Deserializer<TestReader*> deserializer{&reader};
+    TableA3 value;
+
+    reader.Set(encoded);
+    ASSERT_TRUE(deserializer.Read(&value));
+
+    ASSERT_TRUE(value.name);
+    EXPECT_EQ("Ron Swanson", value.name.get());
+    ASSERT_EQ(1u, value.unknown.size());
+
+    const auto& item = *value.unknown.begin();
+    EXPECT_EQ(1u, item.id);
+    EXPECT_TRUE(item.bytes.owned());
+    EXPECT_EQ(unknown_bytes,
+              std::vector<std::uint8_t>(item.bytes.data(),
+                                        item.bytes.data() + item.bytes.size()));
+
+    // Reading again replaces the unknown entries.
+    reader.Set(encoded);
+    ASSERT_TRUE(deserializer.Read(&value));
+    EXPECT_EQ(1u, value.unknown.size());
+  }
+
+  // Contiguous readers borrow the unknown entry bytes.
+  {
+    Deserializer<BufferReader> deserializer{encoded.data(), encoded.size()};
+    TableA3 value;
+
+    ASSERT_TRUE(deserializer.Read(&value));
+    ASSERT_EQ(1u, value.unknown.size());
+
+    const auto& item = *value.unknown.begin();
+    EXPECT_FALSE(item.bytes.owned());
+    EXPECT_GT(item.bytes.data(), encoded.data());
+    EXPECT_LT(item.bytes.data(), encoded.data() + encoded.size());
+
+    value.unknown.own();
+    EXPECT_TRUE(value.unknown.begin()->bytes.owned());
+  }
+
+  // Tables without an UnknownEntries member skip unknown entries.
+  {
+    Deserializer<BufferReader> deserializer{encoded.data(), encoded.size()};
+    TableA2 value;
+
+    ASSERT_TRUE(deserializer.Read(&value));
+    EXPECT_EQ(TableA2{"Ron Swanson"}, value);
+  }
+}
+
+TEST(Serializer, TableUnknownEntries) {
+  const std::vector<std::uint8_t> encoded = Compose(
+      EncodingByte::Table, 15, 2, 0, 13, EncodingByte::String, 11,
+      "Ron Swanson", 1, 26, EncodingByte::Array, 3, EncodingByte::String, 6,
+      "snarky", EncodingByte::String, 4, "male", EncodingByte::String, 8,
+      "attitude");
+
+  TestReader reader;
+  Deserializer<TestReader*> deserializer{&reader};
+  TestWriter writer;
+  Serializer<TestWriter*> serializer{&writer};
+
+  TableA3 value;
+  reader.Set(encoded);
+  ASSERT_TRUE(deserializer.Read(&value));
+
+  // Unknown entries are forwarded unchanged.
+  EXPECT_EQ(encoded.size(), serializer.GetSize(value));
+  ASSERT_TRUE(serializer.Write(value));
+  EXPECT_EQ(encoded, writer.data());
+  writer.clear();
+
+  // Forwarded data decodes with the newer table definition.
+  TableA1 newer;
+  reader.Set(encoded);
+  Deserializer<TestReader*> newer_deserializer{&reader};
+  ASSERT_TRUE(newer_deserializer.Read(&newer));
+  EXPECT_EQ(TableA1("Ron Swanson", {{"snarky", "male", "attitude"}}), newer);
+
+  // Entries may be added directly.
+  TableA3 manual;
+  const std::vector<std::uint8_t> bytes =
+      Compose(EncodingByte::String, 1, "a");
+  manual.unknown.Add(7, RawValue{bytes.data(), bytes.size()});
+  ASSERT_TRUE(serializer.Write(manual));
+  EXPECT_EQ(Compose(EncodingByte::Table, 15, 1, 7, 3, EncodingByte::String, 1,
+                    "a"),
+            writer.data());
+}
+
 TEST(Serializer, VariantFailOnPrepare) {
   MockWriter writer;
   Serializer<MockWriter*> serializer{&writer};
@@ -7360,6 +7474,87 @@ TEST(Deserializer, Variant) {
   }
 }
 
+TEST(Serializer, VariantManyTypes) {
+  using VariantType =
+      Variant<char, short, int, long, float, double, bool, std::uint8_t,
+              std::uint16_t, std::string>;
+
+  std::vector<std::uint8_t> expected;
+  TestWriter writer;
+  Serializer<TestWriter*> serializer{&writer};
+
+  {
+    VariantType value_a{10};
+    VariantType value_b{std::string{"foo"}};
+    VariantType value_c;
+
+    ASSERT_TRUE(serializer.Write(value_a));
+    ASSERT_TRUE(serializer.Write(value_b));
+    ASSERT_TRUE(serializer.Write(value_c));
+
+    expected = Compose(EncodingByte::Variant, 2, 10, EncodingByte::Variant, 9,
+                       EncodingByte::String, 3, "foo", EncodingByte::Variant,
+                       -1, EncodingByte::Nil);
+    EXPECT_EQ(expected, writer.data());
+    writer.clear();
+  }
+}
+
+TEST(Deserializer, VariantManyTypes) {
+  using VariantType =
+      Variant<char, short, int, long, float, double, bool, std::uint8_t,
+              std::uint16_t, std::string>;
+
+  TestReader reader;
+  Deserializer<TestReader*> deserializer{&reader};
+
+  {
+    VariantType value_a;
+    VariantType value_b;
+    VariantType value_c{10};
+
+    reader.Set(Compose(EncodingByte::Variant, 2, 10, EncodingByte::Variant, 9,
+                       EncodingByte::String, 3, "foo", EncodingByte::Variant,
+                       -1, EncodingByte::Nil));
+
+    ASSERT_TRUE(deserializer.Read(&value_a));
+    ASSERT_TRUE(deserializer.Read(&value_b));
+    ASSERT_TRUE(deserializer.Read(&value_c));
+
+    ASSERT_TRUE(value_a.is<int>());
+    EXPECT_EQ(10, std::get<int>(value_a));
+    ASSERT_TRUE(value_b.is<std::string>());
+    EXPECT_EQ("foo", std::get<std::string>(value_b));
+    EXPECT_TRUE(value_c.empty());
+  }
+
+  // Decoding into a variant that already holds the target type reuses the
+  // active element.
+  {
+    VariantType value{std::string{"foobar"}};
+    const std::string* element = value.get<std::string>();
+
+    reader.Set(Compose(EncodingByte::Variant, 9, EncodingByte::String, 3,
+                       "baz"));
+
+    ASSERT_TRUE(deserializer.Read(&value));
+
+    ASSERT_TRUE(value.is<std::string>());
+    EXPECT_EQ(element, value.get<std::string>());
+    EXPECT_EQ("baz", std::get<std::string>(value));
+  }
+
+  {
+    VariantType value;
+
+    reader.Set(Compose(EncodingByte::Variant, 10, 0));
+
+    auto status = deserializer.Read(&value);
+    ASSERT_FALSE(status);
+    EXPECT_EQ(ErrorStatus::UnexpectedVariantType, status.error());
+  }
+}
+
 TEST(Serializer, Value) {
   std::vector<std::uint8_t> expected;
   TestWriter writer;
@@ -7815,3 +8010,126 @@ TEST(Deserializer, reference_wrapper) {
     EXPECT_EQ(expected, value);
   }
 }
+
+TEST(Serializer, WriteBatch) {
+  std::vector<std::uint8_t> expected;
+  TestWriter writer;
+  Serializer<TestWriter*> serializer{&writer};
+
+  const std::vector<TestA> values{{10, "foo"}, {20, "bar"}};
+
+  {
+    ASSERT_TRUE(serializer.WriteBatch(values));
+
+    expected =
+        Compose(EncodingByte::Structure, 2, 10, EncodingByte::String, 3, "foo",
+                EncodingByte::Structure, 2, 20, EncodingByte::String, 3, "bar");
+    EXPECT_EQ(expected, writer.data());
+    writer.clear();
+  }
+
+  {
+    ASSERT_TRUE(serializer.WriteBatch(values, nop::BatchFraming::Framed));
+
+    expected = Compose(8, EncodingByte::Structure, 2, 10, EncodingByte::String,
+                       3, "foo", 8, EncodingByte::Structure, 2, 20,
+                       EncodingByte::String, 3, "bar");
+    EXPECT_EQ(expected, writer.data());
+    writer.clear();
+  }
+}
+
+TEST(Serializer, WriteBatchPreparesOnce) {
+  MockWriter writer;
+  Serializer<MockWriter*> serializer{&writer};
+  Status<void> status;
+
+  EXPECT_CALL(writer, Prepare(Eq(18U)))
+      .Times(1)
+      .WillOnce(Return(ErrorStatus::WriteLimitReached));
+  EXPECT_CALL(writer, Write(_)).Times(0);
+  EXPECT_CALL(writer, Write(_, _)).Times(0);
+  EXPECT_CALL(writer, Skip(_, _)).Times(0);
+
+  const std::vector<TestA> values{{10, "foo"}, {20, "bar"}};
+  status = serializer.WriteBatch(values, nop::BatchFraming::Framed);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::WriteLimitReached, status.error());
+}
+
+TEST(Serializer, WriteBatchFramedHandles) {
+  std::vector<std::uint8_t> expected;
+  TestWriter writer;
+  Serializer<TestWriter*> serializer{&writer};
+
+  using IntHandlePolicy = DefaultHandlePolicy<int, -1>;
+  using IntHandle = Handle<IntHandlePolicy>;
+
+  // Handles overestimate their size, so each frame is padded out to the
+  // length in its prefix.
+  std::vector<IntHandle> values;
+  values.emplace_back(3);
+  values.emplace_back(4);
+  ASSERT_TRUE(serializer.WriteBatch(values, nop::BatchFraming::Framed));
+
+  expected = Compose(11, EncodingByte::Handle, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                     11, EncodingByte::Handle, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0);
+  EXPECT_EQ(expected, writer.data());
+  EXPECT_EQ(std::vector<int>({3, 4}), writer.handles());
+
+  TestReader reader;
+  Deserializer<TestReader*> deserializer{&reader};
+  reader.Set(writer.data());
+  reader.SetHandles(writer.handles());
+
+  IntHandle handles[2];
+  ASSERT_TRUE(deserializer.ReadBatch(handles, 2, nop::BatchFraming::Framed));
+  EXPECT_EQ(3, handles[0].get());
+  EXPECT_EQ(4, handles[1].get());
+}
+
+TEST(Deserializer, ReadBatch) {
+  TestReader reader;
+  Deserializer<TestReader*> deserializer{&reader};
+  Status<void> status;
+  TestA values[2];
+
+  {
+    reader.Set(Compose(EncodingByte::Structure, 2, 10, EncodingByte::String, 3,
+                       "foo", EncodingByte::Structure, 2, 20,
+                       EncodingByte::String, 3, "bar"));
+    status = deserializer.ReadBatch(values, 2);
+    ASSERT_TRUE(status);
+    EXPECT_EQ((TestA{10, "foo"}), values[0]);
+    EXPECT_EQ((TestA{20, "bar"}), values[1]);
+  }
+
+  {
+    reader.Set(Compose(8, EncodingByte::Structure, 2, 30, EncodingByte::String,
+                       3, "baz", 8, EncodingByte::Structure, 2, 40,
+                       EncodingByte::String, 3, "qux"));
+    status = deserializer.ReadBatch(values, 2, nop::BatchFraming::Framed);
+    ASSERT_TRUE(status);
+    EXPECT_EQ((TestA{30, "baz"}), values[0]);
+    EXPECT_EQ((TestA{40, "qux"}), values[1]);
+  }
+
+  // Padding after the value is skipped.
+  {
+    reader.Set(Compose(9, EncodingByte::Structure, 2, 30, EncodingByte::String,
+                       3, "baz", 0, 8, EncodingByte::Structure, 2, 40,
+                       EncodingByte::String, 3, "qux"));
+    status = deserializer.ReadBatch(values, 2, nop::BatchFraming::Framed);
+    ASSERT_TRUE(status);
+    EXPECT_EQ((TestA{30, "baz"}), values[0]);
+    EXPECT_EQ((TestA{40, "qux"}), values[1]);
+  }
+
+  {
+    reader.Set(Compose(7, EncodingByte::Structure, 2, 30, EncodingByte::String,
+                       3, "baz"));
+    status = deserializer.ReadBatch(values, 1, nop::BatchFraming::Framed);
+    ASSERT_FALSE(status);
+    EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+  }
+}
@@ -0,0 +1,363 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/utility/shared_memory_ring.h>
+#include <nop/utility/shared_memory_ring_reader.h>
+#include <nop/utility/shared_memory_ring_writer.h>
+
+using nop::Deserializer;
+using nop::ErrorStatus;
+using nop::Serializer;
+using nop::SharedMemoryRing;
+using nop::SharedMemoryRingReader;
+using nop::SharedMemoryRingWriter;
+
+namespace {
+
+struct Message {
+  std::uint32_t id;
+  std::string text;
+  std::vector<std::uint8_t> payload;
+
+  NOP_STRUCTURE(Message, id, text, payload);
+};
+
+Message MakeMessage(std::uint32_t id) {
+  return {id, "message " + std::to_string(id),
+          std::vector<std::uint8_t>(id % 251, static_cast<std::uint8_t>(id))};
+}
+
+bool operator==(const Message& a, const Message& b) {
+  return a.id == b.id && a.text == b.text && a.payload == b.payload;
+}
+
+SharedMemoryRing CreateRing(std::size_t capacity) {
+  auto status = SharedMemoryRing::Create(capacity);
+  EXPECT_TRUE(status) << status.GetErrorMessage();
+  return status.take();
+}
+
+}  // anonymous namespace
+
+TEST(SharedMemoryRing, Create) {
+  SharedMemoryRing ring = CreateRing(1);
+  ASSERT_TRUE(ring);
+  EXPECT_EQ(SharedMemoryRing::kMinCapacity, ring.capacity());
+  EXPECT_EQ(SharedMemoryRing::kMinCapacity / 2 - 8, ring.max_message_size());
+  EXPECT_LE(0, ring.fd());
+  EXPECT_FALSE(ring.is_shutdown());
+
+  ring = CreateRing(5000);
+  EXPECT_EQ(8192u, ring.capacity());
+
+  auto status = SharedMemoryRing::Create(SharedMemoryRing::kMaxCapacity + 1);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::SystemError, status.error());
+
+  SharedMemoryRing moved{std::move(ring)};
+  EXPECT_TRUE(moved);
+  EXPECT_FALSE(ring);
+}
+
+TEST(SharedMemoryRing, RoundTrip) {
+  SharedMemoryRing ring = CreateRing(4096);
+  Serializer<SharedMemoryRingWriter> serializer{&ring};
+  Deserializer<SharedMemoryRingReader> deserializer{&ring, false};
+
+  auto status = deserializer.reader().Receive();
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::WouldBlock, status.error());
+
+  // A message may hold several values.
+  ASSERT_TRUE(serializer.Write(MakeMessage(1)));
+  ASSERT_TRUE(serializer.Write(std::string{"trailer"}));
+  ASSERT_TRUE(serializer.writer().Commit());
+  ASSERT_TRUE(serializer.Write(MakeMessage(2)));
+  ASSERT_TRUE(serializer.writer().Commit());
+
+  // Messages are not visible until committed.
+  ASSERT_TRUE(serializer.Write(MakeMessage(3)));
+
+  Message message;
+  std::string trailer;
+  ASSERT_TRUE(deserializer.reader().Receive());
+  ASSERT_TRUE(deserializer.Read(&message));
+  ASSERT_TRUE(deserializer.Read(&trailer));
+  EXPECT_EQ(MakeMessage(1), message);
+  EXPECT_EQ("trailer", trailer);
+  EXPECT_TRUE(deserializer.reader().empty());
+
+  // Reads are limited to the current message.
+  status = deserializer.Read(&message);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+
+  ASSERT_TRUE(deserializer.reader().Receive());
+  ASSERT_TRUE(deserializer.Read(&message));
+  EXPECT_EQ(MakeMessage(2), message);
+
+  status = deserializer.reader().Receive();
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::WouldBlock, status.error());
+
+  ASSERT_TRUE(serializer.writer().Commit());
+  ASSERT_TRUE(deserializer.reader().Receive());
+  ASSERT_TRUE(deserializer.Read(&message));
+  EXPECT_EQ(MakeMessage(3), message);
+
+  // Empty messages are allowed.
+  ASSERT_TRUE(serializer.writer().Commit());
+  ASSERT_TRUE(deserializer.reader().Receive());
+  EXPECT_EQ(0u, deserializer.reader().size());
+}
+
+TEST(SharedMemoryRing, Wrap) {
+  SharedMemoryRing ring = CreateRing(4096);
+  Serializer<SharedMemoryRingWriter> serializer{&ring, false};
+  Deserializer<SharedMemoryRingReader> deserializer{&ring, false};
+
+  // Keep a few messages in flight so that records wrap at every offset.
+  std::uint32_t next_read = 0;
+  for (std::uint32_t id = 0; id < 2000; id++) {
+    auto status = serializer.Write(MakeMessage(id));
+    if (status)
+      status = serializer.writer().Commit();
+
+    if (!status) {
+      ASSERT_EQ(ErrorStatus::WouldBlock, status.error());
+      serializer.writer().clear();
+      id--;
+    }
+
+    if (!status || id % 3 == 0) {
+      Message message;
+      ASSERT_TRUE(deserializer.reader().Receive());
+      ASSERT_TRUE(deserializer.Read(&message));
+      ASSERT_EQ(MakeMessage(next_read), message);
+      next_read++;
+    }
+  }
+
+  Message message;
+  while (deserializer.reader().Receive()) {
+    ASSERT_TRUE(deserializer.Read(&message));
+    ASSERT_EQ(MakeMessage(next_read), message);
+    next_read++;
+  }
+  EXPECT_EQ(2000u, next_read);
+}
+
+TEST(SharedMemoryRing, Limits) {
+  SharedMemoryRing ring = CreateRing(4096);
+  Serializer<SharedMemoryRingWriter> serializer{&ring, false};
+  Deserializer<SharedMemoryRingReader> deserializer{&ring, false};
+
+  std::vector<std::uint8_t> large(ring.max_message_size());
+  auto status = serializer.Write(large);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::WriteLimitReached, status.error());
+  serializer.writer().clear();
+
+  // Fill the ring until the writer would block.
+  const std::vector<std::uint8_t> block(1000, 0xaa);
+  int count = 0;
+  for (;;) {
+    status = serializer.Write(block);
+    if (!status)
+      break;
+    ASSERT_TRUE(serializer.writer().Commit());
+    count++;
+  }
+  EXPECT_EQ(ErrorStatus::WouldBlock, status.error());
+  EXPECT_EQ(4, count);
+
+  // The partial message is kept and may be completed once there is room.
+  std::vector<std::uint8_t> value;
+  ASSERT_TRUE(deserializer.reader().Receive());
+  ASSERT_TRUE(deserializer.Read(&value));
+  EXPECT_EQ(block, value);
+  deserializer.reader().Release();
+
+  ASSERT_TRUE(serializer.Write(block));
+  ASSERT_TRUE(serializer.writer().Commit());
+
+  for (int i = 0; i < count; i++) {
+    ASSERT_TRUE(deserializer.reader().Receive());
+    ASSERT_TRUE(deserializer.Read(&value));
+    EXPECT_EQ(block, value);
+  }
+}
+
+TEST(SharedMemoryRing, Shutdown) {
+  SharedMemoryRing ring = CreateRing(4096);
+  Serializer<SharedMemoryRingWriter> serializer{&ring};
+  Deserializer<SharedMemoryRingReader> deserializer{&ring};
+
+  ASSERT_TRUE(serializer.Write(MakeMessage(1)));
+  ASSERT_TRUE(serializer.writer().Commit());
+  ring.Shutdown();
+  EXPECT_TRUE(ring.is_shutdown());
+
+  ASSERT_TRUE(serializer.Write(MakeMessage(2)));
+  auto status = serializer.writer().Commit();
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::IOError, status.error());
+
+  // Committed messages are still delivered.
+  Message message;
+  ASSERT_TRUE(deserializer.reader().Receive());
+  ASSERT_TRUE(deserializer.Read(&message));
+  EXPECT_EQ(MakeMessage(1), message);
+
+  status = deserializer.reader().Receive();
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+}
+
+TEST(SharedMemoryRing, Map) {
+  SharedMemoryRing ring = CreateRing(4096);
+  auto status = SharedMemoryRing::Map(dup(ring.fd()));
+  ASSERT_TRUE(status);
+  SharedMemoryRing mapped = status.take();
+  EXPECT_EQ(ring.capacity(), mapped.capacity());
+
+  Serializer<SharedMemoryRingWriter> serializer{&ring};
+  Deserializer<SharedMemoryRingReader> deserializer{&mapped};
+  ASSERT_TRUE(serializer.Write(MakeMessage(7)));
+  ASSERT_TRUE(serializer.writer().Commit());
+
+  Message message;
+  ASSERT_TRUE(deserializer.reader().Receive());
+  ASSERT_TRUE(deserializer.Read(&message));
+  EXPECT_EQ(MakeMessage(7), message);
+
+  // Files that do not hold a ring are rejected.
+  int fd = memfd_create("not-a-ring", MFD_CLOEXEC);
+  ASSERT_LE(0, fd);
+  ASSERT_EQ(0, ftruncate(fd, 4096 + 4096));
+  status = SharedMemoryRing::Map(fd);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ProtocolError, status.error());
+
+  fd = memfd_create("not-a-ring", MFD_CLOEXEC);
+  ASSERT_LE(0, fd);
+  status = SharedMemoryRing::Map(fd);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ProtocolError, status.error());
+}
+
+TEST(SharedMemoryRing, CorruptRecord) {
+  SharedMemoryRing ring = CreateRing(4096);
+  Serializer<SharedMemoryRingWriter> serializer{&ring};
+  Deserializer<SharedMemoryRingReader> deserializer{&ring};
+
+  ASSERT_TRUE(serializer.Write(MakeMessage(1)));
+  ASSERT_TRUE(serializer.writer().Commit());
+
+  // Overwrite the length of the first record through a second mapping.
+  void* mapping = mmap(nullptr, 4096 + ring.capacity(), PROT_READ | PROT_WRITE,
+                       MAP_SHARED, ring.fd(), 0);
+  ASSERT_NE(MAP_FAILED, mapping);
+  const std::uint32_t length = 3000;
+  std::memcpy(static_cast<std::uint8_t*>(mapping) + 4096, &length,
+              sizeof(length));
+  munmap(mapping, 4096 + ring.capacity());
+
+  auto status = deserializer.reader().Receive();
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ProtocolError, status.error());
+}
+
+TEST(SharedMemoryRing, Threads) {
+  SharedMemoryRing ring = CreateRing(4096);
+  const std::uint32_t kCount = 20000;
+
+  std::thread producer{[&ring, kCount] {
+    Serializer<SharedMemoryRingWriter> serializer{&ring};
+    for (std::uint32_t id = 0; id < kCount; id++) {
+      ASSERT_TRUE(serializer.Write(MakeMessage(id)));
+      ASSERT_TRUE(serializer.writer().Commit());
+    }
+    ring.Shutdown();
+  }};
+
+  Deserializer<SharedMemoryRingReader> deserializer{&ring};
+  Message message;
+  std::uint32_t count = 0;
+  while (deserializer.reader().Receive()) {
+    ASSERT_TRUE(deserializer.Read(&message));
+    ASSERT_EQ(MakeMessage(count), message);
+    count++;
+  }
+  producer.join();
+  EXPECT_EQ(kCount, count);
+}
+
+TEST(SharedMemoryRing, Processes) {
+  SharedMemoryRing request_ring = CreateRing(4096);
+  SharedMemoryRing response_ring = CreateRing(4096);
+  const std::uint32_t kCount = 5000;
+
+  const pid_t pid = fork();
+  ASSERT_LE(0, pid);
+  if (pid == 0) {
+    // Echo each message id back to the parent.
+    Deserializer<SharedMemoryRingReader> deserializer{&request_ring};
+    Serializer<SharedMemoryRingWriter> serializer{&response_ring};
+    Message message;
+    int result = 0;
+    while (deserializer.reader().Receive()) {
+      if (!deserializer.Read(&message) || !(message == MakeMessage(message.id)))
+        result = 1;
+      if (!serializer.Write(message.id) || !serializer.writer().Commit())
+        result = 1;
+    }
+    response_ring.Shutdown();
+    _exit(result);
+  }
+
+  Serializer<SharedMemoryRingWriter> serializer{&request_ring};
+  Deserializer<SharedMemoryRingReader> deserializer{&response_ring};
+  std::uint32_t id;
+  for (std::uint32_t i = 0; i < kCount; i++) {
+    ASSERT_TRUE(serializer.Write(MakeMessage(i)));
+    ASSERT_TRUE(serializer.writer().Commit());
+    ASSERT_TRUE(deserializer.reader().Receive());
+    ASSERT_TRUE(deserializer.Read(&id));
+    ASSERT_EQ(i, id);
+  }
+  request_ring.Shutdown();
+
+  auto status = deserializer.reader().Receive();
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+
+  int child_status = 0;
+  ASSERT_EQ(pid, waitpid(pid, &child_status, 0));
+  ASSERT_TRUE(WIFEXITED(child_status));
+  EXPECT_EQ(0, WEXITSTATUS(child_status));
+}
@@ -0,0 +1,117 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/utility/stream_reader.h>
+#include <nop/utility/stream_writer.h>
+
+using nop::Deserializer;
+using nop::ErrorStatus;
+using nop::Serializer;
+using nop::StreamReader;
+using nop::StreamWriter;
+
+namespace {
+
+// Stream buffer over a string that does not support seeking, like a pipe.
+class UnseekableBuffer : public std::streambuf {
+ public:
+  explicit UnseekableBuffer(std::string data) : data_{std::move(data)} {
+    setg(&data_[0], &data_[0], &data_[0] + data_.size());
+  }
+
+ private:
+  std::string data_;
+};
+
+class UnseekableStream : public std::istream {
+ public:
+  explicit UnseekableStream(std::string data)
+      : std::istream{nullptr}, buffer_{std::move(data)} {
+    rdbuf(&buffer_);
+  }
+
+ private:
+  UnseekableBuffer buffer_;
+};
+
+}  // anonymous namespace
+
+TEST(Stream, RoundTrip) {
+  const std::map<std::string, std::vector<int>> value{
+      {"a", {1, 2, 3}}, {"b", {}}, {"c", {1000, -1}}};
+
+  Serializer<StreamWriter<std::stringstream>> serializer;
+  ASSERT_TRUE(serializer.Write(value));
+  ASSERT_TRUE(serializer.Write(std::string{"next"}));
+
+  Deserializer<StreamReader<std::stringstream>> deserializer{
+      serializer.writer().take()};
+  std::map<std::string, std::vector<int>> decoded;
+  ASSERT_TRUE(deserializer.Read(&decoded));
+  EXPECT_EQ(value, decoded);
+
+  std::string next;
+  ASSERT_TRUE(deserializer.Read(&next));
+  EXPECT_EQ("next", next);
+
+  auto status = deserializer.Read(&next);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::StreamError, status.error());
+  EXPECT_TRUE(deserializer.reader().stream().eof());
+}
+
+TEST(Stream, Skip) {
+  StreamWriter<std::stringstream> writer;
+  ASSERT_TRUE(writer.Write(std::uint8_t{1}));
+  ASSERT_TRUE(writer.Skip(1000, 0xaa));
+  ASSERT_TRUE(writer.Write(std::uint8_t{2}));
+
+  const std::string data = writer.stream().str();
+  ASSERT_EQ(1002u, data.size());
+  EXPECT_EQ(std::string(1000, '\xaa'), data.substr(1, 1000));
+
+  // Seekable streams skip by seeking.
+  StreamReader<std::stringstream> reader{data};
+  std::uint8_t byte = 0;
+  ASSERT_TRUE(reader.Read(&byte));
+  EXPECT_EQ(1u, byte);
+  ASSERT_TRUE(reader.Skip(1000));
+  ASSERT_TRUE(reader.Read(&byte));
+  EXPECT_EQ(2u, byte);
+
+  // Other streams skip by reading.
+  StreamReader<UnseekableStream> unseekable{data};
+  ASSERT_TRUE(unseekable.Read(&byte));
+  ASSERT_TRUE(unseekable.Skip(1000));
+  ASSERT_TRUE(unseekable.Read(&byte));
+  EXPECT_EQ(2u, byte);
+
+  // Skipping past the end fails either way.
+  StreamReader<std::stringstream> short_reader{data};
+  EXPECT_FALSE(short_reader.Skip(1003));
+  StreamReader<UnseekableStream> short_unseekable{data};
+  EXPECT_FALSE(short_unseekable.Skip(1003));
+}
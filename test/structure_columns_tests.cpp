@@ -0,0 +1,172 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/types/structure_columns.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/buffer_writer.h>
+#include <nop/utility/pedantic_buffer_reader.h>
+
+#include "test_utilities.h"
+#include "test_writer.h"
+
+using nop::BufferReader;
+using nop::BufferWriter;
+using nop::Compose;
+using nop::Deserializer;
+using nop::Encode;
+using nop::EncodingByte;
+using nop::ErrorStatus;
+using nop::Integer;
+using nop::PedanticBufferReader;
+using nop::Serializer;
+using nop::Status;
+using nop::StructureColumns;
+
+namespace {
+
+struct Sample {
+  std::uint64_t time;
+  float value;
+  bool valid;
+  std::string label;
+
+  NOP_STRUCTURE(Sample, time, value, valid, label);
+};
+
+struct Point {
+  int x;
+  int y;
+
+  NOP_STRUCTURE(Point, x, y);
+};
+
+template <typename T>
+Status<void> Decode(const std::vector<std::uint8_t>& buffer, T* value) {
+  Deserializer<BufferReader> deserializer{buffer.data(), buffer.size()};
+  return deserializer.Read(value);
+}
+
+std::vector<Sample> MakeSamples() {
+  return {{1, 0.5f, true, "one"},
+          {2, -1.5f, false, ""},
+          {1ull << 40, 3.25f, true, "large"}};
+}
+
+}  // anonymous namespace
+
+TEST(StructureColumns, Read) {
+  const std::vector<Sample> samples = MakeSamples();
+  const std::vector<std::uint8_t> buffer = Encode(samples);
+
+  StructureColumns<Sample> columns;
+  ASSERT_TRUE(Decode(buffer, &columns));
+  ASSERT_EQ(samples.size(), columns.size());
+
+  EXPECT_EQ((std::vector<std::uint64_t>{1, 2, 1ull << 40}),
+            columns.column<0>());
+  EXPECT_EQ((std::vector<float>{0.5f, -1.5f, 3.25f}), columns.column<1>());
+  EXPECT_EQ((std::vector<bool>{true, false, true}), columns.column<2>());
+  EXPECT_EQ((std::vector<std::string>{"one", "", "large"}),
+            columns.column<3>());
+
+  // Reading replaces any previous contents.
+  ASSERT_TRUE(Decode(Encode(std::vector<Sample>{}), &columns));
+  EXPECT_TRUE(columns.empty());
+  EXPECT_TRUE(columns.column<3>().empty());
+}
+
+TEST(StructureColumns, Write) {
+  const std::vector<Sample> samples = MakeSamples();
+
+  StructureColumns<Sample> columns;
+  columns.column<0>() = {1, 2, 1ull << 40};
+  columns.column<1>() = {0.5f, -1.5f, 3.25f};
+  columns.column<2>() = {true, false, true};
+  columns.column<3>() = {"one", "", "large"};
+
+  // The encoding is identical to std::vector<T>.
+  const std::vector<std::uint8_t> expected = Encode(samples);
+  EXPECT_EQ(expected, Encode(columns));
+  EXPECT_EQ(expected.size(), nop::Encoding<decltype(columns)>::Size(columns));
+
+  std::vector<Sample> decoded;
+  ASSERT_TRUE(Decode(Encode(columns), &decoded));
+  ASSERT_EQ(samples.size(), decoded.size());
+  for (std::size_t i = 0; i < samples.size(); i++) {
+    EXPECT_EQ(samples[i].time, decoded[i].time);
+    EXPECT_EQ(samples[i].value, decoded[i].value);
+    EXPECT_EQ(samples[i].valid, decoded[i].valid);
+    EXPECT_EQ(samples[i].label, decoded[i].label);
+  }
+
+  StructureColumns<Point> points;
+  points.resize(2);
+  EXPECT_EQ(Compose(EncodingByte::Array, 2, EncodingByte::Structure, 2, 0, 0,
+                    EncodingByte::Structure, 2, 0, 0),
+            Encode(points));
+}
+
+TEST(StructureColumns, Errors) {
+  std::vector<std::uint8_t> buffer;
+  StructureColumns<Point> points;
+  Status<void> status;
+
+  // Columns of different sizes cannot be written.
+  points.column<0>() = {1, 2};
+  points.column<1>() = {1};
+  buffer.resize(16);
+  Serializer<BufferWriter> serializer{buffer.data(), buffer.size()};
+  status = serializer.Write(points);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::InvalidContainerLength, status.error());
+
+  buffer = Compose(EncodingByte::Binary, 0);
+  status = Decode(buffer, &points);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::UnexpectedEncodingType, status.error());
+
+  buffer = Compose(EncodingByte::Array, 1, EncodingByte::Array, 2, 1, 2);
+  status = Decode(buffer, &points);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::UnexpectedEncodingType, status.error());
+
+  buffer = Compose(EncodingByte::Array, 1, EncodingByte::Structure, 3, 1, 2, 3);
+  status = Decode(buffer, &points);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::InvalidMemberCount, status.error());
+
+  // An abusive element count is rejected before the columns are sized.
+  buffer = Compose(EncodingByte::Array, EncodingByte::U64,
+                   Integer<std::uint64_t>(1LLU << 60), EncodingByte::Structure,
+                   2, 1, 2);
+  status = Decode(buffer, &points);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+
+  // Truncation is detected by readers that check bounds.
+  buffer = Compose(EncodingByte::Array, 2, EncodingByte::Structure, 2, 1, 2);
+  Deserializer<PedanticBufferReader> deserializer{buffer.data(),
+                                                  buffer.size()};
+  status = deserializer.Read(&points);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+}
@@ -17,7 +17,13 @@
 #ifndef LIBNOP_TEST_TEST_UTILITIES_H_
 #define LIBNOP_TEST_TEST_UTILITIES_H_
 
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <cstdint>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -95,6 +101,56 @@ inline std::vector<std::uint8_t> Compose(Args&&... args) {
   return vector;
 }
 
+// Creates an empty temporary file named after |prefix| and removes it when
+// destroyed.
+class TempFile {
+ public:
+  explicit TempFile(const std::string& prefix) {
+    std::string path = "/tmp/" + prefix + ".XXXXXX";
+    const int fd = ::mkstemp(&path[0]);
+    EXPECT_LE(0, fd);
+    ::close(fd);
+    path_ = path;
+  }
+  ~TempFile() { ::unlink(path_.c_str()); }
+
+  const std::string& path() const { return path_; }
+
+ private:
+  std::string path_;
+
+  TempFile(const TempFile&) = delete;
+  void operator=(const TempFile&) = delete;
+};
+
+// Creates a connected pair of AF_UNIX sockets of the given type, such as
+// SOCK_STREAM or SOCK_DGRAM | SOCK_NONBLOCK, and closes them when destroyed.
+class SocketPair {
+ public:
+  explicit SocketPair(int type) {
+    EXPECT_EQ(0, ::socketpair(AF_UNIX, type, 0, fds_));
+  }
+  ~SocketPair() {
+    CloseSender();
+    ::close(fds_[1]);
+  }
+
+  int sender() const { return fds_[0]; }
+  int receiver() const { return fds_[1]; }
+
+  void CloseSender() {
+    if (fds_[0] >= 0)
+      ::close(fds_[0]);
+    fds_[0] = -1;
+  }
+
+ private:
+  int fds_[2];
+
+  SocketPair(const SocketPair&) = delete;
+  void operator=(const SocketPair&) = delete;
+};
+
 }  // namespace nop
 
 #endif  // LIBNOP_TEST_TEST_UTILITIES_H_
@@ -17,12 +17,15 @@
 #ifndef LIBNOP_TEST_TEST_WRITER_H_
 #define LIBNOP_TEST_TEST_WRITER_H_
 
+#include <gtest/gtest.h>
+
 #include <cstdint>
 #include <iterator>
 #include <vector>
 
 #include <nop/base/encoding.h>
 #include <nop/base/utility.h>
+#include <nop/serializer.h>
 #include <nop/types/file_handle.h>
 
 namespace nop {
@@ -89,6 +92,16 @@ class TestWriter {
   void operator=(const TestWriter&) = delete;
 };
 
+// Returns the encoding of |value|. Serialization errors are reported as test
+// failures.
+template <typename T>
+std::vector<std::uint8_t> Encode(const T& value) {
+  TestWriter writer;
+  Serializer<TestWriter*> serializer{&writer};
+  EXPECT_TRUE(serializer.Write(value));
+  return writer.data();
+}
+
 }  // namespace nop
 
 #endif  // LIBNOP_TEST_TEST_WRITER_H_
@@ -0,0 +1,196 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/types/file_handle.h>
+#include <nop/utility/unix_socket_reader.h>
+#include <nop/utility/unix_socket_writer.h>
+
+#include "test_utilities.h"
+
+using nop::Deserializer;
+using nop::ErrorStatus;
+using nop::FileHandle;
+using nop::Serializer;
+using nop::SocketPair;
+using nop::UniqueFileHandle;
+using nop::UnixSocketReader;
+using nop::UnixSocketWriter;
+
+namespace {
+
+struct Transfer {
+  std::string name;
+  FileHandle read_end;
+  FileHandle empty;
+  std::vector<std::uint8_t> payload;
+
+  NOP_STRUCTURE(Transfer, name, read_end, empty, payload);
+};
+
+std::size_t CountOpenFds() {
+  std::size_t count = 0;
+  DIR* directory = ::opendir("/proc/self/fd");
+  while (::readdir(directory) != nullptr)
+    count++;
+  ::closedir(directory);
+  return count;
+}
+
+}  // anonymous namespace
+
+TEST(UnixSocket, PassHandles) {
+  SocketPair sockets{SOCK_STREAM};
+  int pipe_fds[2];
+  ASSERT_EQ(0, ::pipe(pipe_fds));
+  UniqueFileHandle read_end{pipe_fds[0]};
+  UniqueFileHandle write_end{pipe_fds[1]};
+
+  Serializer<UnixSocketWriter> serializer{sockets.sender()};
+  Deserializer<UnixSocketReader> deserializer{sockets.receiver()};
+
+  // Payloads larger than the socket buffer are sent in several pieces.
+  const std::vector<std::uint8_t> payload(1024 * 1024, 0x5a);
+  std::thread sender{[&] {
+    ASSERT_TRUE(serializer.Write(
+        Transfer{"pipe", FileHandle{read_end.get()}, FileHandle{}, payload}));
+    EXPECT_EQ(1u, serializer.writer().handles().size());
+    ASSERT_TRUE(serializer.writer().Send());
+    EXPECT_EQ(0u, serializer.writer().size());
+
+    ASSERT_TRUE(serializer.Write(std::string{"second"}));
+    ASSERT_TRUE(serializer.writer().Send());
+  }};
+
+  ASSERT_TRUE(deserializer.reader().Receive());
+  EXPECT_EQ(1u, deserializer.reader().handle_count());
+  Transfer transfer;
+  ASSERT_TRUE(deserializer.Read(&transfer));
+  EXPECT_TRUE(deserializer.reader().empty());
+  EXPECT_EQ("pipe", transfer.name);
+  EXPECT_FALSE(transfer.empty);
+  EXPECT_EQ(payload, transfer.payload);
+
+  // The received descriptor refers to the same pipe as the original.
+  ASSERT_TRUE(transfer.read_end);
+  EXPECT_NE(read_end.get(), transfer.read_end.get());
+  UniqueFileHandle received{transfer.read_end.get()};
+  EXPECT_EQ(FD_CLOEXEC, ::fcntl(received.get(), F_GETFD) & FD_CLOEXEC);
+  ASSERT_EQ(1, ::write(write_end.get(), "x", 1));
+  char byte = 0;
+  ASSERT_EQ(1, ::read(received.get(), &byte, 1));
+  EXPECT_EQ('x', byte);
+
+  ASSERT_TRUE(deserializer.reader().Receive());
+  EXPECT_EQ(0u, deserializer.reader().handle_count());
+  std::string second;
+  ASSERT_TRUE(deserializer.Read(&second));
+  EXPECT_EQ("second", second);
+
+  sender.join();
+}
+
+TEST(UnixSocket, UnclaimedHandles) {
+  SocketPair sockets{SOCK_STREAM};
+  UniqueFileHandle file = UniqueFileHandle::Open("/dev/null", O_RDONLY);
+  ASSERT_TRUE(file);
+  const std::size_t baseline = CountOpenFds();
+
+  Serializer<UnixSocketWriter> serializer{sockets.sender()};
+  for (int i = 0; i < 2; i++) {
+    ASSERT_TRUE(serializer.Write(Transfer{"unclaimed", file, {}, {}}));
+    ASSERT_TRUE(serializer.writer().Send());
+  }
+
+  UniqueFileHandle claimed;
+  {
+    UnixSocketReader reader{sockets.receiver()};
+    ASSERT_TRUE(reader.Receive());
+    ASSERT_EQ(1u, reader.handle_count());
+    EXPECT_EQ(baseline + 1, CountOpenFds());
+
+    auto status = reader.GetHandle<FileHandle>(0);
+    ASSERT_TRUE(status);
+    claimed = UniqueFileHandle{status.get().get()};
+
+    // A descriptor can only be claimed once.
+    status = reader.GetHandle<FileHandle>(0);
+    ASSERT_FALSE(status);
+    EXPECT_EQ(ErrorStatus::InvalidHandleReference, status.error());
+    status = reader.GetHandle<FileHandle>(1);
+    ASSERT_FALSE(status);
+    EXPECT_EQ(ErrorStatus::InvalidHandleReference, status.error());
+
+    // Descriptors that are not claimed are closed by the next Receive() or
+    // when the reader is destroyed.
+    ASSERT_TRUE(reader.Receive());
+    EXPECT_EQ(baseline + 2, CountOpenFds());
+  }
+  EXPECT_EQ(baseline + 1, CountOpenFds());
+
+  claimed.close();
+  EXPECT_EQ(baseline, CountOpenFds());
+}
+
+TEST(UnixSocket, Errors) {
+  SocketPair sockets{SOCK_STREAM};
+
+  // Too many handles in one message.
+  UniqueFileHandle file = UniqueFileHandle::Open("/dev/null", O_RDONLY);
+  UnixSocketWriter writer{sockets.sender()};
+  for (std::size_t i = 0; i < UnixSocketWriter::kMaxHandles; i++)
+    ASSERT_TRUE(writer.PushHandle(FileHandle{file.get()}));
+  auto push_status = writer.PushHandle(FileHandle{file.get()});
+  ASSERT_FALSE(push_status);
+  EXPECT_EQ(ErrorStatus::WriteLimitReached, push_status.error());
+  writer.clear();
+
+  // Messages larger than the limit of the reader.
+  ASSERT_TRUE(writer.Skip(100));
+  ASSERT_TRUE(writer.Send());
+  UnixSocketReader reader{sockets.receiver(), 10};
+  auto status = reader.Receive();
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ProtocolError, status.error());
+
+  // Reads past the end of the message.
+  SocketPair other_sockets{SOCK_STREAM};
+  UnixSocketWriter other_writer{other_sockets.sender()};
+  UnixSocketReader other_reader{other_sockets.receiver()};
+  ASSERT_TRUE(other_writer.Skip(2));
+  ASSERT_TRUE(other_writer.Send());
+  std::uint8_t bytes[3];
+  ASSERT_TRUE(other_reader.Receive());
+  status = other_reader.Read(bytes, bytes + 3);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+
+  // The peer closed the socket.
+  other_sockets.CloseSender();
+  status = other_reader.Receive();
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+}
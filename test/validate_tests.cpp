@@ -0,0 +1,260 @@
+// Copyright 2019 The Native Object Protocols Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/table.h>
+#include <nop/types/lazy.h>
+#include <nop/types/optional.h>
+#include <nop/types/raw_value.h>
+#include <nop/types/variant.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/pedantic_buffer_reader.h>
+#include <nop/utility/trusted_buffer_reader.h>
+#include <nop/validate.h>
+
+#include "test_reader.h"
+#include "test_utilities.h"
+#include "test_writer.h"
+
+using nop::BufferReader;
+using nop::Compose;
+using nop::Deserializer;
+using nop::Encode;
+using nop::Encoding;
+using nop::EncodingByte;
+using nop::Entry;
+using nop::ErrorStatus;
+using nop::IsTrustedReader;
+using nop::Lazy;
+using nop::Optional;
+using nop::PedanticBufferReader;
+using nop::RawValue;
+using nop::Status;
+using nop::TestReader;
+using nop::TrustedBufferReader;
+using nop::Validate;
+using nop::Variant;
+
+namespace {
+
+enum class Kind : std::uint8_t { Foo, Bar };
+
+struct Inner {
+  int a;
+  std::string b;
+
+  NOP_STRUCTURE(Inner, a, b);
+};
+
+struct Record {
+  Entry<std::string, 0> name;
+  Entry<std::vector<int>, 1> values;
+
+  NOP_TABLE_NS("Record", Record, name, values);
+};
+
+struct OtherRecord {
+  Entry<std::string, 0> name;
+
+  NOP_TABLE_NS("OtherRecord", OtherRecord, name);
+};
+
+struct Buffer {
+  std::array<int, 4> data;
+  std::size_t count;
+
+  NOP_STRUCTURE(Buffer, (data, count));
+};
+
+struct VectorBuffer {
+  std::vector<int> data;
+
+  NOP_STRUCTURE(VectorBuffer, data);
+};
+
+struct Message {
+  std::uint32_t id;
+  Kind kind;
+  std::string label;
+  std::vector<std::uint16_t> samples;
+  std::vector<Inner> inners;
+  std::map<std::string, int> counts;
+  std::tuple<int, float> pair;
+  std::array<std::string, 2> names;
+  Variant<int, std::string> choice;
+  Optional<Inner> extra;
+  Record record;
+  Buffer buffer;
+  Lazy<std::vector<std::string>> lazy;
+  RawValue raw;
+
+  NOP_STRUCTURE(Message, id, kind, label, samples, inners, counts, pair, names,
+                choice, extra, record, buffer, lazy, raw);
+};
+
+Message MakeMessage() {
+  Message message;
+  message.id = 100;
+  message.kind = Kind::Bar;
+  message.label = "label";
+  message.samples = {1, 2, 3, 1000};
+  message.inners = {{1, "one"}, {-2, "two"}};
+  message.counts = {{"foo", 1}, {"bar", 300}};
+  message.pair = std::make_tuple(10, 1.5f);
+  message.names = {{"first", "second"}};
+  message.choice = std::string{"choice"};
+  message.extra = Inner{3, "three"};
+  message.record.name = "record";
+  message.record.values = std::vector<int>{4, 5, 6};
+  message.buffer.data = {{7, 8, 9, 0}};
+  message.buffer.count = 3;
+  message.lazy = std::vector<std::string>{"lazy", "values"};
+  message.raw = RawValue{Encode(std::string{"raw"})};
+  return message;
+}
+
+}  // anonymous namespace
+
+TEST(Validate, Traits) {
+  EXPECT_TRUE(IsTrustedReader<TrustedBufferReader>::value);
+  EXPECT_FALSE(IsTrustedReader<BufferReader>::value);
+  EXPECT_FALSE(IsTrustedReader<PedanticBufferReader>::value);
+  EXPECT_FALSE(IsTrustedReader<TestReader>::value);
+}
+
+TEST(Validate, Message) {
+  const std::vector<std::uint8_t> buffer = Encode(MakeMessage());
+
+  EXPECT_TRUE(Validate<Message>(buffer.data(), buffer.size()));
+
+  // Every truncation of the encoding is detected.
+  for (std::size_t size = 0; size < buffer.size(); size++) {
+    auto status = Validate<Message>(buffer.data(), size);
+    ASSERT_FALSE(status) << "size=" << size;
+    EXPECT_EQ(ErrorStatus::ReadLimitReached, status.error());
+  }
+
+  // Validation through a Deserializer advances past the value.
+  Deserializer<PedanticBufferReader> deserializer{buffer.data(),
+                                                  buffer.size()};
+  EXPECT_TRUE(deserializer.Validate<Message>());
+  EXPECT_TRUE(deserializer.reader().empty());
+
+  // Readers without direct buffer access are also supported.
+  TestReader reader;
+  reader.Set(buffer);
+  EXPECT_TRUE(Encoding<Message>::Validate(&reader));
+}
+
+TEST(Validate, Errors) {
+  std::vector<std::uint8_t> buffer;
+  Status<void> status;
+
+  buffer = Compose(EncodingByte::Array, 0);
+  status = Validate<std::string>(buffer.data(), buffer.size());
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::UnexpectedEncodingType, status.error());
+
+  buffer = Compose(EncodingByte::Structure, 3, 1, EncodingByte::String, 0, 2);
+  status = Validate<Inner>(buffer.data(), buffer.size());
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::InvalidMemberCount, status.error());
+
+  buffer = Compose(EncodingByte::Structure, 2, 1, EncodingByte::Binary, 0);
+  status = Validate<Inner>(buffer.data(), buffer.size());
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::UnexpectedEncodingType, status.error());
+
+  buffer = Compose(EncodingByte::Variant, 2, 0);
+  status = Validate<Variant<int, std::string>>(buffer.data(), buffer.size());
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::UnexpectedVariantType, status.error());
+
+  buffer = Compose(EncodingByte::Variant, -1, EncodingByte::Nil);
+  status = Validate<Variant<int, std::string>>(buffer.data(), buffer.size());
+  EXPECT_TRUE(status);
+
+  buffer = Compose(EncodingByte::Binary, 3, 1, 2, 3);
+  status = Validate<std::vector<std::uint16_t>>(buffer.data(), buffer.size());
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::InvalidContainerLength, status.error());
+
+  buffer = Compose(EncodingByte::Array, 1, EncodingByte::String, 0);
+  status = Validate<std::array<std::string, 2>>(buffer.data(), buffer.size());
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::InvalidContainerLength, status.error());
+
+  buffer = Encode(VectorBuffer{{1, 2, 3, 4, 5}});
+  status = Validate<Buffer>(buffer.data(), buffer.size());
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::InvalidContainerLength, status.error());
+
+  Record record;
+  record.name = "name";
+  buffer = Encode(record);
+  status = Validate<OtherRecord>(buffer.data(), buffer.size());
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::InvalidTableHash, status.error());
+
+  // Repeat the only entry to produce a duplicate. The entry count follows the
+  // prefix and the U64 table hash.
+  const std::size_t kCountOffset = 10;
+  ASSERT_EQ(1u, buffer[kCountOffset]);
+  buffer[kCountOffset] = 2;
+  const std::vector<std::uint8_t> entry(buffer.begin() + kCountOffset + 1,
+                                        buffer.end());
+  buffer.insert(buffer.end(), entry.begin(), entry.end());
+  status = Validate<Record>(buffer.data(), buffer.size());
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::DuplicateTableEntry, status.error());
+
+  // The errors are the same as those reported by deserialization.
+  Deserializer<BufferReader> deserializer{buffer.data(), buffer.size()};
+  status = deserializer.Read(&record);
+  ASSERT_FALSE(status);
+  EXPECT_EQ(ErrorStatus::DuplicateTableEntry, status.error());
+}
+
+TEST(Validate, TrustedRead) {
+  const std::vector<std::uint8_t> buffer = Encode(MakeMessage());
+  ASSERT_TRUE(Validate<Message>(buffer.data(), buffer.size()));
+
+  Message message;
+  Deserializer<TrustedBufferReader> deserializer{buffer.data(), buffer.size()};
+  ASSERT_TRUE(deserializer.Read(&message));
+  EXPECT_TRUE(deserializer.reader().empty());
+
+  EXPECT_EQ(100u, message.id);
+  EXPECT_EQ(Kind::Bar, message.kind);
+  EXPECT_EQ("label", message.label);
+  EXPECT_EQ(3u, message.buffer.count);
+  ASSERT_TRUE(message.record.name);
+  EXPECT_EQ("record", message.record.name.get());
+
+  // Lazy values borrow from the trusted reader like any contiguous reader.
+  EXPECT_TRUE(message.lazy.is_encoded());
+
+  // The decoded message encodes to the same bytes.
+  EXPECT_EQ(buffer, Encode(message));
+}
@@ -133,6 +133,18 @@ std::size_t InstrumentType<T>::move_assignment_count_ = 0;
 template <typename T>
 std::size_t InstrumentType<T>::copy_assignment_count_ = 0;
 
+template <typename T>
+double Double(const T& value) {
+  return static_cast<double>(value);
+}
+inline double Double(const std::string&) { return 0.0; }
+inline double Double(const InstrumentType<int>& value) { return value.get(); }
+inline double Double(EmptyVariant) { return 0.0; }
+
+template <typename T>
+void Clear(T&&) {}
+inline void Clear(std::string& value) { value.clear(); }
+
 }  // anonymous namespace
 
 TEST(Variant, Assignment) {
@@ -874,6 +886,88 @@ TEST(Variant, Visit) {
   }
 }
 
+TEST(Variant, VisitTable) {
+  // Enough element types to exceed detail::kVisitTableThreshold.
+  using VariantType =
+      Variant<char, short, int, long, float, double, bool, std::string,
+              std::uint8_t, std::uint16_t, InstrumentType<int>>;
+  static_assert(11 > nop::detail::kVisitTableThreshold, "");
+
+  {
+    VariantType v;
+    EXPECT_EQ(-1, v.Visit([](const auto& value) {
+      return std::is_same<std::decay_t<decltype(value)>, EmptyVariant>::value
+                 ? -1
+                 : 0;
+    }));
+  }
+
+  {
+    VariantType v(std::string("foo"));
+    ASSERT_TRUE(v.is<std::string>());
+    EXPECT_EQ(7, v.index());
+
+    std::size_t size = 0;
+    v.Visit([&size](const auto& value) { size = sizeof(value); });
+    EXPECT_EQ(sizeof(std::string), size);
+
+    v.Visit([](auto&& value) { Clear(value); });
+    ASSERT_TRUE(v.is<std::string>());
+    EXPECT_TRUE(std::get<std::string>(v).empty());
+  }
+
+  {
+    const VariantType v(2.0);
+    ASSERT_TRUE(v.is<double>());
+
+    double result = 0.0;
+    v.Visit([&result](const auto& value) { result = Double(value); });
+    EXPECT_EQ(2.0, result);
+  }
+
+  {
+    InstrumentType<int>::clear();
+
+    VariantType v(InstrumentType<int>(10));
+    EXPECT_EQ(2u, InstrumentType<int>::constructor_count());
+    EXPECT_EQ(1u, InstrumentType<int>::destructor_count());
+
+    v = 10;
+    ASSERT_TRUE(v.is<int>());
+    EXPECT_EQ(2u, InstrumentType<int>::destructor_count());
+  }
+}
+
+TEST(Variant, BecomeIndex) {
+  {
+    Variant<int, bool, std::string> v;
+
+    v.Become<0>() = 10;
+    ASSERT_TRUE(v.is<int>());
+    EXPECT_EQ(10, std::get<int>(v));
+
+    v.Become<2>("foo");
+    ASSERT_TRUE(v.is<std::string>());
+    EXPECT_EQ("foo", std::get<std::string>(v));
+
+    // Becoming the active type keeps the existing element.
+    EXPECT_EQ("foo", v.Become<2>("bar"));
+  }
+
+  {
+    InstrumentType<int>::clear();
+
+    Variant<int, InstrumentType<int>> v;
+    v.Become<1>(10);
+    v.Become<1>(20);
+    EXPECT_EQ(1u, InstrumentType<int>::constructor_count());
+    EXPECT_EQ(10, std::get<1>(v).get());
+
+    v.Become<0>();
+    EXPECT_EQ(1u, InstrumentType<int>::destructor_count());
+  }
+}
+
 TEST(Variant, Become) {
   {
     Variant<int, bool, float> v;